@@ -19,23 +19,38 @@ RFIDCriterion::RFIDCriterion(double weight)
 
 RFIDCriterion::~RFIDCriterion() {}
 
-double RFIDCriterion::evaluate(Pose &p, dummy::Map *map, RFID_tools *rfid_tools,
-                               double *batteryTime) {
+double RFIDCriterion::computeEvaluation(Pose &p, dummy::Map *map,
+                                        RFID_tools *rfid_tools,
+                                        double *batteryTime) {
+
+  double RFIDInfoGain = 0.0;
 
   // 1) Use a uniform ellipse (DEPRECATED: identical to infoGain)
-  // this->RFIDInfoGain = evaluateUniformEllipse(p, map);
+  // RFIDInfoGain = evaluateUniformEllipse(p, map);
 
   // 2) Sum all the likelihood around the cells
-  // this->RFIDInfoGain = evaluateSumOverBelief(p, map, rfid_tools);
+  // RFIDInfoGain = evaluateSumOverBelief(p, map, rfid_tools);
 
   // 3) Calculate entropy around the cell
-  this->RFIDInfoGain = evaluateEntropyOverBelief(p, map, rfid_tools);
+  RFIDInfoGain = evaluateEntropyOverBelief(p, map, rfid_tools);
 
   // 4) Calculate the KL divergence between prior and posterior distributions
-  // this->RFIDInfoGain = evaluateKLDivergence(p, map, rfid_tools);
+  // RFIDInfoGain = evaluateKLDivergence(p, map, rfid_tools);
 
-  Criterion::insertEvaluation(p, this->RFIDInfoGain);
-  return this->RFIDInfoGain;
+  return RFIDInfoGain;
+}
+
+void RFIDCriterion::computeBounds(Pose &p, dummy::Map *map,
+                                  RFID_tools *rfid_tools, double *batteryTime,
+                                  double &lower, double &upper) {
+  // bounds evaluateEntropyOverBelief, with some room for its float sum
+  double entropy_bound = 0.0;
+  for (int tag_id = 0; tag_id < rfid_tools->tags_coord.size(); tag_id++) {
+    entropy_bound +=
+        rfid_tools->rm->getTotalEntropyEllipseBound(p, p.getRange(), -1.0, tag_id);
+  }
+  lower = 0.0;
+  upper = entropy_bound * (1 + 1e-5) + 1e-5;
 }
 
 double RFIDCriterion::evaluateUniformEllipse(Pose &p, dummy::Map *map) {
@@ -89,17 +104,21 @@ double RFIDCriterion::evaluateEntropyOverBelief(Pose &p, dummy::Map *map,
 double RFIDCriterion::evaluateKLDivergence(Pose &p, dummy::Map *map,
                                            RFID_tools *rfid_tools) {
   float RFIDInfoGain = 0.0;
-  Utilities utils;
   float KL_div_cell = 0.0;
   int buffer_size = 2;
+  RadarModel::BeliefOverlay overlay;
 
   for (int tag_id = 0; tag_id < rfid_tools->tags_coord.size(); tag_id++) {
-    // Calculate the POSTERIOR distribution over the RFID tag position and save
-    // in the "KL" layer of the map
-    utils.computePosteriorBeliefSingleLayer(map, &p, rfid_tools, tag_id, buffer_size);
-    KL_div_cell =
-        rfid_tools->rm->getTotalKL(p.getX(), p.getY(), p.getOrientation(),
-                                  buffer_size, buffer_size, tag_id);
+    // Calculate the POSTERIOR distribution over the RFID tag position in an
+    // overlay, leaving the belief layers untouched
+    double rxPower = rfid_tools->rm->received_power_friis_with_obstacles(
+        p.getX(), p.getY(), p.getOrientation() * M_PI / 180.0,
+        rfid_tools->tags_coord[tag_id].first,
+        rfid_tools->tags_coord[tag_id].second, 0, rfid_tools->freq);
+    rfid_tools->rm->addHypotheticalMeasurement(
+        p.getX(), p.getY(), p.getOrientation(), rxPower, rfid_tools->freq,
+        tag_id, buffer_size, &overlay);
+    KL_div_cell = rfid_tools->rm->getTotalKL(overlay);
     RFIDInfoGain += KL_div_cell;
   }
   return RFIDInfoGain;
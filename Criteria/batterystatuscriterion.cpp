@@ -18,6 +18,7 @@
 #include "Criteria/batterystatuscriterion.h"
 #include "Criteria/criteriaName.h"
 #include <iostream>
+#include <limits>
 
 
 
@@ -33,23 +34,31 @@ BatteryStatusCriterion::~BatteryStatusCriterion()
 
 }
 
-double BatteryStatusCriterion::evaluate( Pose &p, dummy::Map *map, RFID_tools *rfid_toolss, double *batteryTime)
+double BatteryStatusCriterion::computeEvaluation( Pose &p, dummy::Map *map, RFID_tools *rfid_toolss, double *batteryTime)
 {
     Pose robotPosition = map->getRobotPosition();
     //double distance = robotPosition.getDistance(p);
     string path = this->astar.pathFind(robotPosition.getX(),robotPosition.getY(),p.getX(),p.getY(), map);
-    distance = this->astar.lengthPath(path);
-    numOfTurning = this->astar.getNumberOfTurning ( path );
-    translTime = distance / TRANSL_SPEED;
-    rotTime = numOfTurning / ROT_SPEED;
-    timeRequired = translTime + rotTime;
-    remainingBattery = *batteryTime - timeRequired;
+    double distance = this->astar.lengthPath(path);
+    double numOfTurning = this->astar.getNumberOfTurning ( path );
+    double translTime = distance / TRANSL_SPEED;
+    double rotTime = numOfTurning / ROT_SPEED;
+    double timeRequired = translTime + rotTime;
+    double remainingBattery = *batteryTime - timeRequired;
     // std::cout << "Distance: " << distance << endl;
     //cout << "alive after calling a*" << endl;
-    Criterion::insertEvaluation(p, remainingBattery);
     return remainingBattery;
 }
 
+// the remaining battery is highest with the shortest path and no turning
+void BatteryStatusCriterion::computeBounds( Pose &p, dummy::Map *map, RFID_tools *rfid_toolss, double *batteryTime, double &lower, double &upper)
+{
+    Pose robotPosition = map->getRobotPosition();
+    double distance = this->astar.lengthLowerBound(robotPosition.getX(),robotPosition.getY(),p.getX(),p.getY());
+    lower = -std::numeric_limits<double>::infinity();
+    upper = *batteryTime - distance / TRANSL_SPEED;
+}
+
 /*
 void BatteryStatusCriterion::insertEvaluation(Pose& p, double value)
 {
@@ -16,7 +16,7 @@
  */
 
 #include "Criteria/criterion.h"
-#include "evaluationrecords.h"
+#include <limits>
 
 Criterion::Criterion() {}
 
@@ -26,15 +26,31 @@ Criterion::Criterion(string name, double weight, bool highGood)
 
 Criterion::~Criterion() {}
 
+double Criterion::evaluate(Pose &p, dummy::Map *map, RFID_tools *rfid_tools,
+                           double *batteryTime) {
+  double value = computeEvaluation(p, map, rfid_tools, batteryTime);
+  insertEvaluation(p, value);
+  return value;
+}
+
+void Criterion::computeBounds(Pose &p, dummy::Map *map, RFID_tools *rfid_tools,
+                              double *batteryTime, double &lower,
+                              double &upper) {
+  lower = -std::numeric_limits<double>::infinity();
+  upper = std::numeric_limits<double>::infinity();
+}
+
 void Criterion::insertEvaluation(Pose &p, double value) {
   //    if(evaluation.contains(point))
   //        lprint << "#repeated frontier!!!" << endl;
 
-  // string pose = getEncodedKey(p);
-  EvaluationRecords *record = new EvaluationRecords();
-  string pose = record->getEncodedKey(p);
-  // std::cout << pose << "," << value << std::endl;
-  evaluation.emplace(pose, value);
+  // std::cout << PoseKey(p).toString() << "," << value << std::endl;
+  if (indices.emplace(PoseKey(p), (int)evaluation.size()).second)
+    evaluation.push_back(value);
+  updateExtremes(value);
+}
+
+void Criterion::updateExtremes(double value) {
   // cout << maxValue << "," << minValue << endl;
   if (value >= maxValue) {
     // cout << "max: " << maxValue << endl;
@@ -44,9 +60,6 @@ void Criterion::insertEvaluation(Pose &p, double value) {
     minValue = value;
     // cout << "min: " << minValue << endl;
   }
-
-  delete record;
-  // pose.clear();
 }
 
 void Criterion::clean() {
@@ -55,6 +68,7 @@ void Criterion::clean() {
   //        delete it.key();
   //    }
   evaluation.clear();
+  indices.clear();
 }
 
 void Criterion::normalize() {
@@ -64,65 +78,45 @@ void Criterion::normalize() {
     normalizeLowGood();
 }
 
+void Criterion::normalize(double *values, int size) {
+  for (int i = 0; i < size; i++) {
+    updateExtremes(values[i]);
+  }
+  if (highGood) {
+    for (int i = 0; i < size; i++) {
+      values[i] = (values[i] - minValue) / (maxValue - minValue);
+    }
+  } else {
+    for (int i = 0; i < size; i++) {
+      values[i] = (maxValue - values[i]) / (maxValue - minValue);
+    }
+  }
+}
+
 void Criterion::normalizeHighGood() {
-  unordered_map<string, double> temp;
-  for (unordered_map<string, double>::iterator it = evaluation.begin();
+  for (vector<double>::iterator it = evaluation.begin();
        it != evaluation.end(); it++) {
-    pair<string, double> p = *it;
-    double value = p.second;
-    value = (value - minValue) / (maxValue - minValue);
-    temp.emplace(p.first, value);
+    *it = (*it - minValue) / (maxValue - minValue);
   }
-  evaluation = temp;
 }
 
 void Criterion::normalizeLowGood() {
-  unordered_map<string, double> temp;
-  for (unordered_map<string, double>::iterator it = evaluation.begin();
+  for (vector<double>::iterator it = evaluation.begin();
        it != evaluation.end(); it++) {
-    pair<string, double> p = *it;
-    double value = p.second;
-    value = (maxValue - value) / (maxValue - minValue);
-    temp.emplace(p.first, value);
+    *it = (maxValue - *it) / (maxValue - minValue);
   }
-  evaluation = temp;
 }
 
 double Criterion::getEvaluation(Pose &p) const {
-
-  // string pose = getEncodedKey(p);
-  EvaluationRecords *record = new EvaluationRecords();
-  string pose = record->getEncodedKey(p);
-  double value = evaluation.at(pose);
-  delete record;
-  return value;
+  return evaluation[indices.at(PoseKey(p))];
 }
 
 string Criterion::getName() { return name; }
 
 double Criterion::getWeight() { return weight; }
 
+bool Criterion::isHighGood() const { return highGood; }
+
 void Criterion::setName(string name) { this->name = name; }
 
 void Criterion::setWeight(double weight) { this->weight = weight; }
-
-string Criterion::getEncodedKey(Pose &p) {
-
-  string key = to_string(p.getX()) + "/" + to_string(p.getY()) + "/" +
-               to_string(p.getOrientation()) + "/" + to_string(p.getRange()) +
-               "/" + to_string(p.getFOV());
-
-  /*
-  string key =  to_string(p.getX());
-  key.append( "/");
-  key.append( to_string( p.getY()));
-  key.append( "/");
-  key.append( to_string(p.getOrientation())) ;
-  key.append( "/");
-  key.append(to_string(p.getRange()));
-  key.append( "/");
-  key.append(to_string(p.getFOV()));
-  */
-
-  return key;
-}
@@ -14,7 +14,7 @@ InformationGainCriterion::~InformationGainCriterion()
 {
 }
 
-double InformationGainCriterion::evaluate(Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime)
+double InformationGainCriterion::computeEvaluation(Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime)
 {
     long px = p.getX();
     long py = p.getY();
@@ -187,7 +187,6 @@ double InformationGainCriterion::evaluate(Pose &p, dummy::Map *map, RFID_tools *
     } else {
 	cout<< "No other candidate position that guarantee information gain" << endl;
     }*/
-    Criterion::insertEvaluation(p,unExploredMap);
     return unExploredMap;
 }
 
@@ -33,7 +33,7 @@ SensingTimeCriterion::~SensingTimeCriterion()
 
 }
 
-double SensingTimeCriterion::SensingTimeCriterion::evaluate(Pose &p,dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime)
+double SensingTimeCriterion::computeEvaluation(Pose &p,dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime)
 {
   NewRay ray;
   double sensingTime;
@@ -89,7 +89,6 @@ double SensingTimeCriterion::SensingTimeCriterion::evaluate(Pose &p,dummy::Map *
 //      double expected_time = -7.2847174296449998e-006*degreeAngle*degreeAngle*degreeAngle + 2.2131847908245512e-003*degreeAngle*degreeAngle + 1.5987873410233613e-001*degreeAngle + 10;
   //cout << "x: " << p.getY() << " y: " << p.getX() << " orientation: " << p.getOrientation() << " angle: " << angle << endl;
 
-  Criterion::insertEvaluation(p,angle);
   return angle;
 }
 
@@ -18,6 +18,7 @@
 #include "Criteria/traveldistancecriterion.h"
 #include "Criteria/criteriaName.h"
 #include <iostream>
+#include <limits>
 
 
 
@@ -33,19 +34,26 @@ TravelDistanceCriterion::~TravelDistanceCriterion()
 
 }
 
-double TravelDistanceCriterion::evaluate( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime)
+double TravelDistanceCriterion::computeEvaluation( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime)
 {
     Pose robotPosition = map->getRobotPosition();
     //double distance = robotPosition.getDistance(p);
     string path = this->astar.pathFind(robotPosition.getX(),robotPosition.getY(),p.getX(),p.getY(), map);
-    distance = astar.lengthPath(path);
+    double distance = astar.lengthPath(path);
     // std::cout << "Distance: " << distance << endl;
     //cout << "alive after calling a*" << endl;
-    Criterion::insertEvaluation(p, distance);
-
     return distance;
 }
 
+// An unreachable pose gets an empty path (length 0) from pathFind, below the
+// lower bound: pruning may drop it, which is fine as the robot can't go there
+void TravelDistanceCriterion::computeBounds( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime, double &lower, double &upper)
+{
+    Pose robotPosition = map->getRobotPosition();
+    lower = this->astar.lengthLowerBound(robotPosition.getX(),robotPosition.getY(),p.getX(),p.getY());
+    upper = std::numeric_limits<double>::infinity();
+}
+
 /*
 void TravelDistanceCriterion::insertEvaluation(Pose& p, double value)
 {
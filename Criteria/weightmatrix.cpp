@@ -1,24 +1,25 @@
 #include "Criteria/weightmatrix.h"
 #include <iostream>
 #include <sstream>
+#include <bitset>
+#include <stdexcept>
 #include "Criteria/criteriaName.h"
 
 using namespace std;
 /* mapping contains the criterion's name and his encoding
- * weights is a list (vector - for pratical purpose) of <encoding, weight> pairs */
+ * capacities is a flat table of 2^numOfCriteria weights indexed by the bitmask of the combination */
 WeightMatrix::WeightMatrix(int numOfCriteria):
     //mapping(new unordered_map<string, string>()),
     //activeCriteria(new vector<pair<string, bool>>()),
-    weights(new vector<unordered_map<string, double> *>()),
+    capacities(1u << numOfCriteria, 0.0),
+    knownCapacities(1u << numOfCriteria, false),
+    resolvedCapacities(1u << numOfCriteria, 0.0),
+    numOfCriteria(numOfCriteria),
     lastInsertedCriteria(64),
     //mutex(new mutex()),
     numOfActiveCriteria(0)
 {
-
-    //Create a row in the weight matrix for each weight cardinality
-    for(int i=0; i<numOfCriteria-1; i++){
-        weights->push_back(new unordered_map<string, double>());
-    }
+    resolveCapacities();
 }
 
 
@@ -29,11 +30,6 @@ WeightMatrix::~WeightMatrix()
 {
     //delete mutex;
 
-    for(int i=weights->size()-1; i>=0; i--){
-	auto it = weights->begin();
-        weights->erase(it);
-    }
-    delete weights;
     //activeCriteria->clear();
     //delete activeCriteria;
    // mapping->clear();
@@ -66,12 +62,15 @@ void WeightMatrix::insertSingleCriterion(string name, double weight, bool active
     activeCriteria.push_back(pairActive);
     if(active)
 	    numOfActiveCriteria++;
-    //insert the weight of the single criterion in the first row of the weight matrix
-    if (weights->size() > 0)
-//	    std::pair<string,double> pair(code,weight);
-	    (weights->at(0))->emplace(code,weight);
-
-	//weights->push_front(code,weight);
+    //insert the weight of the single criterion in the capacity table
+    if (numOfCriteria > 1){
+        unsigned int mask = computeEncodingMask(code);
+        if (mask != 0 && !knownCapacities[mask]){
+            capacities[mask] = weight;
+            knownCapacities[mask] = true;
+        }
+    }
+    resolveCapacities();
     //mutex.unlock();
 }
 
@@ -99,6 +98,7 @@ void WeightMatrix::changeCriteriaActivation(const string &name, bool active)
         numOfActiveCriteria++;
     else  //if the state is negative, decrease the number of active criteria.
         numOfActiveCriteria--;
+    resolveCapacities();
     //mutex.unlock();
 }
 
@@ -106,29 +106,46 @@ void WeightMatrix::changeCriteriaActivation(const string &name, bool active)
  */
 double WeightMatrix::getWeight(list<string> criteriaNames)
 {
-    string enc = computeNamesEncoding(criteriaNames);
-    double w = getWeight(enc);
-    // cout << "[weightmatrix.cpp@getWeight]Encoding: " << enc << ", Weight: " << w << endl;
-    if (w == 0){
-        //no encoding saved. I must compute the weight by summing
-        //up every single weight.
-
-        for(int i=0; i<enc.length(); i++){
-            string e(to_string(enc.at(i)));
-            w += getWeight(e);
+    unsigned int mask = 0;
+    for(list<string>::iterator it = criteriaNames.begin(); it != criteriaNames.end(); ++it){
+        mask |= getCriterionMask(*it);
+    }
+    // cout << "[weightmatrix.cpp@getWeight]Mask: " << mask << ", Weight: " << getCapacity(mask) << endl;
+    return getCapacity(mask);
+}
+
+/* fill resolvedCapacities applying to every combination the rules of getWeight(list<string>)
+ */
+void WeightMatrix::resolveCapacities()
+{
+    for(unsigned int mask = 0; mask < resolvedCapacities.size(); mask++){
+        int card = bitset<32>(mask).count();
+        double w;
+        if(card >= numOfActiveCriteria)
+            w = 1;
+        else if(card <= 0)
+            w = 0;
+        else
+            w = knownCapacities[mask] ? capacities[mask] : 0;
+        if (w == 0){
+            //no encoding saved. I must compute the weight by summing
+            //up every single weight.
+            for(int i=0; i<numOfCriteria; i++){
+                unsigned int bit = 1u << i;
+                if((mask & bit) && knownCapacities[bit])
+                    w += capacities[bit];
+            }
         }
+        if(w>1) //weights must belong to [0,1].
+            w = 1;
+        resolvedCapacities[mask] = w;
     }
-    if(w>1) //weights must belong to [0,1].
-        w = 1;
-    // cout << "[weightmatrix.cpp@getWeight]Encoding: " << enc << ", Weight: " << w << endl;
-    return w;
 }
 
 /* given an encoding of a criterion, return the weight associated to that criterion
  */
 double WeightMatrix::getWeight(const string& encoding)
 {
-    // cout << "weights length = " << weights->size() << endl;
     int card = encoding.length();
     //mutex.lock();
     int numActiveCrit = numOfActiveCriteria;
@@ -138,12 +155,44 @@ double WeightMatrix::getWeight(const string& encoding)
         return 1;
     if(card <= 0)
         return 0;
-    //mutex.lock();
-    // like a charm
-    double toRet = (weights->at(card - 1))->at(encoding);
-    //cout << toRet <<endl;
-    //mutex.unlock();
-    return toRet;
+    return getWeight(computeEncodingMask(encoding));
+}
+
+/* given the bitmask of a combination, return the weight inserted for it
+ */
+double WeightMatrix::getWeight(unsigned int mask)
+{
+    int card = bitset<32>(mask).count();
+    if(card >= numOfActiveCriteria)
+        return 1;
+    if(card <= 0)
+        return 0;
+    if(mask >= knownCapacities.size() || !knownCapacities[mask])
+        throw out_of_range("WeightMatrix: no weight for the combination");
+    return capacities[mask];
+}
+
+/* return the bit of the criterion in the capacity table, 0 if it is unknown
+ */
+unsigned int WeightMatrix::getCriterionMask(const string &name)
+{
+    unordered_map<string, string>::const_iterator it = mapping.find(name);
+    if(it == mapping.end())
+        return 0;
+    return computeEncodingMask(it->second);
+}
+
+/* every character of the encoding sets the bit of that criterion ('A' -> bit 0, 'B' -> bit 1, ...)
+ */
+unsigned int WeightMatrix::computeEncodingMask(const string &encoding) const
+{
+    unsigned int mask = 0;
+    for(int i=0; i<encoding.length(); i++){
+        int bit = encoding.at(i) - 'A';
+        if(bit >= 0 && bit < numOfCriteria)
+            mask |= 1u << bit;
+    }
+    return mask;
 }
 
 int WeightMatrix::getNumOfActiveCriteria()
@@ -220,7 +269,12 @@ void WeightMatrix::insertCombinationWeight(const string &encoding, double weight
         return;
     // cout << "encoding: " << encoding << ",weight: " << weight << endl;  // correct weights here!!!
     //mutex.lock();
-    (weights->at(card-1))->emplace(encoding,weight);
+    unsigned int mask = computeEncodingMask(encoding);
+    if(!knownCapacities[mask]){
+        capacities[mask] = weight;
+        knownCapacities[mask] = true;
+    }
+    resolveCapacities();
     //mutex.unlock();
 }
 
@@ -35,10 +35,14 @@ string Astar::pathFind( const int & xStart, const int & yStart, const int & xFin
     const int n = originalMap->getPathPlanningNumRows();
 
 
-    int map[n][m];
-    int closed_nodes_map[n][m]; // map of closed (tried-out) nodes
-    int open_nodes_map[n][m]; // map of open (not-yet-tried) nodes
-    int dir_map[n][m]; // map of directions
+    // the node maps are kept per thread and reused between searches, so that
+    // concurrent searches don't share any state. Cell (x,y) is at x*m+y.
+    static thread_local vector<int> closed_nodes_map; // map of closed (tried-out) nodes
+    static thread_local vector<int> open_nodes_map; // map of open (not-yet-tried) nodes
+    static thread_local vector<int> dir_map; // map of directions
+    closed_nodes_map.resize(n * m);
+    open_nodes_map.resize(n * m);
+    dir_map.resize(n * m);
     // create map
 //    for(int y=0;y<m;y++)
 //    {
@@ -49,12 +53,12 @@ string Astar::pathFind( const int & xStart, const int & yStart, const int & xFin
 
 
     //cout << "alive in pathfind"<< endl;
-    static priority_queue<Node> pq[2]; // list of open (not-yet-tried) nodes
-    static int pqi; // pq index
-    static Node* n0;
-    static Node* m0;
-    static int i, j, x, y, xdx, ydy;
-    static char c;
+    priority_queue<Node> pq[2]; // list of open (not-yet-tried) nodes
+    int pqi; // pq index
+    Node* n0;
+    Node* m0;
+    int i, j, x, y, xdx, ydy;
+    char c;
     pqi=0;
 
 
@@ -63,8 +67,8 @@ string Astar::pathFind( const int & xStart, const int & yStart, const int & xFin
     {
         for(x=0;x<n;x++)
         {
-            closed_nodes_map[x][y]=0;
-            open_nodes_map[x][y]=0;
+            closed_nodes_map[x*m+y]=0;
+            open_nodes_map[x*m+y]=0;
         }
     }
 
@@ -74,7 +78,7 @@ string Astar::pathFind( const int & xStart, const int & yStart, const int & xFin
     //cout << n0->getxPos() << ":" << n0->getyPos() << endl;
     n0->updatePriority(xFinish, yFinish);
     pq[pqi].push(*n0);
-    open_nodes_map[xStart][yStart]=n0->getPriority(); // mark it on the open nodes map
+    open_nodes_map[xStart*m+yStart]=n0->getPriority(); // mark it on the open nodes map
     delete n0;
     //cout << n0->getxPos() << ":" << n0->getyPos() << endl;
     // A* search
@@ -91,11 +95,11 @@ string Astar::pathFind( const int & xStart, const int & yStart, const int & xFin
 	y=n0->getyPos();
 
         pq[pqi].pop(); // remove the node from the open list
-        open_nodes_map[x][y]=0;
+        open_nodes_map[x*m+y]=0;
         // mark it on the closed nodes map
 	//cout << "alive" << endl;
-	//cout << closed_nodes_map[x][y] << endl;
-        closed_nodes_map[x][y]=1;
+	//cout << closed_nodes_map[x*m+y] << endl;
+        closed_nodes_map[x*m+y]=1;
 	//   cout << "alive" << endl;
         // quit searching when the goal state is reached
         //if((*n0).estimate(xFinish, yFinish) == 0)
@@ -106,7 +110,7 @@ string Astar::pathFind( const int & xStart, const int & yStart, const int & xFin
             string path="";
             while(!(x==xStart && y==yStart))
             {
-                j=dir_map[x][y];
+                j=dir_map[x*m+y];
                 c='0'+(j+dir/2)%dir;
                 path=c+path;
                 x+=dx[j];
@@ -126,7 +130,7 @@ string Astar::pathFind( const int & xStart, const int & yStart, const int & xFin
             xdx=x+dx[i]; ydy=y+dy[i];
 
 //            if(!(xdx<0 || xdx>n-1 || ydy<0 || ydy>m-1 || map[xdx][ydy]==1
-            if(!(xdx<0 || xdx>n-1 || ydy<0 || ydy>m-1 || originalMap->getPathPlanningGridValue(xdx,ydy) ==1 || closed_nodes_map[xdx][ydy]==1))
+            if(!(xdx<0 || xdx>n-1 || ydy<0 || ydy>m-1 || originalMap->getPathPlanningGridValue(xdx,ydy) ==1 || closed_nodes_map[xdx*m+ydy]==1))
             {
                 // generate a child node
                 m0=new Node( xdx, ydy, n0->getLevel(),
@@ -135,20 +139,20 @@ string Astar::pathFind( const int & xStart, const int & yStart, const int & xFin
                 m0->updatePriority(xFinish, yFinish);
 
                 // if it is not in the open list then add into that
-                if(open_nodes_map[xdx][ydy]==0)
+                if(open_nodes_map[xdx*m+ydy]==0)
                 {
-                    open_nodes_map[xdx][ydy]=m0->getPriority();
+                    open_nodes_map[xdx*m+ydy]=m0->getPriority();
                     pq[pqi].push(*m0);
                     delete m0;
                     // mark its parent node direction
-                    dir_map[xdx][ydy]=(i+dir/2)%dir;
+                    dir_map[xdx*m+ydy]=(i+dir/2)%dir;
                 }
-                else if(open_nodes_map[xdx][ydy]>m0->getPriority())
+                else if(open_nodes_map[xdx*m+ydy]>m0->getPriority())
                 {
                     // update the priority info
-                    open_nodes_map[xdx][ydy]=m0->getPriority();
+                    open_nodes_map[xdx*m+ydy]=m0->getPriority();
                     // update the parent direction info
-                    dir_map[xdx][ydy]=(i+dir/2)%dir;
+                    dir_map[xdx*m+ydy]=(i+dir/2)%dir;
 
                     // replace the node
                     // by emptying one pq to the other one
@@ -195,6 +199,16 @@ double Astar::lengthPath(string path)
     return length;
 }
 
+double Astar::lengthLowerBound( const int & xStart, const int & yStart, const int & xFinish, const int & yFinish )
+{
+    int deltaX = abs(xFinish - xStart);
+    int deltaY = abs(yFinish - yStart);
+    int diagonal = min(deltaX, deltaY);
+    int straight = max(deltaX, deltaY) - diagonal;
+    // lengthPath sums the steps one by one: leave room for its rounding
+    return (straight + diagonal * sqrt(2)) * (1 - 1e-9);
+}
+
 int Astar::getNumberOfTurning(string path){
     int numberOfTurning = 0;
     //calculate the number of turning during the path
@@ -42,8 +42,9 @@ void Node::nextLevel(const int& i){ // i: direction{
 }
 
 // Estimation function for the remaining distance to the goal.
-const int & Node::estimate(const int & xDest,const int & yDest) {
-    static int xd, yd, d;
+int Node::estimate(const int & xDest,const int & yDest) const {
+    // locals, not statics: A* runs on several evaluation threads at once
+    int xd, yd, d;
     xd=xDest-xPos;
     yd=yDest-yPos;
 
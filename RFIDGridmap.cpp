@@ -10,6 +10,15 @@ RFIDGridmap::RFIDGridmap(std::string fileURI, double mapResolution, double gridR
 
 RFIDGridmap::RFIDGridmap(std::string fileURI, double mapResolution, double gridResolution): RFIDGridmap::RFIDGridmap(fileURI,  mapResolution, gridResolution, true){};
 
+RFIDGridmap::RFIDGridmap(const PGMImage &image, double mapResolution, double gridResolution, bool debug): global_frame_("world"), layer_name_("rfid"), format_("mono8"){
+
+  debug_=debug;
+  // cv view over the shared pixels, only read from
+  cv::Mat imageCV(image.getNumRows(), image.getNumCols(), CV_8UC1, const_cast<uint8_t *>(image.getPixels()));
+  createGrid(RFIDGridmap_, layer_name_, imageCV, mapResolution,  gridResolution,debug_, global_frame_,format_);
+
+};
+
 void RFIDGridmap::saveAs(std::string  fileURI){
   saveLayer(  RFIDGridmap_, layer_name_,  fileURI, debug_,format_);
 
@@ -49,6 +58,22 @@ void RFIDGridmap::setPosition(double val, double x, double y){
   setPosition(RFIDGridmap_, layer_name_, val, x,y, debug_);
 };
 
+void RFIDGridmap::save(Checkpoint *checkpoint, std::string name){
+  const grid_map::Matrix& layer = RFIDGridmap_[layer_name_];
+  checkpoint->put(name + ".values", layer.data(), layer.size() * sizeof(float), true);
+};
+
+bool RFIDGridmap::restore(const Checkpoint &checkpoint, std::string name){
+  grid_map::Matrix& layer = RFIDGridmap_[layer_name_];
+  const void *data;
+  size_t size;
+  if (!checkpoint.get(name + ".values", &data, &size) || size != layer.size() * sizeof(float)){
+    return false;
+  }
+  layer = Eigen::Map<const grid_map::Matrix>((const float *)data, layer.rows(), layer.cols());
+  return true;
+};
+
 // Internal functions to handle gridmap. .......................................
 
 void RFIDGridmap::createGrid(grid_map::GridMap&  map_, std::string layerName, std::string fileURI, double mapResolution, double gridResolution, bool debug, std::string global_frame, std::string format){
@@ -59,6 +84,17 @@ void RFIDGridmap::createGrid(grid_map::GridMap&  map_, std::string layerName, st
     std::cout<< "Using file ["<< fileURI <<"]\n";
   }
 
+  // load an image from cv
+  if (debug){
+    std::cout<< "Loading image into cv mat. \n";
+  }
+  cv::Mat imageCV = cv::imread(fileURI, CV_LOAD_IMAGE_UNCHANGED );
+  createGrid(map_, layerName, imageCV, mapResolution, gridResolution, debug, global_frame, format);
+
+};
+
+void RFIDGridmap::createGrid(grid_map::GridMap&  map_, std::string layerName, const cv::Mat& imageCV, double mapResolution, double gridResolution, bool debug, std::string global_frame, std::string format){
+
   //2D position of the grid map in the grid map frame [m].
   double orig_x;
   double orig_y;
@@ -71,11 +107,6 @@ void RFIDGridmap::createGrid(grid_map::GridMap&  map_, std::string layerName, st
   double  minValue;
   double  maxValue;
 
-  // load an image from cv
-  if (debug){
-    std::cout<< "Loading image into cv mat. \n";
-  }
-  cv::Mat imageCV = cv::imread(fileURI, CV_LOAD_IMAGE_UNCHANGED );
   num_rows = imageCV.rows;
   num_cols = imageCV.cols;
 
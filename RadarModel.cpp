@@ -4,6 +4,34 @@
 using namespace std;
 using namespace grid_map;
 
+// Runs fn(block, first_col, end_col) over the BAYES_BLOCK_COLS wide column
+// blocks of a rows x cols window and returns the number of blocks. Blocks
+// are spread over up to max_threads threads, but the columns of each block
+// never depend on the thread count: partials stored per block and reduced
+// in block order give the same result whatever the threads.
+template <typename F>
+static int forEachColumnBlock(int rows, int cols, int max_threads, F fn) {
+  int blocks = (cols + BAYES_BLOCK_COLS - 1) / BAYES_BLOCK_COLS;
+  long cells = (long)rows * cols;
+  int threads = std::min<long>(std::min(max_threads, blocks),
+                               cells / BAYES_MIN_CELLS_PER_THREAD);
+  if (threads <= 1) {
+    for (int b = 0; b < blocks; ++b)
+      fn(b, b * BAYES_BLOCK_COLS, std::min(cols, (b + 1) * BAYES_BLOCK_COLS));
+    return blocks;
+  }
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; ++t) {
+    pool.emplace_back([&, t]() {
+      for (int b = t; b < blocks; b += threads)
+        fn(b, b * BAYES_BLOCK_COLS, std::min(cols, (b + 1) * BAYES_BLOCK_COLS));
+    });
+  }
+  for (std::thread &th : pool)
+    th.join();
+  return blocks;
+}
+
 // http://eigen.tuxfamily.org/dox/AsciiQuickReference.txt
 
 //////////////////  SPLINE FUNCTIONS   //////////////////
@@ -56,7 +84,10 @@ SplineFunction::scaled_values(Eigen::VectorXd const &x_vec) const {
 
 RadarModel::RadarModel(){};
 
-RadarModel::RadarModel(const double resolution, const double sigma_power, const double sigma_phase, const double txtPower, const std::vector<double> freqs, const std::vector<std::pair<double,double>> tags_coords, const std::string imageFileURI ) {
+RadarModel::RadarModel(const double resolution, const double sigma_power, const double sigma_phase, const double txtPower, const std::vector<double> freqs, const std::vector<std::pair<double,double>> tags_coords, const std::string imageFileURI ) :
+        RadarModel(resolution, sigma_power, sigma_phase, txtPower, freqs, tags_coords, PGMImage(imageFileURI)) {}
+
+RadarModel::RadarModel(const double resolution, const double sigma_power, const double sigma_phase, const double txtPower, const std::vector<double> freqs, const std::vector<std::pair<double,double>> tags_coords, const PGMImage &refImage ) {
         _sigma_power = sigma_power;
         _sigma_phase = sigma_phase;
         _txtPower = txtPower;
@@ -65,7 +96,7 @@ RadarModel::RadarModel(const double resolution, const double sigma_power, const
         _tags_coords = tags_coords;
         _numTags =  tags_coords.size();
 
-        initRefMap(imageFileURI);
+        initRefMap(refImage);
 
         // build spline to interpolate antenna gains;
         std::vector<double> xVec(ANTENNA_ANGLES_LIST, ANTENNA_ANGLES_LIST + 25);
@@ -74,6 +105,12 @@ RadarModel::RadarModel(const double resolution, const double sigma_power, const
         Eigen::VectorXd yvals= Eigen::Map<Eigen::VectorXd, Eigen::Unaligned>(yVec.data(), yVec.size());
         
         _antenna_gains= SplineFunction(xvals, yvals);
+        int lut_size = (int)round(360.0 / ANTENNA_LUT_STEP) + 1;
+        std::vector<float> lut(lut_size);
+        for (int k = 0; k < lut_size; ++k) {
+          lut[k] = _antenna_gains.interpDeg(-180.0 + k * ANTENNA_LUT_STEP);
+        }
+        _antenna_gain_lut = std::make_shared<std::vector<float>>(std::move(lut));
       
         // rfid beliefs global map: One layer per tag
         std::string layerName;
@@ -81,34 +118,43 @@ RadarModel::RadarModel(const double resolution, const double sigma_power, const
            layerName = getTagLayerName(i);
            _rfid_belief_maps.add(layerName, 0.5);  // the cells need to have a uniform distribution at the beginning
         }
+        _layer_scale.assign(_numTags, 1.0);
+        _layer_mass.assign(_numTags, 0.0);
+        _belief_sat.resize(_numTags);
+        _belief_sat_dirty.assign(_numTags, true);
         clearObstacleCellsRFIDMap();
         normalizeRFIDMap();
         debugInfo();
 
-        // mesh grid layers
-        _rfid_belief_maps.add("X", 0);  
-        _rfid_belief_maps.add("Y", 0);  
-        Position point;
-        Index ind;
-        for (grid_map::GridMapIterator iterator(_rfid_belief_maps); !iterator.isPastEnd(); ++iterator) {
-            // matrix indexes...
-            ind = *iterator;
-            // get cell center of the cell in the map frame.            
-            _rfid_belief_maps.getPosition(ind, point);
-            // that is where the tag supposedly is in map coordinates
-            _rfid_belief_maps.at("X",*iterator) = point.x();
-            _rfid_belief_maps.at("Y",*iterator) = point.y();
-        }
+        // scratch layers and buffers, allocated once
+        _rfid_belief_maps.add("obst_losses", NAN);
+        Size siz = _rfid_belief_maps.getSize();
+        _scratch_X.resize(siz(0), siz(1));
+        _scratch_Y.resize(siz(0), siz(1));
+        _scratch_R.resize(siz(0), siz(1));
+        _scratch_A.resize(siz(0), siz(1));
+        _scratch_rxPw.resize(siz(0), siz(1));
+        _scratch_posterior.resize(siz(0), siz(1));
+        _scratch_partials.resize(siz(1) / BAYES_BLOCK_COLS + 1);
+        _scratch_rows.resize(siz(0));
+        _scratch_cols.resize(siz(1));
 
     }
 
 
 void RadarModel::initRefMap(const std::string imageURI) {
+  initRefMap(PGMImage(imageURI));
+}
+
+void RadarModel::initRefMap(const PGMImage &refImage) {
   std::cout << "\nIniting Ref map." << std::endl;
 
-  cv::Mat _imageCV = cv::imread(imageURI, CV_LOAD_IMAGE_UNCHANGED);
+  // view over the shared pixels: flip into a new buffer, never in place
+  cv::Mat refView(refImage.getNumRows(), refImage.getNumCols(), CV_8UC1,
+                  const_cast<uint8_t *>(refImage.getPixels()));
+  cv::Mat _imageCV;
   // this alligns image with our coordinate systems
-  cv::flip(_imageCV, _imageCV, -1);
+  cv::flip(refView, _imageCV, -1);
 
   _Ncol = _imageCV.cols; // radar model total x-range space (cells).
   _Nrow = _imageCV.rows; // radar model total y-range space (cells).
@@ -128,17 +174,33 @@ void RadarModel::initRefMap(const std::string imageURI) {
   orig_x = (_Nrow - 1) * (_resolution / 2.0);
   orig_y = (_Ncol - 1) * (_resolution / 2.0);
 
-  _rfid_belief_maps = grid_map::GridMap(vector<string>({"ref_map"}));
+  // the tag layers are added by the constructor
+  _rfid_belief_maps = grid_map::GridMap();
   _rfid_belief_maps.setGeometry(Length(len_x, len_y), _resolution,
                                 Position(orig_x, orig_y));
-  _tmp_rfid_c_map.setGeometry(Length(2, 2), _resolution);
-  _tmp_rfid_c_map.add("temp", 0.0);
+
+  GridMap ref_maps(vector<string>({"ref_map", "X", "Y"}));
+  ref_maps.setGeometry(Length(len_x, len_y), _resolution,
+                       Position(orig_x, orig_y));
 
   cv::minMaxLoc(_imageCV, &minValue, &maxValue);
   _free_space_val = maxValue;
-  _rfid_belief_maps["ref_map"].setConstant(NAN);
+  ref_maps["ref_map"].setConstant(NAN);
   GridMapCvConverter::addLayerFromImage<unsigned char, 3>(
-      _imageCV, "ref_map", _rfid_belief_maps, minValue, maxValue);
+      _imageCV, "ref_map", ref_maps, minValue, maxValue);
+  _free_mask = std::make_shared<Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic>>(
+      ref_maps["ref_map"].array() == _free_space_val);
+
+  // mesh grid layers
+  Position point;
+  for (grid_map::GridMapIterator iterator(ref_maps); !iterator.isPastEnd(); ++iterator) {
+    // get cell center of the cell in the map frame: that is where the tag
+    // supposedly is in map coordinates
+    ref_maps.getPosition(*iterator, point);
+    ref_maps.at("X", *iterator) = point.x();
+    ref_maps.at("Y", *iterator) = point.y();
+  }
+  _ref_maps = std::make_shared<GridMap>(std::move(ref_maps));
 
   std::cout << " Input map has " << _rfid_belief_maps.getSize()(1)
             << " cols by " << _rfid_belief_maps.getSize()(0) << " rows "
@@ -211,7 +273,12 @@ void RadarModel::saveProbMaps(std::string savePath) {
     tagLayerName = getTagLayerName(i);
     // std::cout << " Saving layer [" << tagLayerName << "]" << std::endl ;
     fileURI = savePath + "final_prob_" + tagLayerName + ".png";
-    getImage(&_rfid_belief_maps, tagLayerName, fileURI);
+    if (_log_belief) {
+      _rfid_belief_maps.add("belief", getBeliefMatrix(i));
+      getImage(&_rfid_belief_maps, "belief", fileURI);
+    } else {
+      getImage(&_rfid_belief_maps, tagLayerName, fileURI);
+    }
     // data_mat = _rfid_belief_maps[tagLayerName];
     // PrintProb(fileURI, &data_mat, _Ncol*_resolution, _Nrow*_resolution,
     // _resolution);
@@ -292,20 +359,47 @@ Eigen::MatrixXf RadarModel::getFriisMatSlow(double x_m, double y_m, double orien
   return rxPw_mat;
 }
 
-Eigen::MatrixXf RadarModel::getFriisMatFast(double x_m, double y_m, double orientation_deg, double freq){
+const Eigen::MatrixXf &RadarModel::getFriisMatFast(double x_m, double y_m, double orientation_deg, double freq){
+  getFriisMatFast(x_m, y_m, orientation_deg, freq, _scratch_rxPw);
+  return _scratch_rxPw;
+}
+
+void RadarModel::getFriisMat(double x_m, double y_m, double orientation_deg, double freq, Eigen::MatrixXf &rxPw_mat){
+  if (useFast)
+    getFriisMatFast(x_m, y_m, orientation_deg, freq, rxPw_mat);
+  else
+    rxPw_mat = getFriisMatSlow(x_m, y_m, orientation_deg, freq);
+}
+
+float RadarModel::antennaGainRadf(float angle_rad) const {
+  const std::vector<float> &lut = *_antenna_gain_lut;
+  double pos = (angle_rad * 180.0 / M_PI + 180.0) / ANTENNA_LUT_STEP;
+  int last = lut.size() - 1;
+  if (pos <= 0)
+    return lut[0];
+  if (pos >= last)
+    return lut[last];
+  int k = (int)pos;
+  float t = pos - k;
+  return lut[k] + t * (lut[k + 1] - lut[k]);
+}
+
+void RadarModel::getFriisMatFast(double x_m, double y_m, double orientation_deg, double freq, Eigen::MatrixXf &rxPower){
   // https://eigen.tuxfamily.org/dox/AsciiQuickReference.txt
   // https://github.com/ANYbotics/grid_map
 
-
-  Eigen::MatrixXf X, Y, R, A, propL, antL,totalLoss, rxPower;
-  Eigen::VectorXf x,y;
+  // all temporaries are preallocated members
+  Eigen::MatrixXf &X = _scratch_X;
+  Eigen::MatrixXf &Y = _scratch_Y;
+  Eigen::MatrixXf &R = _scratch_R;
+  Eigen::MatrixXf &A = _scratch_A;
   Index i00,i0M,iNM,iN0, iRobot;
   double lambda =  C/freq;
   double orientation_rad = orientation_deg * M_PI/180.0;
   
-  // rotate and translate
-  Eigen::MatrixXf X0 = _rfid_belief_maps["X"];
-  Eigen::MatrixXf Y0 = _rfid_belief_maps["Y"];
+  // rotate and translate, reading the mesh grid layers in place
+  const GridMap::Matrix &X0 = (*_ref_maps)["X"];
+  const GridMap::Matrix &Y0 = (*_ref_maps)["Y"];
   
   double cA =cos(orientation_rad);
   double sA =sin(orientation_rad);
@@ -314,23 +408,21 @@ Eigen::MatrixXf RadarModel::getFriisMatFast(double x_m, double y_m, double orien
   Y =   (-X0 * sA + Y0 * cA).array() + (x_m*sA - y_m*cA);  
 
   // create R,Ang matrixes
-  R = (X.array().square() + Y.array().square()).array().sqrt();
-  A = Y.binaryExpr(X, std::ptr_fun(atan2f)).array();
-
-  // 1. Create a friis losses propagation matrix without taking obstacles        
-  auto funtor = std::bind(&SplineFunction::interpRadf, _antenna_gains, _1) ;
-  antL =  TAG_LOSSES + A.unaryExpr( funtor ).array();   
-  propL = LOSS_CONSTANT - (20.0 * (R * freq).array().log10()).array() ;
+  R = (X.array().square() + Y.array().square()).sqrt();
+  A = Y.binaryExpr(X, std::ptr_fun(atan2f));
 
+  // 1. Create a friis losses propagation matrix without taking obstacles
   // signal goes from antenna to tag and comes back again, so we double the losses
-  totalLoss =  2.0*antL + 2.0*propL ;
-  
-  rxPower = totalLoss.array() + _txtPower;
+  auto gain = [this](float angle) { return antennaGainRadf(angle); };
+  rxPower = 2.0 * (TAG_LOSSES + A.unaryExpr(gain).array()) +
+            2.0 * (LOSS_CONSTANT - 20.0 * (R * freq).array().log10()) +
+            _txtPower;
   // this should remove points where friis is not applicable
   rxPower = (R.array()>2.0*lambda).select(rxPower,_txtPower); 
   
-  //2. Create a NaN filled matrix for obstacles loses
-  _rfid_belief_maps.add("obst_losses",NAN);
+  //2. Reset the obstacle losses layer to NaN
+  GridMap::Matrix &obst_losses = _rfid_belief_maps["obst_losses"];
+  obst_losses.setConstant(NAN);
 
   // iterate over four lines to fill obst_losses layer ...................  
   // line 1: (0,0) to (0,M)
@@ -351,20 +443,15 @@ Eigen::MatrixXf RadarModel::getFriisMatFast(double x_m, double y_m, double orien
   addLossesTillEdgeLine(iN0, i00, iRobot );
 
   // And finally add obstacle losses and propagation losses  
-  rxPower = rxPower   - _rfid_belief_maps.get("obst_losses");
-  //std::cout << "Still running at line: " << __LINE__<< std::endl;
+  rxPower -= obst_losses;
 
   // this should remove points where received power is too low
   rxPower = (rxPower.array()>SENSITIVITY).select(rxPower,SENSITIVITY); 
-
-  // mfc trick used to see temp matrixes as images
-  //_rfid_belief_maps.add("obst_losses",rxPower);
-  return rxPower;
-
 }
 
 void RadarModel::addLossesTillEdgeLine(Index edge_index_start,   Index edge_index_end,   Index antenna_index){
   Index edge_index;
+  GridMap::Matrix &obst_losses = _rfid_belief_maps["obst_losses"];
   
   double obst_loss_ray, obst_cell_inc;
 
@@ -380,14 +467,15 @@ void RadarModel::addLossesTillEdgeLine(Index edge_index_start,   Index edge_inde
     //Now iterate from xm,ym to the point xi,yi in the edge
     for (grid_map::LineIterator loss_ray_iterator(_rfid_belief_maps, antenna_index, edge_index); !loss_ray_iterator.isPastEnd(); ++loss_ray_iterator) {
 
+      const Index &ray_index = *loss_ray_iterator;
       // if the cell is obstacle, add L to cummulated_L
-      if (( _rfid_belief_maps.at("ref_map", *loss_ray_iterator) != _free_space_val  )){
+      if (!(*_free_mask)(ray_index(0), ray_index(1))){
         obst_loss_ray += obst_cell_inc;
       }
 
       // obstacles losses in cell is cummulated_L. Avoid multiple edits   
-      if (( _rfid_belief_maps.at("obst_losses", *loss_ray_iterator) != NAN  )){
-        _rfid_belief_maps.at("obst_losses", *loss_ray_iterator) = obst_loss_ray; 
+      if (( obst_losses(ray_index(0), ray_index(1)) != NAN  )){
+        obst_losses(ray_index(0), ray_index(1)) = obst_loss_ray; 
       }      
 
     }
@@ -476,9 +564,6 @@ double RadarModel::getTotalWeight(double x, double y, double orientation,
 
   submapBufferSize = submapEndIndex - submapStartIndex;
 
-  grid_map::SubmapIterator iterator(_rfid_belief_maps, submapStartIndex,
-                                    submapBufferSize);
-
   // std::cout<<"\nGet prob.:" << std::endl;
   // std::cout<<" Centered at Position (" << x << ", " << y << ") m. / Size ("
   // << size_x << ", " << size_y << ")" << std::endl; std::cout<<" Start pose ("
@@ -488,7 +573,11 @@ double RadarModel::getTotalWeight(double x, double y, double orientation,
   // submapStartIndex(1) << ") to cell("  << submapEndIndex(0) << ", " <<
   // submapEndIndex(1) << ")"<< std::endl;
 
-  return getTotalWeight(x, y, orientation, iterator, tag_i);
+  // same cells a SubmapIterator would visit, summed in O(1) from the
+  // integral image of the layer
+  return getWindowBelief(tag_i, submapStartIndex(0), submapStartIndex(1),
+                         submapStartIndex(0) + submapBufferSize(0) - 1,
+                         submapStartIndex(1) + submapBufferSize(1) - 1);
 }
 
 double RadarModel::getTotalWeight(double x, double y, double orientation,
@@ -499,15 +588,17 @@ double RadarModel::getTotalWeight(double x, double y, double orientation,
   Position point;
 
   std::string tagLayerName = getTagLayerName(tag_i);
+  const GridMap::Matrix &belief = _rfid_belief_maps[tagLayerName];
 
   total_weight = 0;
   for (iterator; !iterator.isPastEnd(); ++iterator) {
-    _rfid_belief_maps.getPosition(*iterator, point);
+    const Index &index = *iterator;
+    _rfid_belief_maps.getPosition(index, point);
     // check if is inside global map
     if (_rfid_belief_maps.isInside(point)) {
       // We don't add belief from positions considered obstacles...
-      if (_rfid_belief_maps.atPosition("ref_map", point) == _free_space_val) {
-        total_weight += _rfid_belief_maps.atPosition(tagLayerName, point);
+      if ((*_free_mask)(index(0), index(1))) {
+        total_weight += toBelief(belief(index(0), index(1)), tag_i);
       }
     }
   }
@@ -844,10 +935,12 @@ void RadarModel::rotatePoints(cv::Point *points, int npts, int cxi, int cyi,
 }
 
 cv::Mat RadarModel::rfidBeliefToCVImg(std::string layer_i){
+  if (_ref_maps->exists(layer_i))
+    return layerToImage(_ref_maps.get(), layer_i);
   return layerToImage(&_rfid_belief_maps,layer_i);
 }
 
-cv::Mat  RadarModel::layerToImage(GridMap* gm,std::string layerName){
+cv::Mat  RadarModel::layerToImage(const GridMap* gm,std::string layerName){
   cv::Mat image;
   const float minValue = (*gm)[layerName].minCoeff();
   const float maxValue = (*gm)[layerName].maxCoeff();
@@ -913,6 +1006,10 @@ void RadarModel::saveProbMapDebug(std::string savePATH, int tag_num, int step,
   cv::Scalar green(0, 255, 0);
 
   // Convert to image.
+  if (_log_belief) {
+    _rfid_belief_maps.add("belief", getBeliefMatrix(tag_num));
+    layerName = "belief";
+  }
   cv::Mat image = rfidBeliefToCVImg(layerName);
 
   cv::Point tag_center;
@@ -1110,7 +1207,7 @@ double RadarModel::received_power_friis_with_obstacles(
     for (grid_map::LineIterator iterator(_rfid_belief_maps, antenna_index,
                                          tag_index);
          !iterator.isPastEnd(); ++iterator) {
-      if ((_rfid_belief_maps.at("ref_map", *iterator) != _free_space_val)) {
+      if (!(*_free_mask)((*iterator)(0), (*iterator)(1))) {
         count_obs_cell++;
       }
     }
@@ -1187,58 +1284,37 @@ double RadarModel::phaseDifference(double tag_x, double tag_y, double freq) {
 }
 
 std::pair<int, std::pair<int, int>>
-RadarModel::findTagFromBeliefMap(int num_tag) {
-
-  // Access the belief map of every tag
-  std::string layerName = getTagLayerName(num_tag);
-  GridMap::Matrix &grid = _rfid_belief_maps[layerName];
+RadarModel::findTagFromBeliefMap(int num_tag, int buffer_size) {
 
   std::pair<int, int> tag(0, 0);
   double powerRead = 0;
-  // for(int row=0; row < grid.getLength().x(); row++)
-  // {
-  //   for(int col=0; col < grid.getLength().y(); col++)
-  //   {
-
-  for (GridMapIterator iterator(_rfid_belief_maps); !iterator.isPastEnd();
-       ++iterator) {
-    const Index index(*iterator);
-    // For every cell, analyse the surrounding area
-    double tmp_power = 0.0;
-    tmp_power = grid(index(0), index(1));
-    int buffer_size = 3;
-    if (index(0) > buffer_size and
-        index(0) <= _rfid_belief_maps.getLength().x() - buffer_size) {
-      if (index(1) > buffer_size and
-          index(1) <= _rfid_belief_maps.getLength().y() - buffer_size) {
-        // std::cout << "I: " << index(0) << "," << index(1) << endl;
-        Index submapStartIndex(index(0) - buffer_size, index(1) - buffer_size);
-        Index submapBufferSize(buffer_size, buffer_size);
-        for (grid_map::SubmapIterator sub_iterator(
-                 _rfid_belief_maps, submapStartIndex, submapBufferSize);
-             !sub_iterator.isPastEnd(); ++sub_iterator) {
-          Index sub_index(*sub_iterator);
-          // std::cout << "I: " << sub_index(0) << "," << sub_index(1) << endl;
-          tmp_power += grid(sub_index(0), sub_index(1));
+  const int rows = _rfid_belief_maps.getSize()(0);
+  const int cols = _rfid_belief_maps.getSize()(1);
+
+  // Same visiting order as a GridMapIterator, so ties resolve the same way.
+  // Each cell adds the buffer_size x buffer_size block above and to the left
+  // of it, which the integral image gives in O(1).
+  for (int c = 0; c < cols; ++c) {
+    for (int r = 0; r < rows; ++r) {
+      // For every cell, analyse the surrounding area
+      double tmp_power = getWindowBelief(num_tag, r, c, r, c);
+      if (r > buffer_size and
+          r <= _rfid_belief_maps.getLength().x() - buffer_size) {
+        if (c > buffer_size and
+            c <= _rfid_belief_maps.getLength().y() - buffer_size) {
+          tmp_power += getWindowBelief(num_tag, r - buffer_size,
+                                       c - buffer_size, r - 1, c - 1);
         }
       }
-    }
 
-    // for (int i = -3; i <= 3; i++){
-    //   for (int j = -3; j <= 3; j++){
-    //     tmp_power = tmp_power + grid.getCell(row, col);
-    //   }
-    // }
-    // tmp_power = grid.getCell(row, col);
-    if (tmp_power > powerRead) {
-      powerRead = tmp_power;
-
-      // Normalise the tag coordinate to follow Ricc's system
-      tag.first = _rfid_belief_maps.getLength().x() - index(0);
-      tag.second = _rfid_belief_maps.getLength().y() - index(1);
-    }
+      if (tmp_power > powerRead) {
+        powerRead = tmp_power;
 
-    // }
+        // Normalise the tag coordinate to follow Ricc's system
+        tag.first = _rfid_belief_maps.getLength().x() - r;
+        tag.second = _rfid_belief_maps.getLength().y() - c;
+      }
+    }
   }
   std::pair<int, std::pair<int, int>> final_return(powerRead, tag);
 
@@ -1246,35 +1322,219 @@ RadarModel::findTagFromBeliefMap(int num_tag) {
   return final_return;
 }
 
-void RadarModel::normalizeRFIDLayer(std::string layerName) {
-  double totalW = _rfid_belief_maps[layerName].sum();
+void RadarModel::updateBeliefSAT(int tag_i) {
+  if (!_belief_sat_dirty[tag_i])
+    return;
+  const GridMap::Matrix &layer = _rfid_belief_maps[getTagLayerName(tag_i)];
+  Eigen::MatrixXd &sat = _belief_sat[tag_i];
+  const auto &free_mask = *_free_mask;
+  const int rows = layer.rows();
+  const int cols = layer.cols();
+
+  // one row and column of zeros in front, so queries need no edge cases
+  sat.resize(rows + 1, cols + 1);
+  sat.row(0).setZero();
+  sat.col(0).setZero();
+  for (int c = 0; c < cols; ++c) {
+    double col_sum = 0.0;
+    for (int r = 0; r < rows; ++r) {
+      if (free_mask(r, c))
+        col_sum += _log_belief ? std::exp(layer(r, c)) : layer(r, c);
+      sat(r + 1, c + 1) = sat(r + 1, c) + col_sum;
+    }
+  }
+  _belief_sat_dirty[tag_i] = false;
+}
+
+double RadarModel::getWindowBelief(int tag_i, int row_start, int col_start,
+                                   int row_end, int col_end) {
+  row_start = std::max(row_start, 0);
+  col_start = std::max(col_start, 0);
+  row_end = std::min(row_end, (int)_rfid_belief_maps.getSize()(0) - 1);
+  col_end = std::min(col_end, (int)_rfid_belief_maps.getSize()(1) - 1);
+  if (row_start > row_end or col_start > col_end)
+    return 0.0;
+
+  updateBeliefSAT(tag_i);
+  const Eigen::MatrixXd &sat = _belief_sat[tag_i];
+  double sum = sat(row_end + 1, col_end + 1) - sat(row_start, col_end + 1) -
+               sat(row_end + 1, col_start) + sat(row_start, col_start);
+  // the table holds stored values, the lazy scale applies on top
+  return _log_belief ? sum : sum * _layer_scale[tag_i];
+}
+
+void RadarModel::normalizeRFIDLayer(int tag_i) {
+  if (_log_belief) {
+    rescaleRFIDLayer(tag_i);
+  } else if (_layer_mass[tag_i] > 0) {
+    _layer_scale[tag_i] = 1.0 / _layer_mass[tag_i];
+  }
+}
+
+void RadarModel::rescaleRFIDLayer(int tag_i) {
+  GridMap::Matrix &layer = _rfid_belief_maps[getTagLayerName(tag_i)];
+  _belief_sat_dirty[tag_i] = true;
+  if (_log_belief) {
+    // log-sum-exp, shifted by the max so no exp overflows
+    float max_log = layer.maxCoeff();
+    if (std::isfinite(max_log)) {
+      double lse = max_log + std::log((layer.array() - max_log)
+                                          .exp()
+                                          .cast<double>()
+                                          .sum());
+      layer.array() -= lse;
+    }
+    return;
+  }
+  double totalW = layer.cast<double>().sum();
   if (totalW > 0) {
-    _rfid_belief_maps[layerName] = _rfid_belief_maps[layerName] / totalW;
+    layer = layer / totalW;
+    totalW = 1.0;
+  }
+  _layer_mass[tag_i] = totalW;
+  _layer_scale[tag_i] = 1.0;
+}
+
+void RadarModel::setLogBelief(bool enable) {
+  if (enable == _log_belief)
+    return;
+  for (int i = 0; i < _numTags; ++i) {
+    GridMap::Matrix &layer = _rfid_belief_maps[getTagLayerName(i)];
+    if (enable) {
+      // obstacle cells go to log(0) = -inf
+      layer = (layer * _layer_scale[i]).array().log();
+    } else {
+      layer = layer.array().exp();
+    }
   }
+  _log_belief = enable;
+  _belief_sat_dirty.assign(_numTags, true);
+  normalizeRFIDMap();
+}
+
+bool RadarModel::isLogBelief() const { return _log_belief; }
+
+double RadarModel::getBelief(int tag_i, const grid_map::Index &index) {
+  return toBelief(_rfid_belief_maps.at(getTagLayerName(tag_i), index), tag_i);
+}
 
-  // double minW = _rfid_belief_maps[layerName].minCoeff();
-  // double maxW = _rfid_belief_maps[layerName].maxCoeff();
-  // _rfid_belief_maps.add("min", minW);
-  // _rfid_belief_maps.add("max", minW);
-  // _rfid_belief_maps[layerName] = (_rfid_belief_maps[layerName] -
-  // _rfid_belief_maps["min"])/ (maxW - minW);
+double RadarModel::toBelief(float value, int tag_i) const {
+  if (_log_belief)
+    return std::exp(value);
+  return value * _layer_scale[tag_i];
+}
+
+Eigen::MatrixXf RadarModel::getBeliefMatrix(int tag_i) {
+  const GridMap::Matrix &layer = _rfid_belief_maps[getTagLayerName(tag_i)];
+  if (_log_belief)
+    return layer.array().exp();
+  return layer * _layer_scale[tag_i];
 }
 
 void RadarModel::normalizeRFIDMap() {
-  std::string layerName;
   // For every tag map, calculate the sum over the pixels and
   // divide each pixel intensity by the sum
   for (int i = 0; i < _numTags; ++i) {
-    layerName = getTagLayerName(i);
-    double totalW = _rfid_belief_maps[layerName].sum();
-    if (totalW > 0) {
-      _rfid_belief_maps[layerName] = _rfid_belief_maps[layerName] / totalW;
-    }
+    rescaleRFIDLayer(i);
   }
 }
 
+void RadarModel::saveBeliefs(Checkpoint *checkpoint, bool compress) {
+  checkpoint->putValue("radar.numTags", _numTags);
+  checkpoint->putValue("radar.logBelief", _log_belief);
+  checkpoint->putVector("radar.layerScale", _layer_scale);
+  checkpoint->putVector("radar.layerMass", _layer_mass);
+  Size siz = _rfid_belief_maps.getSize();
+  std::vector<int> dimensions{siz(0), siz(1)};
+  checkpoint->putVector("radar.size", dimensions);
+  for (int i = 0; i < _numTags; ++i) {
+    const grid_map::Matrix &layer = _rfid_belief_maps[getTagLayerName(i)];
+    checkpoint->put("radar." + getTagLayerName(i), layer.data(),
+                    layer.size() * sizeof(float), compress);
+  }
+}
+
+bool RadarModel::restoreBeliefs(const Checkpoint &checkpoint) {
+  int numTags;
+  bool logBelief;
+  std::vector<double> layerScale, layerMass;
+  std::vector<int> dimensions;
+  Size siz = _rfid_belief_maps.getSize();
+  if (!checkpoint.getValue("radar.numTags", &numTags) || numTags != _numTags ||
+      !checkpoint.getValue("radar.logBelief", &logBelief) ||
+      !checkpoint.getVector("radar.layerScale", &layerScale) ||
+      !checkpoint.getVector("radar.layerMass", &layerMass) ||
+      !checkpoint.getVector("radar.size", &dimensions) ||
+      dimensions.size() != 2 || dimensions[0] != siz(0) ||
+      dimensions[1] != siz(1))
+    return false;
+  // check every layer before touching the model
+  std::vector<const float *> layers(_numTags);
+  for (int i = 0; i < _numTags; ++i) {
+    const void *data;
+    size_t size;
+    if (!checkpoint.get("radar." + getTagLayerName(i), &data, &size) ||
+        size != (size_t)siz(0) * siz(1) * sizeof(float))
+      return false;
+    layers[i] = (const float *)data;
+  }
+  for (int i = 0; i < _numTags; ++i) {
+    _rfid_belief_maps[getTagLayerName(i)] =
+        Eigen::Map<const grid_map::Matrix>(layers[i], siz(0), siz(1));
+  }
+  _log_belief = logBelief;
+  _layer_scale = layerScale;
+  _layer_mass = layerMass;
+  _belief_sat_dirty.assign(_numTags, true);
+  return true;
+}
+
+std::shared_ptr<RadarModel> RadarModel::snapshot() {
+  // built before copying, so that readers of the copy never rebuild them
+  for (int i = 0; i < _numTags; ++i)
+    updateBeliefSAT(i);
+
+  std::shared_ptr<RadarModel> copy = std::make_shared<RadarModel>();
+  copy->_Ncol = _Ncol;
+  copy->_Nrow = _Nrow;
+  copy->_free_space_val = _free_space_val;
+  copy->_resolution = _resolution;
+  copy->_txtPower = _txtPower;
+  copy->_sigma_power = _sigma_power;
+  copy->_sigma_phase = _sigma_phase;
+  copy->_tags_coords = _tags_coords;
+  copy->_numTags = _numTags;
+  copy->_freqs = _freqs;
+  copy->_antenna_gains = _antenna_gains;
+  copy->_layer_scale = _layer_scale;
+  copy->_layer_mass = _layer_mass;
+  copy->_log_belief = _log_belief;
+  copy->useFast = useFast;
+  copy->updateThreads = updateThreads;
+
+  // immutable: shared
+  copy->_ref_maps = _ref_maps;
+  copy->_free_mask = _free_mask;
+  copy->_antenna_gain_lut = _antenna_gain_lut;
+
+  // the tag layers and their integral images, without the scratch layer
+  std::vector<std::string> layers;
+  for (int i = 0; i < _numTags; ++i)
+    layers.push_back(getTagLayerName(i));
+  copy->_rfid_belief_maps = grid_map::GridMap(layers);
+  copy->_rfid_belief_maps.setFrameId(_rfid_belief_maps.getFrameId());
+  copy->_rfid_belief_maps.setGeometry(_rfid_belief_maps.getLength(),
+                                      _rfid_belief_maps.getResolution(),
+                                      _rfid_belief_maps.getPosition());
+  copy->_rfid_belief_maps.setStartIndex(_rfid_belief_maps.getStartIndex());
+  for (int i = 0; i < _numTags; ++i)
+    copy->_rfid_belief_maps[layers[i]] = _rfid_belief_maps[layers[i]];
+  copy->_belief_sat = _belief_sat;
+  copy->_belief_sat_dirty = _belief_sat_dirty;
+  return copy;
+}
+
 void RadarModel::clearObstacleCellsRFIDMap() {
-  Position point;
   std::string layerName;
 
   for (int i = 0; i < _numTags; ++i) {
@@ -1282,9 +1542,10 @@ void RadarModel::clearObstacleCellsRFIDMap() {
     for (grid_map::GridMapIterator iterator(_rfid_belief_maps);
          !iterator.isPastEnd(); ++iterator) {
       // get cell center of the cell in the map frame.
-      _rfid_belief_maps.getPosition(*iterator, point);
-      if (_rfid_belief_maps.atPosition("ref_map", point) != _free_space_val) {
-        _rfid_belief_maps.at(layerName, *iterator) = 0.0;
+      const Index &index = *iterator;
+      if (!(*_free_mask)(index(0), index(1))) {
+        _rfid_belief_maps.at(layerName, index) = 0.0;
+        _belief_sat_dirty[i] = true;
         // count++;
       }
     }
@@ -1301,35 +1562,146 @@ void RadarModel::addMeasurement(double x_m, double y_m, double orientation_deg,
                                 double rxPower, double phase, double freq,
                                 int i) {
 
-  Eigen::MatrixXf rxPw_mat, likl_mat;
+  // every buffer used here is a preallocated member
+  Eigen::MatrixXf &rxPw_mat = _scratch_rxPw;
+  Eigen::Array<bool, Eigen::Dynamic, 1> &readable_rows = _scratch_rows;
+  Eigen::Array<bool, 1, Eigen::Dynamic> &readable_cols = _scratch_cols;
   std::string tagLayerName;
 
   tagLayerName = getTagLayerName(i);
-  Size siz = _rfid_belief_maps.getSize();
-  rxPw_mat = Eigen::MatrixXf(siz(0), siz(1));
 
   // get the expected power at each point
-  rxPw_mat = getFriisMat(x_m, y_m, orientation_deg, freq);
-
-  // get the likelihood of the received power at each point
-  likl_mat = getProbCond(rxPw_mat, rxPower, _sigma_power);
+  getFriisMat(x_m, y_m, orientation_deg, freq, rxPw_mat);
+
+  // Expected power is clamped to SENSITIVITY where the tag can't be read, so
+  // the likelihood is the same constant in all those cells. Dividing it out
+  // leaves a ratio of 1 there: only the window of readable cells changes.
+  // Find that window, rows and cols in a single pass.
+  const float sensitivity = SENSITIVITY;
+  readable_rows.setConstant(false);
+  for (int c = 0; c < rxPw_mat.cols(); ++c) {
+    bool readable = false;
+    for (int r = 0; r < rxPw_mat.rows(); ++r) {
+      if (rxPw_mat(r, c) != sensitivity) {
+        readable_rows(r) = true;
+        readable = true;
+      }
+    }
+    readable_cols(c) = readable;
+  }
 
-  // Where X_mat is < than SENSITIVITY, the tag wont be... prob 0
-  // likl_mat = (likl_mat.array()<=SENSITIVITY).select(0,likl_mat);
+  int r0 = 0, r1 = readable_rows.size() - 1;
+  int c0 = 0, c1 = readable_cols.size() - 1;
+  while (r0 <= r1 and !readable_rows(r0))
+    r0++;
+  while (r1 >= r0 and !readable_rows(r1))
+    r1--;
+  while (c0 <= c1 and !readable_cols(c0))
+    c0++;
+  while (c1 >= c0 and !readable_cols(c1))
+    c1--;
+  // the measurement says nothing new about any cell
+  if (r0 > r1 or c0 > c1)
+    return;
+  const int nr = r1 - r0 + 1;
+  const int nc = c1 - c0 + 1;
+  _belief_sat_dirty[i] = true;
+
+  // log of the likelihood ratio against the constant outside the window:
+  // ( (rx - S)^2 - (rx - P)^2 ) / (2 sigma^2)
+  const float rx = rxPower;
+  const float out_dist2 = (rxPower - SENSITIVITY) * (rxPower - SENSITIVITY);
+  const float inv_2var = 1.0 / (2.0 * _sigma_power * _sigma_power);
+
+  // obstacle cells are stored as 0 (-inf in log space) and stay so: no need
+  // for the ref_map here
+  GridMap::Matrix &layer = _rfid_belief_maps[tagLayerName];
+  Eigen::Block<GridMap::Matrix> window = layer.block(r0, c0, nr, nc);
+  Eigen::Block<Eigen::MatrixXf> expected = rxPw_mat.block(r0, c0, nr, nc);
+  Eigen::Block<Eigen::MatrixXf> posterior =
+      _scratch_posterior.topLeftCorner(nr, nc);
+
+  if (_log_belief) {
+    // bayes is a sum in log space: nothing can underflow or overflow
+    forEachColumnBlock(nr, nc, updateThreads, [&](int b, int cb, int ce) {
+      for (int c = cb; c < ce; ++c) {
+        for (int r = 0; r < nr; ++r) {
+          float d = rx - expected(r, c);
+          window(r, c) += (out_dist2 - d * d) * inv_2var;
+        }
+      }
+    });
+    normalizeRFIDLayer(i);
+    return;
+  }
 
-  // this should remove prob at obstcles
-  Eigen::MatrixXf obst_mat = _rfid_belief_maps["ref_map"];
-  likl_mat = (obst_mat.array() == _free_space_val).select(likl_mat, 0);
+  // pass 1: bayes numerator of every window cell and its block partials
+  int blocks =
+      forEachColumnBlock(nr, nc, updateThreads, [&](int b, int cb, int ce) {
+        BayesPartial part = {0.0, 0.0, 0.0f, -INFINITY, true};
+        for (int c = cb; c < ce; ++c) {
+          for (int r = 0; r < nr; ++r) {
+            float d = rx - expected(r, c);
+            float log_ratio = (out_dist2 - d * d) * inv_2var;
+            float prior = window(r, c);
+            float post = prior * std::exp(log_ratio);
+            posterior(r, c) = post;
+            part.prior_mass += prior;
+            part.posterior_mass += post;
+            part.max_posterior = std::max(part.max_posterior, post);
+            part.max_log_ratio = std::max(part.max_log_ratio, log_ratio);
+            part.finite = part.finite and std::isfinite(post);
+          }
+        }
+        _scratch_partials[b] = part;
+      });
+  BayesPartial total = {0.0, 0.0, 0.0f, -INFINITY, true};
+  for (int b = 0; b < blocks; ++b) {
+    const BayesPartial &part = _scratch_partials[b];
+    total.prior_mass += part.prior_mass;
+    total.posterior_mass += part.posterior_mass;
+    total.max_posterior = std::max(total.max_posterior, part.max_posterior);
+    total.max_log_ratio = std::max(total.max_log_ratio, part.max_log_ratio);
+    total.finite = total.finite and part.finite;
+  }
 
-  // normalize in this space:
-  double bayes_den = likl_mat.sum();
-  if (bayes_den > 0) {
-    likl_mat = likl_mat / bayes_den;
-    // now do bayes ...  everywhere
-    _rfid_belief_maps[tagLayerName] =
-        _rfid_belief_maps[tagLayerName].cwiseProduct(likl_mat);
+  if (total.finite and total.max_posterior < MAX_LAZY_BELIEF) {
+    // pass 2: commit the window, normalization is a scalar update
+    forEachColumnBlock(nr, nc, updateThreads, [&](int b, int cb, int ce) {
+      window.middleCols(cb, ce - cb) = posterior.middleCols(cb, ce - cb);
+    });
+    double prev_mass = _layer_mass[i];
+    _layer_mass[i] = std::max(prev_mass - total.prior_mass, 0.0) +
+                     total.posterior_mass;
+    // refresh the running mass when it gets imprecise or out of range
+    if (_layer_mass[i] < prev_mass * 1e-6 or
+        _layer_mass[i] < MIN_LAZY_BELIEF or _layer_mass[i] > MAX_LAZY_BELIEF) {
+      rescaleRFIDLayer(i);
+    } else {
+      normalizeRFIDLayer(i);
+    }
+  } else {
+    // the window alone would overflow: shift the ratio by its max and do
+    // bayes everywhere, cells outside the window get exp(-max) each.
+    const float max_log_ratio = total.max_log_ratio;
+    forEachColumnBlock(nr, nc, updateThreads, [&](int b, int cb, int ce) {
+      for (int c = cb; c < ce; ++c) {
+        for (int r = 0; r < nr; ++r) {
+          float d = rx - expected(r, c);
+          float log_ratio = (out_dist2 - d * d) * inv_2var;
+          window(r, c) *= std::exp(log_ratio - max_log_ratio);
+        }
+      }
+    });
+    const float outside = std::exp(-max_log_ratio);
+    const int rows = layer.rows();
+    const int cols = layer.cols();
+    layer.leftCols(c0) *= outside;
+    layer.rightCols(cols - c1 - 1) *= outside;
+    layer.block(0, c0, r0, nc) *= outside;
+    layer.block(r1 + 1, c0, rows - r1 - 1, nc) *= outside;
+    rescaleRFIDLayer(i);
   }
-  normalizeRFIDLayer(tagLayerName);
 }
 
 double RadarModel::getTotalEntropy(double x, double y, double orientation,
@@ -1370,15 +1742,17 @@ double RadarModel::getTotalEntropy(double x, double y, double orientation,
   double likelihood, neg_likelihood, log2_likelihood, log2_neg_likelihood = 0.0;
 
   std::string tagLayerName = getTagLayerName(tag_i);
+  const GridMap::Matrix &belief = _rfid_belief_maps[tagLayerName];
 
   total_entropy = 0;
   for (iterator; !iterator.isPastEnd(); ++iterator) {
-    _rfid_belief_maps.getPosition(*iterator, point);
+    const Index &index = *iterator;
+    _rfid_belief_maps.getPosition(index, point);
     // check if is inside global map
     if (_rfid_belief_maps.isInside(point)) {
       // We don't add belief from positions considered obstacles...
-      if (_rfid_belief_maps.atPosition("ref_map", point) == _free_space_val) {
-        likelihood = _rfid_belief_maps.atPosition(tagLayerName, point);
+      if ((*_free_mask)(index(0), index(1))) {
+        likelihood = toBelief(belief(index(0), index(1)), tag_i);
         if (isnan(likelihood))
           likelihood = 0.0;
         neg_likelihood = 1 - likelihood;
@@ -1430,6 +1804,52 @@ double RadarModel::getTotalEntropyEllipse(Pose target, double maxX, double minX,
   return getTotalEntropyEllipse(target, el_iterator, tag_i);
 }
 
+double RadarModel::getTotalEntropyEllipseBound(Pose target, double maxX,
+                                               double minX, int tag_i) {
+  // same ellipse as getTotalEntropyEllipse
+  double antennaX = target.getX();
+  double antennaY = target.getY();
+  double antennaHeading = target.getOrientation() * 3.14/180;
+
+  double a =  (abs(maxX) + abs(minX))/2.0;
+  double c =  (abs(maxX) - abs(minX))/2;
+  double b = sqrt((a*a)-(c*c));
+  double xc = antennaX + (c*cos(antennaHeading));
+  double yc = antennaY + (c*sin(antennaHeading));
+
+  // axis aligned box around the tilted ellipse, clipped to the cell centres
+  double cos_h = cos(antennaHeading);
+  double sin_h = sin(antennaHeading);
+  double half_x = sqrt(a * a * cos_h * cos_h + b * b * sin_h * sin_h);
+  double half_y = sqrt(a * a * sin_h * sin_h + b * b * cos_h * cos_h);
+  Position map_center = _rfid_belief_maps.getPosition();
+  Length map_length = _rfid_belief_maps.getLength();
+  double margin = _rfid_belief_maps.getResolution() / 2.0;
+  double min_x = std::max(xc - half_x, map_center.x() - map_length.x() / 2 + margin);
+  double max_x = std::min(xc + half_x, map_center.x() + map_length.x() / 2 - margin);
+  double min_y = std::max(yc - half_y, map_center.y() - map_length.y() / 2 + margin);
+  double max_y = std::min(yc + half_y, map_center.y() + map_length.y() / 2 - margin);
+  if (min_x > max_x or min_y > max_y)
+    return 0.0;
+
+  Index first, last;
+  if (!_rfid_belief_maps.getIndex(Position(max_x, max_y), first) or
+      !_rfid_belief_maps.getIndex(Position(min_x, min_y), last))
+    return INFINITY;
+  int row_start = std::min(first(0), last(0));
+  int row_end = std::max(first(0), last(0));
+  int col_start = std::min(first(1), last(1));
+  int col_end = std::max(first(1), last(1));
+
+  double cells = (double)(row_end - row_start + 1) * (col_end - col_start + 1);
+  double mean = getWindowBelief(tag_i, row_start, col_start, row_end, col_end) / cells;
+  if (!(mean > 0.0))
+    return 0.0;
+  if (mean >= 1.0)
+    return cells;
+  return cells * (-mean * log2(mean) - (1 - mean) * log2(1 - mean));
+}
+
 double RadarModel::getTotalEntropyEllipse(Pose target, grid_map::EllipseIterator iterator,
                                    int tag_i) {
 
@@ -1438,15 +1858,17 @@ double RadarModel::getTotalEntropyEllipse(Pose target, grid_map::EllipseIterator
   double likelihood, neg_likelihood, log2_likelihood, log2_neg_likelihood = 0.0;
 
   std::string tagLayerName = getTagLayerName(tag_i);
+  const GridMap::Matrix &belief = _rfid_belief_maps[tagLayerName];
 
   total_entropy = 0;
   for (iterator; !iterator.isPastEnd(); ++iterator) {
-    _rfid_belief_maps.getPosition(*iterator, point);
+    const Index &index = *iterator;
+    _rfid_belief_maps.getPosition(index, point);
     // check if is inside global map
     if (_rfid_belief_maps.isInside(point)) {
       // We don't add belief from positions considered obstacles...
-      if (_rfid_belief_maps.atPosition("ref_map", point) == _free_space_val) {
-        likelihood = _rfid_belief_maps.atPosition(tagLayerName, point);
+      if ((*_free_mask)(index(0), index(1))) {
+        likelihood = toBelief(belief(index(0), index(1)), tag_i);
         if (isnan(likelihood))
           likelihood = 0.0;
         neg_likelihood = 1 - likelihood;
@@ -1503,36 +1925,6 @@ void RadarModel::printEllipse(double x, double y, double orient_rad, double maxX
   getImage(&_rfid_belief_maps, "ellipse_test", fileURI);
 }
 
-double RadarModel::getTotalKL(double x, double y, double orientation,
-                              double size_x, double size_y, int tag_i) {
-  // TODO: I'm not using the orientation. Maybe it would be better to use a
-  // polygon iterator,
-  //     so we can rotate edges around the center and have a more flexible thing
-
-  // submapStartIndex the start index of the submap, typically top-left index.
-  grid_map::Index submapStartIndex, submapEndIndex, submapBufferSize;
-  grid_map::Position submapStartPosition(x + (size_x / 2), y + (size_y / 2));
-  grid_map::Position submapEndPosition(x - (size_x / 2), y - (size_y / 2));
-
-  if (!_rfid_belief_maps.getIndex(submapStartPosition, submapStartIndex)) {
-    submapStartIndex = grid_map::Index(0, 0);
-    // std::cout<<"Clip start!" << std::endl;
-  }
-
-  if (!_rfid_belief_maps.getIndex(submapEndPosition, submapEndIndex)) {
-    Size siz = _rfid_belief_maps.getSize();
-    submapEndIndex = grid_map::Index(siz(0) - 1, siz(1) - 1);
-    // std::cout<<"Clip end!" << std::endl;
-  }
-
-  submapBufferSize = submapEndIndex - submapStartIndex;
-
-  grid_map::SubmapIterator iterator(_rfid_belief_maps, submapStartIndex,
-                                    submapBufferSize);
-
-  return getTotalKL(x, y, orientation, iterator, tag_i);
-}
-
 // Adapted from
 // https://gitlab.math.ethz.ch/NumCSE/NumCSE/blob/3c723d06ffacab3dc45726ad0a95e33987dc35aa/Utils/meshgrid.hpp
 
@@ -1575,187 +1967,111 @@ void RadarModel::meshgrid(const Eigen::Matrix<Scalar, 1, -1>& x,
                                yt = y.transpose();
   meshgrid(xt, yt, X, Y);
 }
-double RadarModel::getTotalKL(double x, double y, double orientation,
-                              grid_map::SubmapIterator iterator, int tag_i) {
 
-  double total_KL, tmp_KL = 0.0;
+void RadarModel::addHypotheticalMeasurement(double x_m, double y_m,
+                                            double orientation_deg,
+                                            double rxPower, double freq,
+                                            int tag_i, double len_update,
+                                            BeliefOverlay *overlay) {
+  // square of cells around the robot, each axis clipped to the cell centres
+  Position map_center = _rfid_belief_maps.getPosition();
+  Length map_length = _rfid_belief_maps.getLength();
+  double margin = _rfid_belief_maps.getResolution() / 2.0;
+  double min_x = std::max(x_m - len_update / 2, map_center.x() - map_length.x() / 2 + margin);
+  double max_x = std::min(x_m + len_update / 2, map_center.x() + map_length.x() / 2 - margin);
+  double min_y = std::max(y_m - len_update / 2, map_center.y() - map_length.y() / 2 + margin);
+  double max_y = std::min(y_m + len_update / 2, map_center.y() + map_length.y() / 2 - margin);
+  grid_map::Index start(0, 0), end(-1, -1);
+  if (min_x <= max_x and min_y <= max_y) {
+    _rfid_belief_maps.getIndex(Position(max_x, max_y), start);
+    _rfid_belief_maps.getIndex(Position(min_x, min_y), end);
+  }
+  const int nr = std::max(0, end(0) - start(0) + 1);
+  const int nc = std::max(0, end(1) - start(1) + 1);
+
+  const GridMap::Matrix &layer = _rfid_belief_maps[getTagLayerName(tag_i)];
+  const auto &free_mask = *_free_mask;
+  const double orientation_rad = orientation_deg * M_PI / 180.0;
+  // log of the likelihood ratio against the cells where the tag can't be
+  // read, as in addMeasurement
+  const double out_dist2 = (rxPower - SENSITIVITY) * (rxPower - SENSITIVITY);
+  const double inv_2var = 1.0 / (2.0 * _sigma_power * _sigma_power);
+  Eigen::MatrixXf &log_ratio = overlay->posterior;
+  log_ratio.setConstant(nr, nc, -INFINITY);
+  double max_log_ratio = 0.0; // the cells out of the window have ratio 1
+  double prior_mass = 0.0;
   Position point;
-  double prior, posterior = 0.0;
-
-  std::string tagLayerName = getTagLayerName(tag_i);
-
-  for (iterator; !iterator.isPastEnd(); ++iterator) {
-    _rfid_belief_maps.getPosition(*iterator, point);
-    // check if is inside global map
-    if (_rfid_belief_maps.isInside(point)) {
-      // We don't add belief from positions considered obstacles...
-      if (_rfid_belief_maps.atPosition("ref_map", point) == _free_space_val) {
-        prior = _rfid_belief_maps.atPosition(tagLayerName, point);
-        posterior = _rfid_belief_maps.atPosition("kl", point);
-        tmp_KL = posterior * log(posterior / prior);
-        if (isnan(tmp_KL))
-          tmp_KL = 0;
-        total_KL += tmp_KL;
-        // cout << "Prior: " << prior << endl;
-        // cout << "Posterior: " << posterior << endl;
-        // cout << "totalKL: " << total_KL << endl;
-      }
+  for (int c = 0; c < nc; ++c) {
+    for (int r = 0; r < nr; ++r) {
+      const int row = start(0) + r, col = start(1) + c;
+      if (!free_mask(row, col))
+        continue;
+      _rfid_belief_maps.getPosition(grid_map::Index(row, col), point);
+      // clamped as in getFriisMat: the unreadable cells keep a ratio of 1
+      double expected = std::max(
+          received_power_friis_with_obstacles(x_m, y_m, orientation_rad,
+                                              point.x(), point.y(), 0, freq),
+          SENSITIVITY);
+      double d = rxPower - expected;
+      log_ratio(r, c) = (out_dist2 - d * d) * inv_2var;
+      max_log_ratio = std::max(max_log_ratio, (double)log_ratio(r, c));
+      prior_mass += toBelief(layer(row, col), tag_i);
     }
   }
-  return total_KL;
-}
 
-void RadarModel::addTmpMeasurementRFIDCriterion(double x_m, double y_m,
-                                                double orientation_deg,
-                                                double rxPower, double phase,
-                                                double freq, int i,
-                                                double len_update) {
-
-  // cout << "computeKL: " << computeKL << endl;
-  double rel_x, rel_y, prob_val, orientation_rad;
-  double glob_x, glob_y, delt_x, delt_y;
-  Position rel_point, glob_point;
-  grid_map::Polygon update_edges;
-
-  double prior, posterior, likelihood, bayes_num, bayes_den;
-  Eigen::MatrixXf prob_mat;
-  std::string tagLayerName = getTagLayerName(i);
-
-  _rfid_belief_maps.add("kl", 0.0);
-
-  // First we get the Probability distribution associated with (
-  // rxPower,phase,freq) using our defined active area grids
-  if (rxPower > SENSITIVITY) {
-    prob_mat = getPowProbCondRFIDCriterion(
-        rxPower, freq); //.cwiseProduct(getPhaseProbCond(phase, freq));
-                        // } else{
-    //   prob_mat = getNegProb(getPowLayerName(freq), rxPower,
-    //   _sigma_power);//.cwiseProduct(getPhaseProbCond(phase, freq));
-    // //   if (i == 0){
-    // //     cout << "Neg: " << prob_mat.sum() << endl;
-    // //   }
-    // }
-
-    // We store this data matrix in a temporal layer
-    this->createTempProbLayerRFIDCriterion(
-        prob_mat, x_m, y_m, orientation_deg,
-        len_update); // size of the activeArea
-
-    // so we need to translate this matrix to robot pose and orientation
-    orientation_rad = orientation_deg * M_PI / 180.0;
-    // We ned to normalise the new probability over the entire grid, so
-    // we need to multiple all the priors for all the new measurements
-    // and this will be our denominator while applying Bayes
-    // NB: posterior = likelihood * prior / normalizing_factor
-    // where normalisizing_factor is a sum over all the grid of likelihood *
-    // prior bayes_den = getNormalizingFactorBayesRFIDActiveArea(x_m, y_m,
-    // orientation_rad, tagLayerName);  // computed on the entire activeArea
-    // if (bayes_den != 0.0 and !isnan(bayes_den)){
-    // Now we can proceed with the update
-    update_edges = getSubMapEdges(
-        x_m, y_m, orientation_rad,
-        len_update); // NOTE: update computed only on a small subset
-    for (grid_map::PolygonIterator iterator(_rfid_belief_maps, update_edges);
-         !iterator.isPastEnd(); ++iterator) {
-      // check if point is an obstacle:
-      if (_rfid_belief_maps.at("ref_map", *iterator) == _free_space_val) {
-        // get the relative point
-        _rfid_belief_maps.getPosition(*iterator, glob_point);
-        // rel_point = getRelPoint(glob_point, x_m, y_m, orientation_rad);
-        
-        // We probably don't need this anymore after dropping activemap
-        // rel_point = getSubMapRelPoint(glob_point, x_m, y_m, orientation_rad,
-        //                               len_update);
-        likelihood =
-            _tmp_rfid_c_map.atPosition("temp", rel_point); // the measurement
-        prior = _rfid_belief_maps.at(tagLayerName,
-                                     *iterator); // the value in the map
-        bayes_num = prior * likelihood;
-        // posterior = bayes_num / bayes_den;
-        _rfid_belief_maps.at("kl", *iterator) = bayes_num;
-      } else {
-        // this shouldn't be necessary ....
-        _rfid_belief_maps.at(tagLayerName, *iterator) = 0;
+  // bayes, shifted by the max log ratio so no exp overflows
+  double outside = (1.0 - prior_mass) * std::exp(-max_log_ratio);
+  double norm = std::max(outside, 0.0);
+  for (int c = 0; c < nc; ++c) {
+    for (int r = 0; r < nr; ++r) {
+      float &cell = log_ratio(r, c);
+      if (cell == -INFINITY) {
+        cell = 0.0;
+        continue;
       }
+      double prior = toBelief(layer(start(0) + r, start(1) + c), tag_i);
+      cell = prior * std::exp(cell - max_log_ratio);
+      norm += cell;
     }
-    // }
   }
-}
-
-Eigen::MatrixXf RadarModel::getPowProbCondRFIDCriterion(double rxPw,
-                                                        double f_i) {
-  // probability of receiving less than X1 in every cell
-  Eigen::MatrixXf x1_mat = getNegProbRFIDCriterion(rxPw, _sigma_power);
-  // std::cout << "x1_mat: " << x1_mat.sum()/(siz(0)*siz(1)) << endl;
-
-  // probability of receiving between X1 and X2 in every cell
-  Eigen::MatrixXf ans = (x1_mat).array().abs();
-
-  return ans;
-}
-
-void RadarModel::createTempProbLayerRFIDCriterion(Eigen::MatrixXf prob_mat,
-                                                  double x_m, double y_m,
-                                                  double orientation_deg,
-                                                  double len_update) {
-  double orientation_rad;
-  Position rel_point, glob_point;
-  grid_map::Polygon update_edges;
-
-  // We store this data matrix in a temporal layer
-  // Here, boundaries are relative to position (0,0,0º): p1 (nx/2,ny/2) ,
-  // pcreateTempProbLayerRFIDCriterion2 (-nx/2, ny/2), p3 (-nx/2,-ny/2), p4
-  // (nx/2,-ny/2)
-  _tmp_rfid_c_map.add("temp", prob_mat);
-  // now we remove from this layer probabilities inside obstacle cells
-  // so we need to translate this matrix to robot pose and orientation
-  orientation_rad = orientation_deg * M_PI / 180.0;
-  update_edges = getSubMapEdges(x_m, y_m, orientation_rad, len_update);
-
-  for (grid_map::PolygonIterator iterator(_rfid_belief_maps, update_edges);
-       !iterator.isPastEnd(); ++iterator) {
-    // check if it's an obstacle:
-    if (_rfid_belief_maps.at("ref_map", *iterator) != _free_space_val) {
-      _rfid_belief_maps.getPosition(*iterator, glob_point);
-      // We don't need this anymore without active area
-      // rel_point =
-      //     getSubMapRelPoint(glob_point, x_m, y_m, orientation_rad, len_update);
-      // remove prob in obstacles
-      _tmp_rfid_c_map.atPosition("temp", rel_point) = 0.0;
-    }
+  overlay->tag_i = tag_i;
+  overlay->start = start;
+  overlay->prior_mass = prior_mass;
+  if (norm > 0) {
+    overlay->posterior /= (float)norm;
+    overlay->outside_scale = std::exp(-max_log_ratio) / norm;
+  } else {
+    overlay->outside_scale = 1.0;
   }
 }
 
-Eigen::MatrixXf RadarModel::getNegProbRFIDCriterion(double x, double sigm) {
-  Eigen::MatrixXf friis_mat = _tmp_rfid_c_map["temp"];
-  // gaussian cdp
-  // cdp(x,mu,sigma) = 0.5 * ( 1 + erf( (x - mu) / (sigma * sqrt(2)) )
-  Eigen::MatrixXf erf_mat = (x - friis_mat.array()) / (sigm * sqrt(2.0));
-  erf_mat = 0.5 + 0.5 * erf_mat.array().erf();
-  return erf_mat;
-}
-
-grid_map::Polygon RadarModel::getSubMapEdges(double robot_x, double robot_y,
-                                             double robot_head, double len) {
-  grid_map::Polygon polygon;
-
-  // trying not to replicate code, I'm using the cv points one that works
-  cv::Point cvrobot = getPoint(robot_x, robot_y);
-  cv::Point pts[4];
-  pts[0] = getPoint(robot_x - len / 2, robot_y - len / 2);
-  pts[1] = getPoint(robot_x - len / 2, robot_y + len / 2);
-  pts[2] = getPoint(robot_x + len / 2, robot_y + len / 2);
-  pts[3] = getPoint(robot_x + len / 2, robot_y - len / 2);
-
-  rotatePoints(pts, 4, cvrobot.x, cvrobot.y, robot_head);
-
-  // cast to gridmap points and add to polygon
-  polygon.setFrameId(_rfid_belief_maps.getFrameId());
-  for (int i = 0; i < 4; i++) {
-    polygon.addVertex(fromPoint(pts[i]));
+double RadarModel::getBelief(const BeliefOverlay &overlay,
+                             const grid_map::Index &index) {
+  grid_map::Index cell = index - overlay.start;
+  if (cell(0) >= 0 and cell(0) < overlay.posterior.rows() and cell(1) >= 0 and
+      cell(1) < overlay.posterior.cols())
+    return overlay.posterior(cell(0), cell(1));
+  return getBelief(overlay.tag_i, index) * overlay.outside_scale;
+}
+
+double RadarModel::getTotalKL(const BeliefOverlay &overlay) {
+  const GridMap::Matrix &layer =
+      _rfid_belief_maps[getTagLayerName(overlay.tag_i)];
+  double total_KL = 0.0;
+  for (int c = 0; c < overlay.posterior.cols(); ++c) {
+    for (int r = 0; r < overlay.posterior.rows(); ++r) {
+      double posterior = overlay.posterior(r, c);
+      double prior = toBelief(
+          layer(overlay.start(0) + r, overlay.start(1) + c), overlay.tag_i);
+      if (posterior > 0 and prior > 0)
+        total_KL += posterior * std::log(posterior / prior);
+    }
   }
-
-  return polygon;
+  // out of the window the posterior is the prior times a constant
+  double s = overlay.outside_scale;
+  if (s > 0)
+    total_KL += (1.0 - overlay.prior_mass) * s * std::log(s);
+  return total_KL;
 }
 
 // Position RadarModel::getSubMapRelPoint(Position glob_point, double x_m,
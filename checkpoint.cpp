@@ -0,0 +1,204 @@
+#include "checkpoint.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// File layout, all in native byte order:
+//   "MCDMCKPT" | uint32 version | uint32 number of sections
+// then for every section:
+//   uint32 name length | uint32 flags | uint64 stored size | name | payload
+// with the name and the payload padded to 8 bytes.
+static const char MAGIC[8] = {'M', 'C', 'D', 'M', 'C', 'K', 'P', 'T'};
+static const uint32_t FLAG_RLE = 1;
+
+const uint32_t Checkpoint::VERSION;
+
+static inline size_t padded(size_t size)
+{
+  return (size + 7) & ~(size_t)7;
+}
+
+// Run-length encoding of 32-bit words: uint64 raw size, then (count, word)
+// pairs covering the whole words, then the trailing bytes as they are
+static void encodeRLE(const char *data, size_t size, std::vector<char> *out)
+{
+  uint64_t rawSize = size;
+  out->assign((const char *)&rawSize, (const char *)&rawSize + sizeof(rawSize));
+  size_t numWords = size / 4;
+  size_t i = 0;
+  while (i < numWords) {
+    uint32_t word, next;
+    std::memcpy(&word, data + 4 * i, 4);
+    uint32_t count = 1;
+    while (i + count < numWords && count < UINT32_MAX) {
+      std::memcpy(&next, data + 4 * (i + count), 4);
+      if (next != word) break;
+      count++;
+    }
+    out->insert(out->end(), (const char *)&count, (const char *)&count + 4);
+    out->insert(out->end(), (const char *)&word, (const char *)&word + 4);
+    i += count;
+  }
+  out->insert(out->end(), data + 4 * numWords, data + size);
+}
+
+static bool decodeRLE(const char *data, size_t size, std::vector<char> *out)
+{
+  uint64_t rawSize;
+  if (size < sizeof(rawSize)) return false;
+  std::memcpy(&rawSize, data, sizeof(rawSize));
+  const char *p = data + sizeof(rawSize), *end = data + size;
+  size_t numWords = rawSize / 4;
+  out->resize(rawSize);
+  size_t i = 0;
+  while (i < numWords) {
+    if (end - p < 8) return false;
+    uint32_t count;
+    std::memcpy(&count, p, 4);
+    if (count == 0 || count > numWords - i) return false;
+    for (uint32_t k = 0; k < count; k++, i++)
+      std::memcpy(&(*out)[4 * i], p + 4, 4);
+    p += 8;
+  }
+  if ((size_t)(end - p) != rawSize % 4) return false;
+  std::memcpy(&(*out)[4 * numWords], p, rawSize % 4);
+  return true;
+}
+
+Checkpoint::Checkpoint()
+{
+}
+
+Checkpoint::~Checkpoint()
+{
+}
+
+void Checkpoint::put(const std::string &name, const void *data, size_t size, bool compress)
+{
+  std::shared_ptr<std::vector<char> > buffer(new std::vector<char>((const char *)data, (const char *)data + size));
+  buffers.push_back(buffer);
+  Section section = {buffer->data(), size, compress};
+  sections[name] = section;
+}
+
+bool Checkpoint::get(const std::string &name, const void **data, size_t *size) const
+{
+  std::map<std::string, Section>::const_iterator it = sections.find(name);
+  if (it == sections.end()) return false;
+  *data = it->second.data;
+  *size = it->second.size;
+  return true;
+}
+
+bool Checkpoint::save(const std::string &fileURI) const
+{
+  std::string tmpURI = fileURI + ".tmp";
+  std::ofstream out(tmpURI.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!out) return false;
+  static const char zeros[8] = {0};
+  uint32_t version = VERSION;
+  uint32_t numSections = sections.size();
+  out.write(MAGIC, sizeof(MAGIC));
+  out.write((const char *)&version, sizeof(version));
+  out.write((const char *)&numSections, sizeof(numSections));
+  std::vector<char> encoded;
+  for (std::map<std::string, Section>::const_iterator it = sections.begin(); it != sections.end(); it++) {
+    const char *payload = it->second.data;
+    uint64_t storedSize = it->second.size;
+    uint32_t flags = 0;
+    if (it->second.compress) {
+      encodeRLE(it->second.data, it->second.size, &encoded);
+      // keep the raw bytes when they are smaller, so they can be read in place
+      if (encoded.size() < it->second.size) {
+        payload = encoded.data();
+        storedSize = encoded.size();
+        flags |= FLAG_RLE;
+      }
+    }
+    uint32_t nameLength = it->first.size();
+    out.write((const char *)&nameLength, sizeof(nameLength));
+    out.write((const char *)&flags, sizeof(flags));
+    out.write((const char *)&storedSize, sizeof(storedSize));
+    out.write(it->first.data(), nameLength);
+    out.write(zeros, padded(nameLength) - nameLength);
+    out.write(payload, storedSize);
+    out.write(zeros, padded(storedSize) - storedSize);
+  }
+  out.close();
+  if (!out) {
+    std::remove(tmpURI.c_str());
+    return false;
+  }
+  return std::rename(tmpURI.c_str(), fileURI.c_str()) == 0;
+}
+
+bool Checkpoint::load(const std::string &fileURI)
+{
+  clear();
+  int fd = open(fileURI.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MAGIC) + 8) {
+    close(fd);
+    return false;
+  }
+  size_t size = st.st_size;
+  void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) return false;
+  mapping = std::shared_ptr<const char>((const char *)data, [size](const char *p) { munmap((void *)p, size); });
+
+  const char *p = mapping.get(), *end = mapping.get() + size;
+  uint32_t version, numSections;
+  std::memcpy(&version, p + sizeof(MAGIC), sizeof(version));
+  std::memcpy(&numSections, p + sizeof(MAGIC) + 4, sizeof(numSections));
+  if (std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION) {
+    clear();
+    return false;
+  }
+  p += sizeof(MAGIC) + 8;
+  for (uint32_t i = 0; i < numSections; i++) {
+    uint32_t nameLength, flags;
+    uint64_t storedSize;
+    if (end - p < 16) {
+      clear();
+      return false;
+    }
+    std::memcpy(&nameLength, p, 4);
+    std::memcpy(&flags, p + 4, 4);
+    std::memcpy(&storedSize, p + 8, 8);
+    p += 16;
+    if ((size_t)(end - p) < padded(nameLength) || (size_t)(end - p) - padded(nameLength) < storedSize) {
+      clear();
+      return false;
+    }
+    std::string name(p, nameLength);
+    p += padded(nameLength);
+    Section section = {p, (size_t)storedSize, (flags & FLAG_RLE) != 0};
+    if (flags & FLAG_RLE) {
+      std::shared_ptr<std::vector<char> > buffer(new std::vector<char>());
+      if (!decodeRLE(p, storedSize, buffer.get())) {
+        clear();
+        return false;
+      }
+      buffers.push_back(buffer);
+      section.data = buffer->data();
+      section.size = buffer->size();
+    }
+    sections[name] = section;
+    p += std::min((size_t)(end - p), padded(storedSize));
+  }
+  return true;
+}
+
+void Checkpoint::clear()
+{
+  sections.clear();
+  buffers.clear();
+  mapping.reset();
+}
@@ -2,6 +2,7 @@
 #include <functional>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 
 
 using namespace std;
@@ -17,13 +18,15 @@ EvaluationRecords::~EvaluationRecords()
 
 void EvaluationRecords::putEvaluation(Pose& frontier, double value)
 {
-    if(evaluations.empty()){
+    if(poses.empty()){
 		minValue = value;
 		maxValue = value;
     }
     
-    string s =getEncodedKey(frontier);
-    evaluations.emplace(s,value);
+    if(indices.emplace(PoseKey(frontier),(int)poses.size()).second){
+	poses.push_back(frontier);
+	values.push_back(value);
+    }
 
     if(value >= maxValue)
 		maxValue = value;
@@ -35,92 +38,125 @@ void EvaluationRecords::putEvaluation(Pose& frontier, double value)
 
 double EvaluationRecords::getEvaluation(Pose& frontier)
 {
-    string s = getEncodedKey(frontier);
-    return evaluations[s];
+    unordered_map<PoseKey,int>::const_iterator got = indices.find(PoseKey(frontier));
+    if (got == indices.end()){
+	return 0.0;
+    }
+    return values[got->second];
 }
 
 unordered_map<string, double> EvaluationRecords::getEvaluations()
 {
+    unordered_map<string, double> evaluations;
+    evaluations.reserve(indices.size());
+    for(int i = 0; i < (int)poses.size(); i++){
+	evaluations.emplace(getEncodedKey(poses[i]), values[i]);
+    }
     return evaluations;
 }
 
 bool EvaluationRecords::contains(Pose& frontier)
 {
-    string s = getEncodedKey(frontier);
-    unordered_map<string,double>::const_iterator got = evaluations.find(s);
-    if (got == evaluations.end()){
-	return false;
-    }else return true;
+    return indices.find(PoseKey(frontier)) != indices.end();
 }
 
 int EvaluationRecords::size()
 {
-    return evaluations.size();
+    return poses.size();
 }
 
 
 
 std::list<Pose> EvaluationRecords::getFrontiers() 
 {
-    
-    vector<string> list;
-    list.reserve(evaluations.size());
-
-    for(unordered_map<string,double>::iterator it = evaluations.begin(); it != evaluations.end(); it++ ) {
-	list.push_back((*it).first);
-	
-    } 
-    
+    // the ranked alternatives, best first, for the backtracking graph
+    vector<pair<Pose,double> > ranked = getTopK(poses.size());
     std::list<Pose> toRet ;
+    for(vector<pair<Pose,double> >::iterator it = ranked.begin(); it != ranked.end(); it++){
+	toRet.push_back(it->first);
+    }
 
-    for(vector<string>::iterator it = list.begin(); it != list.end(); it++){
-	// create a pose object for every string string in the list
-	
-	string s = *it;
-	Pose p = getPoseFromEncoding(s);
-	
-	toRet.push_back(p);
+    return toRet;
+}
+
+pair<Pose, double> EvaluationRecords::getBest() const
+{
+    if(poses.empty()){
+	return make_pair(Pose(), 0.0);
+    }
+    int best = 0;
+    for(int i = 1; i < (int)values.size(); i++){
+	if(values[i] > values[best]) best = i;
     }
+    return make_pair(poses[best], values[best]);
+}
+
+vector<pair<Pose, double> > EvaluationRecords::getTopK(int k) const
+{
+    int n = values.size();
+    if(k > n) k = n;
+    vector<pair<Pose, double> > toRet;
+    if(k <= 0) return toRet;
+
+    // a frontier ranks before another if it has a higher utility or,
+    // with the same utility, if it was inserted first
+    auto ranksBefore = [this](int a, int b){
+	return values[a] > values[b] || (values[a] == values[b] && a < b);
+    };
+    // heap of the k best frontiers seen so far, with the worst on top
+    vector<int> heap;
+    heap.reserve(k);
+    for(int i = 0; i < n; i++){
+	if((int)heap.size() < k){
+	    heap.push_back(i);
+	    push_heap(heap.begin(), heap.end(), ranksBefore);
+	}else if(ranksBefore(i, heap.front())){
+	    pop_heap(heap.begin(), heap.end(), ranksBefore);
+	    heap.back() = i;
+	    push_heap(heap.begin(), heap.end(), ranksBefore);
+	}
+    }
+    sort_heap(heap.begin(), heap.end(), ranksBefore);
 
+    toRet.reserve(k);
+    for(vector<int>::iterator it = heap.begin(); it != heap.end(); it++){
+	toRet.push_back(make_pair(poses[*it], values[*it]));
+    }
     return toRet;
 }
 
+const vector<Pose>& EvaluationRecords::getPoses() const
+{
+    return poses;
+}
 
+const vector<double>& EvaluationRecords::getValues() const
+{
+    return values;
+}
 
 
 void EvaluationRecords::removeFrontier(Pose& frontier)
 {        
-    for(unordered_map<string,double>::iterator it = evaluations.begin(); it != evaluations.end(); it++){
-	string s1 = (*it).first;
-	string s2 = getEncodedKey(frontier);
-	if( s1 == s2 ){
-	    evaluations.erase(s2);
-	    break;
-	}
+    unordered_map<PoseKey,int>::iterator got = indices.find(PoseKey(frontier));
+    if(got == indices.end()) return;
+    int index = got->second;
+    indices.erase(got);
+    // move the last frontier into the freed slot
+    int last = poses.size() - 1;
+    if(index != last){
+	poses[index] = poses[last];
+	values[index] = values[last];
+	indices[PoseKey(poses[index])] = index;
     }
+    poses.pop_back();
+    values.pop_back();
 }
 
 void EvaluationRecords::normalize(){
-    vector<string> list ;
-    list.reserve(evaluations.size());
-
-    for(unordered_map<string,double>::iterator it = evaluations.begin(); it != evaluations.end(); it++ ) {
-	list.push_back((*it).first);
-    } 
-    
-    for(vector<string>::iterator it = list.begin(); it != list.end(); it++ ){
-	for(unordered_map<string,double>::iterator it2 = evaluations.begin(); it2 != evaluations.end(); it2++){
-	    if ((*it) == (*it2).first){
-		double value = (*it2).second;
-		value = (value - minValue)/(maxValue-minValue);
-		evaluations.erase((*it2).first);
-		pair<string,double> newPair (*it, value);
-		evaluations.insert(newPair);
-	     }
-	 }
+    for(vector<double>::iterator it = values.begin(); it != values.end(); it++){
+	*it = (*it - minValue)/(maxValue-minValue);
     }
-
-
 }
 
 string EvaluationRecords::getEncodedKey(Pose& p)
@@ -13,8 +13,11 @@ class RFIDCriterion : public Criterion {
 public:
   RFIDCriterion(double weight);
   virtual ~RFIDCriterion();
-  double evaluate(Pose &p, dummy::Map *map, RFID_tools *rfid_tools,
+  double computeEvaluation(Pose &p, dummy::Map *map, RFID_tools *rfid_tools,
                   double *batteryTime);
+  bool isExpensive() const { return true; };
+  void computeBounds(Pose &p, dummy::Map *map, RFID_tools *rfid_tools,
+                     double *batteryTime, double &lower, double &upper);
 
 private:
   void normalize(long minSensedX, int number);
@@ -56,8 +59,9 @@ private:
                                    RFID_tools *rfid_tools);
 
     /**
-   * We sum the KL divergence for all cells available in a given submap (5x5) around
-   * the robot for all the belief maps
+   * We sum the KL divergence between the belief maps and their posterior
+   * after a measurement taken from the pose. The posteriors are built in
+   * overlays, so the belief maps are not modified
    *
    * @param p: the current pose of the robot
    * @param map: the reference to the map
@@ -66,10 +70,6 @@ private:
    */
   double evaluateKLDivergence(Pose &p, dummy::Map *map,
                                    RFID_tools *rfid_tools);
-
-protected:
-  double RFIDInfoGain = 0.0;
-  double tmp_belief = 0.0;
 };
 
 #endif // RFIDCRITERION_H
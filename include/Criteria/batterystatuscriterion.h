@@ -30,18 +30,14 @@ class BatteryStatusCriterion :  public Criterion
     public:
 	BatteryStatusCriterion(double weight);
 	~BatteryStatusCriterion();
-	double evaluate( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime);
+	double computeEvaluation( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime);
+	bool isExpensive() const { return true; };
+	void computeBounds( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime, double &lower, double &upper);
 	//only for testing purpose
 	//void insertEvaluation(Pose &p, double value);
 
 	protected:
 	Astar astar;
-	double distance = 0.0;
-    double numOfTurning = 0.0;
-	double translTime = 0.0;
-    double rotTime = 0.0;
-    double timeRequired = 0.0;
-    double remainingBattery = 0.0;
 };
 
 
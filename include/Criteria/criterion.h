@@ -19,7 +19,9 @@
 #define CRITERION_H
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include "pose.h"
+#include "posekey.h"
 #include "map.h"
 #include "RadarModel.hpp"
 #include "constants.h"
@@ -36,21 +38,62 @@ class Criterion
 	~Criterion();
 
 	//Other methods
-	virtual double evaluate( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime) {};
+	/**
+	 * Compute the criterion for a pose and record it in the evaluation map.
+	 *
+	 * @return the raw (not normalized) value of the criterion
+	 */
+	virtual double evaluate( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime);
+
+	/**
+	 * Compute the raw value of the criterion for a pose without recording it.
+	 * Subclasses implement the criterion here. It must be reentrant: it is
+	 * called concurrently for different poses, so it may only read the map
+	 * and the RFID tools and keep its scratch in locals.
+	 */
+	virtual double computeEvaluation( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime) { return 0.0; };
+
+	/**
+	 * Tell if the criterion is costly to compute (path planning, belief
+	 * integration): in a time-budgeted evaluation these are computed last,
+	 * for the most promising candidates first.
+	 */
+	virtual bool isExpensive() const { return false; };
+
+	/**
+	 * Bound the value computeEvaluation would return for a pose, at a
+	 * fraction of its cost. Used to prune candidates before computing the
+	 * expensive criteria. The default bounds are [-inf, +inf].
+	 *
+	 * @param lower: set to a value <= computeEvaluation(p, ...)
+	 * @param upper: set to a value >= computeEvaluation(p, ...)
+	 */
+	virtual void computeBounds( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime, double &lower, double &upper);
 	double getEvaluation(Pose &p) const;
 	void insertEvaluation(Pose &p, double value);
 	void clean();
 	void normalize();
 
+	/**
+	 * Normalize in place a column of raw values, one per candidate, against
+	 * the running extremes of this criterion (updated with the column first,
+	 * as insertEvaluation does for single values).
+	 *
+	 * @param values: the raw values, overwritten with the normalized ones
+	 * @param size: the number of values
+	 */
+	void normalize(double *values, int size);
+
 	//Setters and getters
 	string getName() ;
 	double getWeight() ;
+	bool isHighGood() const;
 	void setName( string name);
 	void setWeight(double weight);
     private:
 	void normalizeHighGood();
 	void normalizeLowGood();
-	string getEncodedKey(Pose &p);
+	void updateExtremes(double value);
 
   protected:
 	string name;
@@ -59,7 +102,9 @@ class Criterion
 	double maxValue, minValue;
 
   private:
-	unordered_map<string , double> evaluation;
+	//the recorded raw values, with their position by pose
+	vector<double> evaluation;
+	unordered_map<PoseKey , int> indices;
 };
 
 #endif // CRITERION_H
@@ -28,7 +28,7 @@ class SensingTimeCriterion : public Criterion
 public:
 SensingTimeCriterion(double weight);
 ~SensingTimeCriterion();
-double evaluate( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime);
+double computeEvaluation( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime);
 
 //only for testing purpose
 //void insertEvaluation(Pose &p, double value);
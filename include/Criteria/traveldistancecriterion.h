@@ -28,12 +28,13 @@ class TravelDistanceCriterion :  public Criterion
     public:
 	TravelDistanceCriterion(double weight);
 	~TravelDistanceCriterion();
-	double evaluate( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime);
+	double computeEvaluation( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime);
+	bool isExpensive() const { return true; };
+	void computeBounds( Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime, double &lower, double &upper);
 	//only for testing purpose
 	//void insertEvaluation(Pose &p, double value);
 	protected:
 	Astar astar;
-    double distance = 0.0;
 };
 
 #endif // TRAVELDISTANCECRITERION_H
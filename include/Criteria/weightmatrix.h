@@ -23,6 +23,27 @@ public:
     void insertCombinationWeight(const std::string &encoding, double weight);
     double getWeight(std::list< std::string > criteriaNames);
     double getWeight(const std::string &encoding) ;
+    double getWeight(unsigned int mask);
+
+    /**
+     * Get the capacity used by the Choquet integral for a set of criteria,
+     * with the same rules as getWeight(list<string>): the set of all the
+     * active criteria weighs 1, missing combinations fall back to the sum of
+     * their single weights and the result is capped to 1.
+     *
+     * @param mask: the set of criteria, bit i is the criterion encoded 'A'+i
+     * @return the capacity of the set
+     */
+    inline double getCapacity(unsigned int mask) const { return resolvedCapacities[mask]; }
+
+    /**
+     * Get the bit associated with a criterion in the capacity table
+     *
+     * @param name: the name of the criterion
+     * @return a mask with only the bit of that criterion set
+     */
+    unsigned int getCriterionMask(const std::string &name);
+    unsigned int computeEncodingMask(const std::string &encoding) const;
     std::string getNameEncoding(std::string name) ;
     std::string computeNamesEncoding(std::list<std::string> criteriaNames);
     std::list<std::string> getKnownCriteria() ;
@@ -35,11 +56,17 @@ private:
     //This member maps a criterion name with its encoding
     std::unordered_map<std::string, std::string> mapping;
 
-    //This is the double entrance table that contains all the weight.
-    // - the index of the list indicate the cardinality of the weight combination.
-    // - the Hash contains the pairs criteria_combination<->weight
-    // NOTE: all the keys of the String must be sorted by lexicographic order.
-    std::vector<std::unordered_map<std::string, double> *> *weights;
+    //Recompute resolvedCapacities after a change of weights or activation
+    void resolveCapacities();
+
+    //This is the table that contains all the weights (the fuzzy measure).
+    // - the index is the bitmask of the combination: bit i is the criterion encoded 'A'+i
+    // - knownCapacities tells which combinations were inserted
+    std::vector<double> capacities;
+    std::vector<bool> knownCapacities;
+    //capacities with the getWeight() rules applied, read by the aggregation
+    std::vector<double> resolvedCapacities;
+    int numOfCriteria;
     std::vector<std::pair<std::string, bool> > activeCriteria;
     int numOfActiveCriteria;
     int lastInsertedCriteria;
@@ -35,6 +35,8 @@ public:
     double lengthPath(string path );
     string pathFind( const int& xStart, const int& yStart, const int& xFinish, const int& yFinish, dummy::Map *originalMap );
     int getNumberOfTurning(string path);
+    // length of the shortest path without obstacles (octile distance): lengthPath of a found path is never below it
+    double lengthLowerBound( const int& xStart, const int& yStart, const int& xFinish, const int& yFinish );
 
 };
 #endif
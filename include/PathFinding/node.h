@@ -44,7 +44,7 @@ public:
     void nextLevel(const int & i); // i: direction
 
     // Estimation function for the remaining distance to the goal.
-    const int & estimate(const int& xDest,const int& yDest);
+    int estimate(const int& xDest,const int& yDest) const;
     //bool operator<(const Node & a,const Node & b);
     //bool operator<(const Node & a);
 
@@ -27,6 +27,9 @@
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
+#include "checkpoint.h"
+#include "pgmimage.h"
+
 
 using namespace std;
 using namespace Eigen;
@@ -61,6 +64,15 @@ class RFIDGridmap {
    */
     RFIDGridmap(std::string fileURI, double mapResolution, double gridResolution);
 
+  /**
+   * Constructor from a map image already loaded (its pixels are not copied).
+   * @param image          inital map
+   * @param mapResolution  inital map resolution (px/m.)
+   * @param gridResolution RFID gridmap resolution (px/m.)
+   * @param debug          show debug outputs
+   */
+    RFIDGridmap(const PGMImage &image, double mapResolution, double gridResolution, bool debug);
+
   /**
    * Store current gridmap at provided location
    * @param fileURI [description]
@@ -132,6 +144,21 @@ class RFIDGridmap {
      */
     void setPosition(double val, double x, double y);
 
+  /**
+   * Store the gridmap values in a checkpoint
+   * @param checkpoint     checkpoint to fill
+   * @param name           prefix of the sections
+   */
+    void save(Checkpoint *checkpoint, std::string name);
+
+  /**
+   * Restore the gridmap values from a checkpoint
+   * @param checkpoint     checkpoint to read
+   * @param name           prefix of the sections
+   * @return               false if the checkpoint doesn't match this gridmap
+   */
+    bool restore(const Checkpoint &checkpoint, std::string name);
+
     // controls debug prints..
     bool debug_;
 
@@ -156,6 +183,8 @@ class RFIDGridmap {
 
     void createGrid(grid_map::GridMap&  map_, std::string layerName, std::string fileURI, double mapResolution, double gridResolution, bool debug, std::string global_frame, std::string format);
 
+    void createGrid(grid_map::GridMap&  map_, std::string layerName, const cv::Mat& imageCV, double mapResolution, double gridResolution, bool debug, std::string global_frame, std::string format);
+
     void setPosition(grid_map::GridMap&  map_, std::string layerName, double val, double x, double y, bool debug);
 
     double getPosition(grid_map::GridMap&  map_, std::string layerName, double x, double y, bool debug);
@@ -16,6 +16,8 @@
 #include <functional>
 #include <iostream>
 #include <math.h>
+#include <memory>
+#include <thread>
 #include <vector>
 
 // other
@@ -26,6 +28,8 @@
 #include <cv_bridge/cv_bridge.h>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include "checkpoint.h"
+#include "pgmimage.h"
 
 #include "pose.h"
 
@@ -83,6 +87,20 @@ const double MIN_FREQ_NA = 902e6;  // Hertzs
 const double MAX_FREQ_NA = 928e6;  // Hertzs
 const double STEP_FREQ_NA = 250e3; // Hertzs
 
+// Tag layers are stored up to a lazy per-layer scale. Once the stored values
+// leave this range the scale is folded back into the cells.
+const double MAX_LAZY_BELIEF = 1e30;
+const double MIN_LAZY_BELIEF = 1e-30;
+
+// Angular step (deg.) of the antenna gain lookup table
+const double ANTENNA_LUT_STEP = 0.05;
+
+// Columns per block of the fused bayes update. Blocks are the unit of work of
+// the update threads and of the (ordered, so deterministic) mass reduction.
+const int BAYES_BLOCK_COLS = 32;
+// Smallest share of cells worth spawning an update thread for
+const int BAYES_MIN_CELLS_PER_THREAD = 32768;
+
 //  ..................................................................
 
 /**
@@ -147,10 +165,13 @@ class RadarModel {
   double _sigma_power; // noise factor
   double _sigma_phase; // noise factor
 
-  GridMap _rfid_belief_maps; // Prob. beliefs. One layer per tag. Also, one
-                             // layer with reference map, mostly for tag layout
-                             // representation.
-  GridMap _tmp_rfid_c_map;
+  GridMap _rfid_belief_maps; // Prob. beliefs. One layer per tag, and the
+                             // scratch layer of the obstacle losses.
+  // Reference map (layer "ref_map", mostly for tag layout representation) and
+  // mesh grid of the cell positions (layers "X" and "Y"), with the same
+  // geometry as the beliefs. Never modified after construction, so it is
+  // shared with the snapshots.
+  std::shared_ptr<const GridMap> _ref_maps;
 
   std::vector<std::pair<double, double>>
       _tags_coords; // tag locations in reference map coords (m.)
@@ -160,6 +181,69 @@ class RadarModel {
   SplineFunction _antenna_gains; // model for antenna power gain depending on
                                  // the angle (dB.)
 
+  // Tag layers hold belief up to a factor: belief = cell value * scale.
+  // Mass is the running sum of the stored cell values of each layer, so a
+  // measurement only touches the cells it changes.
+  std::vector<double> _layer_scale;
+  std::vector<double> _layer_mass;
+  // When set, tag layers hold normalized log-probabilities instead (obstacle
+  // cells are -inf) and the scale/mass above are unused.
+  bool _log_belief = false;
+
+  // Free cells of the reference map, so hot loops don't look ref_map up by
+  // name and compare floats on every cell. Shared with the snapshots.
+  std::shared_ptr<const Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic>>
+      _free_mask;
+
+  // Antenna gain (dB.) sampled from the spline every ANTENNA_LUT_STEP degrees
+  // from -180 to 180. Evaluating the spline itself allocates. Shared with the
+  // snapshots.
+  std::shared_ptr<const std::vector<float>> _antenna_gain_lut;
+
+  // Map sized scratch buffers, reused so that a measurement doesn't allocate.
+  Eigen::MatrixXf _scratch_X, _scratch_Y, _scratch_R, _scratch_A;
+  Eigen::MatrixXf _scratch_rxPw, _scratch_posterior;
+  Eigen::Array<bool, Eigen::Dynamic, 1> _scratch_rows;
+  Eigen::Array<bool, 1, Eigen::Dynamic> _scratch_cols;
+
+  // Partial sums of one column block of the fused bayes update
+  struct BayesPartial {
+    double prior_mass;
+    double posterior_mass;
+    float max_posterior;
+    float max_log_ratio;
+    bool finite;
+  };
+  std::vector<BayesPartial> _scratch_partials;
+
+  // Integral image (summed-area table) of each tag layer, as probabilities
+  // of free cells (up to the layer scale). Rebuilt lazily once dirty.
+  std::vector<Eigen::MatrixXd> _belief_sat;
+  std::vector<bool> _belief_sat_dirty;
+
+  /**
+   * Rebuild the integral image of a tag layer if its cells changed
+   *
+   * @param tag_i: id of the tag
+   */
+  void updateBeliefSAT(int tag_i);
+
+  /**
+   * Interpolated antenna gain from the lookup table
+   *
+   * @param angle_rad azimuth angle (rads)
+   * @return gain (dB)
+   */
+  float antennaGainRadf(float angle_rad) const;
+
+  /**
+   * Belief stored in a tag layer cell, as a probability
+   *
+   * @param value: the value stored in the cell
+   * @param tag_i: id of the tag
+   */
+  double toBelief(float value, int tag_i) const;
+
 public:
   /**
    * @brief Construct a new Radar Model object
@@ -182,6 +266,16 @@ public:
              const std::vector<std::pair<double, double>> tags_coords,
              const std::string imageFileURI);
 
+  /**
+   * @brief Same as above, with the reference map already loaded. Its pixels
+   * are shared with the caller and only read.
+   */
+  RadarModel(const double resolution, const double sigma_power,
+             const double sigma_phase, const double txtPower,
+             const std::vector<double> freqs,
+             const std::vector<std::pair<double, double>> tags_coords,
+             const PGMImage &refImage);
+
   RadarModel();
 
   /**
@@ -224,6 +318,7 @@ public:
 
   void PrintMap(std::string savePath);
   void initRefMap(const std::string imageURI);
+  void initRefMap(const PGMImage &refImage);
   void getImage(std::string layerName, std::string fileURI);
 
   /**
@@ -278,8 +373,21 @@ public:
 
   Eigen::MatrixXf getFriisMat(double x_m, double y_m, double orientation_deg,
                               double freq);
-  Eigen::MatrixXf getFriisMatFast(double x_m, double y_m,
-                                  double orientation_deg, double freq);
+  /**
+   * Fast received power of every cell, in a scratch buffer of the model: no
+   * allocation once the buffer has the map size. The result is overwritten
+   * by the next call, copy it to keep it.
+   */
+  const Eigen::MatrixXf &getFriisMatFast(double x_m, double y_m,
+                                         double orientation_deg, double freq);
+  /**
+   * Same as getFriisMat, writing into rxPw_mat. With useFast, nothing is
+   * allocated once rxPw_mat has the map size.
+   */
+  void getFriisMat(double x_m, double y_m, double orientation_deg,
+                   double freq, Eigen::MatrixXf &rxPw_mat);
+  void getFriisMatFast(double x_m, double y_m, double orientation_deg,
+                       double freq, Eigen::MatrixXf &rxPw_mat);
 
   Eigen::MatrixXf getPhaseMat(double x_m, double y_m, double orientation_deg,
                               double freq);
@@ -371,10 +479,104 @@ public:
 
   void PrintProb(std::string fileURI, Eigen::MatrixXf *prob_mat);
 
-  std::pair<int, std::pair<int, int>> findTagFromBeliefMap(int num_tag);
+  /**
+   * Find the cell whose surrounding area holds the highest belief
+   *
+   * @param num_tag: id of the tag
+   * @param buffer_size: side (cells) of the area summed with each cell
+   * @return the belief in that area and the coordinate of the tag
+   */
+  std::pair<int, std::pair<int, int>> findTagFromBeliefMap(int num_tag,
+                                                           int buffer_size = 3);
+
+  /**
+   * Total belief of the free cells in a window of a tag layer, in O(1) from
+   * the integral image of the layer. The window is clipped to the map.
+   *
+   * @param tag_i: id of the tag
+   * @param row_start: first row of the window
+   * @param col_start: first column of the window
+   * @param row_end: last row of the window (included)
+   * @param col_end: last column of the window (included)
+   * @return the sum of the belief over the window
+   */
+  double getWindowBelief(int tag_i, int row_start, int col_start, int row_end,
+                         int col_end);
 
-  void normalizeRFIDLayer(std::string layerName);
+  /**
+   * Normalize a tag layer by updating its lazy scale (no cell is touched)
+   *
+   * @param tag_i: id of the tag
+   */
+  void normalizeRFIDLayer(int tag_i);
+  /**
+   * Fold the lazy scale of a tag layer back into its cells and recompute its
+   * mass, so the layer holds plain probabilities again. Full-map pass.
+   *
+   * @param tag_i: id of the tag
+   */
+  void rescaleRFIDLayer(int tag_i);
   void normalizeRFIDMap();
+
+  /**
+   * Switch the tag layers between probability and log-probability storage.
+   * Repeated bayes updates drive far cells into denormals, in log space they
+   * are plain additions. Layers are converted in place.
+   *
+   * @param enable: true to store log-probabilities
+   */
+  void setLogBelief(bool enable);
+  bool isLogBelief() const;
+
+  /**
+   * Get the belief of one cell of a tag layer as a probability, whatever the
+   * storage of the layer is
+   *
+   * @param tag_i: id of the tag
+   * @param index: the cell in the belief map
+   * @return the probability of the tag being in that cell
+   */
+  double getBelief(int tag_i, const grid_map::Index &index);
+
+  /**
+   * Get a whole tag layer as probabilities
+   *
+   * @param tag_i: id of the tag
+   * @return the probability of the tag being in each cell
+   */
+  Eigen::MatrixXf getBeliefMatrix(int tag_i);
+
+  /**
+   * Store the tag layers (with their lazy scale and mass) in a checkpoint.
+   * The layers are run-length encoded when asked to.
+   *
+   * @param checkpoint: the checkpoint to fill
+   * @param compress: compress the layers
+   */
+  void saveBeliefs(Checkpoint *checkpoint, bool compress);
+
+  /**
+   * Restore the tag layers saved by saveBeliefs. The model must have been
+   * built on the same reference map with the same tags.
+   *
+   * @param checkpoint: the checkpoint to read
+   * @return false if the checkpoint doesn't match the model
+   */
+  bool restoreBeliefs(const Checkpoint &checkpoint);
+
+  /**
+   * Copy of the beliefs, with the integral images of the tag layers built.
+   * Only the tag layers and their integral images are copied: the reference
+   * map, the mesh grid, the free cells and the antenna lookup table are
+   * shared with this model, and the scratch buffers are left out. The copy
+   * answers the queries used to evaluate candidates (entropy, window belief,
+   * received power, hypothetical measurements, KL), which don't write it, so
+   * any number of threads can run them on it while this model keeps being
+   * updated. It can't take measurements.
+   *
+   * @return the copy
+   */
+  std::shared_ptr<RadarModel> snapshot();
   void clearObstacleCellsRFIDMap();
   double getNormalizingFactorBayesRFIDActiveArea(double x_m, double y_m,
                                                  double orientation_rad,
@@ -390,30 +592,59 @@ public:
   void overlayMapEdges(cv::Mat image);
 
   /**
-   * Calculate the KL-divergence between posterior and prior distribution over
-   * tags position
+   * Hypothetical posterior of one tag layer, kept outside of the model. A
+   * measurement changes the likelihood of the cells around the robot only,
+   * so the overlay holds the posterior of a window of cells and the factor
+   * that the normalization applies to all the others. Filling an overlay
+   * only reads the model: many of them can be evaluated at the same time
+   * against the same layers, and they are simply dropped afterwards.
+   * The Map has no such overlay: the information gain of a pose only counts
+   * the cells it would scan, and no criterion looks at the map after a scan.
+   */
+  struct BeliefOverlay {
+    int tag_i;
+    grid_map::Index start;     // first cell of the window in the layer
+    Eigen::MatrixXf posterior; // beliefs of the window cells (probabilities)
+    double prior_mass;         // prior belief inside the window
+    double outside_scale;      // posterior / prior out of the window
+  };
+
+  /**
+   * Apply a measurement to an overlay instead of the tag layer: Bayes update
+   * of the square of cells around the robot, with the same likelihood as
+   * addMeasurement. The cells out of the square are left uninformed.
    *
-   * @param x: x-coord (m.) of the center
-   * @param y: y-coord (m.) of the center
-   * @param orientation: orientation (rad.) in map coords of the center
-   * @param size_x: size-x of the active area
-   * @param size_y: size-y of the active area
+   * @param x_m: x-coord (m.) of the robot
+   * @param y_m: y-coord (m.) of the robot
+   * @param orientation_deg: orientation (deg.) of the robot
+   * @param rxPower: the received power (dB.)
+   * @param freq: the transmission frequency (Hz.)
    * @param tag_i: id of the tag emitting the signal
+   * @param len_update: side (m.) of the square of cells to update
+   * @param overlay: filled with the posterior
    */
-  double getTotalKL(double x, double y, double orientation, double size_x,
-                    double size_y, int tag_i);
+  void addHypotheticalMeasurement(double x_m, double y_m,
+                                  double orientation_deg, double rxPower,
+                                  double freq, int tag_i, double len_update,
+                                  BeliefOverlay *overlay);
+
   /**
-   * Calculate the KL-divergence between posterior and prior distribution over
-   * tags position
+   * Belief of a cell as seen through an overlay
    *
-   * @param x: x-coord (m.) of the center
-   * @param y: y-coord (m.) of the center
-   * @param orientation: orientation (rad.) in map coords of the center
-   * @param iterator: iterator over a submap
-   * @param tag_i: id of the tag emitting the signal
+   * @param overlay: the hypothetical posterior of a tag layer
+   * @param index: the cell
+   * @return the posterior probability of the tag being in the cell
    */
-  double getTotalKL(double x, double y, double orientation,
-                    grid_map::SubmapIterator iterator, int tag_i);
+  double getBelief(const BeliefOverlay &overlay,
+                   const grid_map::Index &index);
+
+  /**
+   * KL-divergence between the posterior held by an overlay and the prior
+   * of its tag layer, over the whole layer
+   *
+   * @param overlay: the hypothetical posterior of a tag layer
+   */
+  double getTotalKL(const BeliefOverlay &overlay);
   /**
    * Calculate the entropy of the tag position over the map
    *
@@ -447,6 +678,19 @@ public:
    */
   double getTotalEntropyEllipse(Pose target, double maxX, double minX,
                                 int tag_i);
+  /**
+   * Upper bound of getTotalEntropyEllipse in O(1): the entropy of n cells is
+   * at most n times the entropy of their mean belief (concavity), taken over
+   * the box around the ellipse and read from the summed-area table.
+   * Not thread safe: it may rebuild the summed-area table of the layer.
+   *
+   * @param target: the robot pose
+   * @param maxX: distance from one focal distance to the further edge
+   * @param minX: distance from one focal distance to the clostest edge
+   * @param tag_i: id of the tag emitting the signal
+   */
+  double getTotalEntropyEllipseBound(Pose target, double maxX, double minX,
+                                     int tag_i);
   /**
    * Calculate the entropy of the tag position over the map
    *
@@ -459,16 +703,6 @@ public:
 
   void printEllipse(double x, double y, double orient_rad, double maxX, double minX);
 
-  void addTmpMeasurementRFIDCriterion(double x, double y, double orientation,
-                                      double rxPower, double phase, double freq,
-                                      int i, double len_update);
-  Eigen::MatrixXf getPowProbCondRFIDCriterion(double rxPw, double f_i);
-  Eigen::MatrixXf getNegProbRFIDCriterion(double sensitivity, double sigm);
-  void createTempProbLayerRFIDCriterion(Eigen::MatrixXf prob_mat, double x_m,
-                                        double y_m, double orientation_deg,
-                                        double len_update);
-  grid_map::Polygon getSubMapEdges(double robot_x, double robot_y,
-                                   double robot_head, double len);
   // Position getSubMapRelPoint(Position glob_point, double x_m, double  y_m,
   // double orientation_rad, double len);
 
@@ -488,6 +722,8 @@ public:
                              grid_map::Index edge_index_end,
                              grid_map::Index antenna_index);
   bool useFast = true;
+  // threads used by the bayes update of large measurement windows
+  int updateThreads = std::thread::hardware_concurrency();
   Eigen::MatrixXf getFriisMatSlow(double x_m, double y_m,
                                   double orientation_deg, double freq);
   Eigen::MatrixXf getPhaseProbCond(double ph_i, double x_m, double y_m,
@@ -505,7 +741,7 @@ public:
                       double orientation_deg, double f_i);
   void PrintBothProb(std::string fileURI, double rxPw, double phi, double x_m,
                      double y_m, double orientation_deg, double f_i);
-  cv::Mat layerToImage(GridMap *gm, std::string layerName);
+  cv::Mat layerToImage(const GridMap *gm, std::string layerName);
 
 }; // end class
 
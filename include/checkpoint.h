@@ -0,0 +1,136 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/**
+    * Binary snapshot of the exploration state, made of named sections of
+    * raw bytes. The file starts with the magic "MCDMCKPT" and a version;
+    * every section header and payload is aligned on 8 bytes, so a loaded
+    * checkpoint is memory-mapped and its uncompressed sections are read in
+    * place. Sections can be stored with a run-length encoding of 32-bit
+    * words, which suits belief layers and grids made of large uniform areas.
+    *
+    * Only trivially copyable values can be stored: the owners of the state
+    * (Map, NavigationGraph, RadarModel, ...) write their own sections and
+    * rebuild their derived structures when restoring.
+    */
+class Checkpoint
+{
+public:
+  static const uint32_t VERSION = 1;
+
+  /**
+   * Constructor: an empty checkpoint
+   */
+  Checkpoint();
+
+  virtual ~Checkpoint();
+
+  /**
+   * Add a section, copying its content. A section with the same name is
+   * replaced.
+   *
+   * @param name: the name of the section
+   * @param data: the content of the section
+   * @param size: the size of the content in bytes
+   * @param compress: store the section run-length encoded
+   */
+  void put(const std::string &name, const void *data, size_t size, bool compress = false);
+
+  template <typename T>
+  void putValue(const std::string &name, const T &value)
+  {
+    put(name, &value, sizeof(T));
+  }
+
+  template <typename T>
+  void putVector(const std::string &name, const std::vector<T> &values, bool compress = false)
+  {
+    put(name, values.data(), values.size() * sizeof(T), compress);
+  }
+
+  /**
+   * Get the content of a section
+   *
+   * @param name: the name of the section
+   * @param data: set to the content, valid as long as the checkpoint
+   * @param size: set to the size of the content in bytes
+   * @return false if there is no such section
+   */
+  bool get(const std::string &name, const void **data, size_t *size) const;
+
+  /**
+   * Get a value stored with putValue
+   *
+   * @return false if there is no such section or its size doesn't match
+   */
+  template <typename T>
+  bool getValue(const std::string &name, T *value) const
+  {
+    const void *data;
+    size_t size;
+    if (!get(name, &data, &size) || size != sizeof(T)) return false;
+    *value = *(const T *)data;
+    return true;
+  }
+
+  /**
+   * Get a vector stored with putVector
+   *
+   * @return false if there is no such section or its size doesn't match
+   */
+  template <typename T>
+  bool getVector(const std::string &name, std::vector<T> *values) const
+  {
+    const void *data;
+    size_t size;
+    if (!get(name, &data, &size) || size % sizeof(T) != 0) return false;
+    values->assign((const T *)data, (const T *)data + size / sizeof(T));
+    return true;
+  }
+
+  /**
+   * Write the checkpoint to disk. The file is written next to the
+   * destination and renamed, so an interrupted write never leaves a
+   * truncated checkpoint behind.
+   *
+   * @param fileURI: the path of the checkpoint
+   * @return false if the file can't be written
+   */
+  bool save(const std::string &fileURI) const;
+
+  /**
+   * Read a checkpoint from disk, replacing the current sections
+   *
+   * @param fileURI: the path of the checkpoint
+   * @return false if the file can't be read, is not a checkpoint or has
+   * another version
+   */
+  bool load(const std::string &fileURI);
+
+  /**
+   * Remove all the sections
+   */
+  void clear();
+
+private:
+  struct Section
+  {
+    const char *data;
+    size_t size;
+    bool compress;
+  };
+
+  // sections by name, pointing into the mapped file or into buffers
+  std::map<std::string, Section> sections;
+  std::vector<std::shared_ptr<std::vector<char> > > buffers;
+  std::shared_ptr<const char> mapping;
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,76 @@
+#ifndef EPOCHSNAPSHOTS_H
+#define EPOCHSNAPSHOTS_H
+
+#include <memory>
+#include <mutex>
+
+
+/**
+    * Latest published copy of a state that is updated by one writer and read
+    * by others at the same time. The writer works on its own object and,
+    * once a step is applied, publishes a copy of it; every publication opens
+    * a new epoch. Readers acquire the copy of the current epoch and keep
+    * using it for as long as they hold it, while the writer moves on: a
+    * published copy is never modified again, so it is read without locks.
+    * The copy of an old epoch is released by the last reader letting it go.
+    */
+template <typename T>
+class EpochSnapshots
+{
+public:
+  /**
+   * Constructor: nothing published yet (epoch 0)
+   */
+  EpochSnapshots() : epoch(0)
+  {
+  }
+
+  virtual ~EpochSnapshots()
+  {
+  }
+
+  /**
+   * Publish a copy as the current one, opening a new epoch. The copy must
+   * not be modified any more.
+   *
+   * @param snapshot: the copy to publish
+   * @return the epoch of the copy
+   */
+  long publish(const std::shared_ptr<T> &snapshot)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = snapshot;
+    return ++epoch;
+  }
+
+  /**
+   * Get the copy of the current epoch
+   *
+   * @param epoch: if not NULL, filled with the epoch of the copy
+   * @return the copy, empty if nothing was published
+   */
+  std::shared_ptr<T> acquire(long *epoch = NULL) const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (epoch != NULL) *epoch = this->epoch;
+    return current;
+  }
+
+  /**
+   * Get the current epoch
+   *
+   * @return the number of copies published so far
+   */
+  long getEpoch() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return epoch;
+  }
+
+private:
+  mutable std::mutex mutex;
+  std::shared_ptr<T> current;
+  long epoch;
+};
+
+#endif // EPOCHSNAPSHOTS_H
@@ -3,6 +3,7 @@
 
 #include <unordered_map>
 #include "pose.h"
+#include "posekey.h"
 #include <vector>
 #include <sstream>
 #include <string.h>
@@ -30,9 +31,8 @@ public:
     virtual ~EvaluationRecords();
 
     /**
-	 * This method insert an evaluation for the frontier. The method does not make
-	 * a copy of the frontier, so be sure to create a copy from outside the class and pass
-	 * the copy of the frontier as first parameter.
+	 * This method insert an evaluation for the frontier, keeping a copy of it.
+	 * A frontier already in the record keeps its first evaluation.
 	 * 
 	 * @param frontier the frontier
 	 * @param value the utility of the frontier
@@ -71,23 +71,50 @@ public:
     int size();
     
 	/**
-	 * Method that returns the list of all the frontiers that are evaluated.
-	 * Note that this method creates a copy of the frontiers, so you must delete the list
-	 * and the frontiers when you do not need them.
+	 * Method that returns the list of all the frontiers that are evaluated,
+	 * ranked by decreasing utility.
 	 * 
 	 * @return the list of the evaluated frontiers.
 	 */
     std::list<Pose> getFrontiers();
+
+	/**
+	 * Method that returns the frontier with the highest utility, in O(n).
+	 * Among equal utilities the first one in storage order is returned.
+	 * 
+	 * @return the frontier and its utility; a default Pose and 0 if the record is empty
+	 */
+    pair<Pose, double> getBest() const;
+
+	/**
+	 * Method that returns the k frontiers with the highest utility, in decreasing
+	 * order of utility (storage order among equal ones), selected with a heap
+	 * in O(n log k).
+	 * 
+	 * @param k the number of frontiers to return (all of them if there are less)
+	 * @return the frontiers with their utility
+	 */
+    vector<pair<Pose, double> > getTopK(int k) const;
+
+	/**
+	 * Methods that return the evaluated frontiers and their utility, in
+	 * storage order: getValues()[i] is the utility of getPoses()[i].
+	 * This is the insertion order until a frontier is removed.
+	 */
+    const vector<Pose>& getPoses() const;
+    const vector<double>& getValues() const;
     
 	/**
-	 * Method that remove a frontier from the evaluation record.
+	 * Method that remove a frontier from the evaluation record, in constant
+	 * time: the last stored frontier takes its place.
 	 * 
 	 * @param frontier the frontier to remove.
 	 */
     void removeFrontier(Pose &frontier);
     
 	/**
-	 * Compute the Pose object starting from a string encoding
+	 * Compute the Pose object starting from a string encoding (as returned by
+	 * getEncodedKey, which is only used for logging)
 	 * 
 	 * @param encoding: the string representing a robot configuration
 	 * @return the Pose object of that configuration
@@ -95,7 +122,8 @@ public:
     Pose getPoseFromEncoding(string &encoding);
 
 	/**
-	 * Calculate the encoding of a robot configuration
+	 * Calculate the string encoding of a robot configuration, for logging.
+	 * Frontiers are identified internally by their PoseKey.
 	 * 
 	 * @param p: the configuration of the robot as Pose object
 	 * @return the associated string encoding
@@ -109,7 +137,11 @@ public:
 
 
 protected:
-    unordered_map<string, double> evaluations;
+    //the evaluated frontiers and their utility, in storage order
+    vector<Pose> poses;
+    vector<double> values;
+    //position of a frontier in poses and values
+    unordered_map<PoseKey, int> indices;
     double maxValue, minValue;
 
 };
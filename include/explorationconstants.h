@@ -17,4 +17,9 @@
 
 #define STARTING_OFFSET 5000
 
+/**
+  * Candidates evaluated together between two pruning passes of MCDMFunction
+  */
+#define PRUNE_BATCH_SIZE 16
+
 #endif // EXPLORATIONCONSTANTS_H
@@ -2,9 +2,14 @@
 #define MAP_H
 
 #include "RFIDGridmap.h"
+#include "checkpoint.h"
+#include "occupancygrid.h"
+#include "occupancypyramid.h"
+#include "pgmimage.h"
 #include "pose.h"
 #include <fstream> // ifstream
 #include <iostream>
+#include <random>
 #include <sstream> // stringstream
 #include <string>
 #include <unordered_map>
@@ -19,8 +24,7 @@ public:
   /**
    * Constructor
    *
-   * @param infile: the path used for reading the map
-   * @param fileURI: map file absolute path and filename
+   * @param infile: the stream used for reading the map
    * @param resolution: the resolution of the map
    * @param imgresolution: the resolution for building the planningGrid
    */
@@ -29,20 +33,45 @@ public:
                              // Map(nav_msgs::OccupancyGrid ros_msg);
   //  ~Map();					//destructor
 
+  /**
+   * Constructor, reading the map directly from disk. Binary PGM files are
+   * memory-mapped instead of being copied.
+   *
+   * @param fileURI: map file absolute path and filename (.pgm or GRID)
+   * @param resolution: the resolution of the map
+   * @param imgresolution: the resolution for building the planningGrid
+   */
+  Map(const std::string &fileURI, double resolution, double imgresolution);
+
+  /**
+   * Constructor, sharing the pixels of an image already loaded
+   *
+   * @param image: the map image
+   * @param resolution: the resolution of the map
+   * @param imgresolution: the resolution for building the planningGrid
+   */
+  Map(const PGMImage &image, double resolution, double imgresolution);
+
   /**
    * @brief Map::Map empty constructore
    */
   Map();
 
   /**
-   * Set a value for a cell in the Grid
+   * Set a value for a cell in the Grid. Neither the value nor the position
+   * are checked.
    * 
    * @param value: 0 -> unscanned free cell, 1 -> obstacle cell, 2 -> scanned free cell
    * @param i: the x-position(row) in the grid
    * @param j: the y-position(column) in the grid
    */
-  void setGridValue(int value, long i,
-                    long j); // setter for value in position ij of the grid
+  inline void setGridValue(int value, long i, long j)
+  {
+    int previous = grid.get(i, j);
+    if (previous == value) return;
+    grid.set(i, j, value);
+    countSubcell(previous, value, i, j);
+  }
   
   /**
    * Get the value associated with one cell of the grid
@@ -51,7 +80,7 @@ public:
    * @param j: the y-position in the grid
    * @return the associated value with that cell
    */
-  int getGridValue(long i, long j) const; 
+  inline int getGridValue(long i, long j) const { return grid.get(i, j); }
 
   /**
    * Get the value of a cell in the gridmap
@@ -59,7 +88,7 @@ public:
    * @param i: the index of the cell
    * @return the value contained in the cell
    */
-  long getGridValue(long i) const;
+  inline long getGridValue(long i) const { return grid.get(i); }
   
   /**
    * Get the value of one cell of the map
@@ -156,7 +185,7 @@ public:
    * @param j: the y-position(column) in the planning grid
    * @return the value in that cell value: 0 -> unscanned free cell, 1 -> obstacle cell, 2 -> scanned free cell)
    */
-  int getPathPlanningGridValue(long i, long j) const;
+  inline int getPathPlanningGridValue(long i, long j) const { return pathPlanningGrid.get(i, j); }
 
   /**
    * Assign a value to a cell in the planning grid
@@ -165,7 +194,7 @@ public:
    * @param i: the x-position(row) of the cell in the planning grid
    * @param j: the y-position(column) of the cell in the planning grid
    */
-  void setPathPlanningGridValue(int value, int i, int j);
+  inline void setPathPlanningGridValue(int value, int i, int j) { pathPlanningGrid.set(i, j, value); }
 
   /**
    * Get the number of columns in the planning grid
@@ -187,6 +216,69 @@ public:
    */
   int getGridToPathGridScale() const;
 
+  /**
+   * Get the number of cells of the grid covered by a cell of the planning
+   * grid that are still free and unscanned (value 0), in constant time
+   *
+   * @param i: the x-position(row) in the planning grid
+   * @param j: the y-position(column) in the planning grid
+   * @return the number of unscanned free cells of the grid
+   */
+  inline int getUnscannedSubcells(long i, long j) const
+  {
+    long cell = i * numPathPlanningGridCols + j;
+    return gridToPathGridScale * gridToPathGridScale - scannedSubcells[cell] - obstacleSubcells[cell];
+  }
+
+  /**
+   * Get the summaries of the grid at every power-of-two level
+   *
+   * @return the pyramid built on the grid
+   */
+  const OccupancyPyramid& getPyramid() const;
+
+  /**
+   * Count the free and unscanned cells (value 0) of the grid inside a
+   * rectangle, using the pyramid
+   *
+   * @param minI: the first row of the rectangle in the grid
+   * @param minJ: the first column of the rectangle in the grid
+   * @param maxI: the last row of the rectangle (included)
+   * @param maxJ: the last column of the rectangle (included)
+   * @return the number of unscanned free cells
+   */
+  long countUnscannedCells(long minI, long minJ, long maxI, long maxJ) const;
+
+  /**
+   * Move along a row of the grid past the blocks of the pyramid with nothing
+   * left to scan
+   *
+   * @param i: the row in the grid
+   * @param j: the column to start from
+   * @param maxJ: the last column to consider
+   * @return the first column from j on whose block still has an unscanned
+   * free cell (maybe greater than maxJ)
+   */
+  long skipScannedBlocks(long i, long j, long maxJ) const;
+
+  /**
+   * Store the state of the exploration kept by the map (the grid, the
+   * planning grid and the RFID grid) in a checkpoint
+   *
+   * @param checkpoint: the checkpoint to fill
+   */
+  void saveState(Checkpoint *checkpoint) const;
+
+  /**
+   * Restore the state saved by saveState. The map must have been built from
+   * the same image with the same resolutions.
+   *
+   * @param checkpoint: the checkpoint to read
+   * @return false if the checkpoint doesn't match this map (which is then
+   * left unchanged)
+   */
+  bool restoreState(const Checkpoint &checkpoint);
+
   /**
    * Update the pathplanning grid and the rfid grid.
    * Check the navigation map and if the cells are scanned there, update the
@@ -257,16 +349,33 @@ public:
   std::pair<int, std::pair<int, int>> findTagfromGridMap(RFIDGridmap grid);
   
   /**
-   * Sample a random cell among the list of the free ones.
+   * Sample uniformly, in constant time, a free cell of the grid that is still
+   * unscanned, and return the cell of the planning grid containing it: a
+   * planning cell is drawn in proportion to its unscanned free subcells. The
+   * index of these cells is built on the first call and kept up to date by
+   * setGridValue from then on.
    * 
-   * @return the coordinate of the selected cell
+   * @return the coordinate (row, column) of the selected cell in the planning
+   * grid, or the position of the robot if every free cell has been scanned
    */
   std::pair<long, long> getRandomFreeCell();
+
+  /**
+   * Seed the generator used by getRandomFreeCell. Without a seed, the
+   * generator starts from the default seed of std::mt19937.
+   * 
+   * @param seed: the seed of the generator
+   */
+  void setRandomSeed(unsigned long seed);
   // nav_msgs::OccupancyGrid toROSMsg();
 
-  std::vector<long> grid; // vector containing the map as grid of cells sized 1 square metre
-  std::vector<int> pathPlanningGrid;
+  OccupancyGrid grid; // the map as grid of cells sized 1 square metre
+  OccupancyGrid pathPlanningGrid;
+  OccupancyPyramid pyramid;
   std::vector<int> RFIDGrid;
+  // number of scanned (2) and obstacle (1) grid cells inside each planning cell
+  std::vector<int> scannedSubcells;
+  std::vector<int> obstacleSubcells;
   long numGridRows;
   long numGridCols;
   int gridToPathGridScale;
@@ -276,10 +385,17 @@ protected:
   /**
    * Create a monodimensional vector containing the map
    *
-   * @param infile: the path for reading the map
+   * @param infile: the stream for reading the map
    */
   void createMap(std::ifstream &infile);
 
+  /**
+   * Same as above, mapping the file in memory
+   *
+   * @param fileURI: the path of the map
+   */
+  void createMap(const std::string &fileURI);
+
   /**
    * Create the map as a monodimension vector with 0 and 1
    *
@@ -307,7 +423,40 @@ protected:
  */
   void decreaseFreeCells();
 
-  std::vector<long> map;
+  /**
+   * Update the counters of the planning cell and of the pyramid blocks
+   * containing a cell of the grid whose value changed, and the index of the
+   * unscanned free cells once built
+   *
+   * @param previous: the old value of the grid cell
+   * @param value: the new value of the grid cell
+   * @param i: the x-position in the grid
+   * @param j: the y-position in the grid
+   */
+  void countSubcell(int previous, int value, long i, long j);
+
+  /**
+   * Count again the scanned and obstacle cells of the grid inside every cell
+   * of the planning grid
+   */
+  void countSubcells();
+
+  /**
+   * Build the index of the free and unscanned cells (value 0) of the grid
+   */
+  void buildFreeCellIndex();
+
+  /**
+   * Tell if a cell of the grid belongs to the index of the free cells: the
+   * cells past the last row or column of the planning grid are left out
+   */
+  inline bool isSampledCell(long i, long j) const
+  {
+    return gridToPathGridScale > 0 && i / gridToPathGridScale < numPathPlanningGridRows
+           && j / gridToPathGridScale < numPathPlanningGridCols;
+  }
+
+  PGMImage map;
   int numPathPlanningGridRows;
   int numPathPlanningGridCols;
   long numRows;
@@ -315,7 +464,13 @@ protected:
   std::vector<std::pair<int, int>> edgePoints;
   long totalFreeCells;
   Pose currentPose;
-  std::vector<pair<long, long>> listFreeCells;
+  // free and unscanned cells of the grid (row-major index) in no particular
+  // order, and the position of each cell of the grid in that list (-1 if it
+  // isn't there). Both are empty until getRandomFreeCell is first called.
+  // Only the cells inside the planning grid are listed (isSampledCell).
+  std::vector<long> unscannedFreeCells;
+  std::vector<int> freeCellPositions;
+  std::mt19937 rng;
 };
 } 
 
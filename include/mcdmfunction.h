@@ -3,7 +3,9 @@
 #include "Criteria/criterion.h"
 #include "Criteria/weightmatrix.h"
 #include "evaluationrecords.h"
+#include "scorematrix.h"
 #include "RadarModel.hpp"
+#include <thread>
 #include <utility>
 
 /**
@@ -82,13 +84,32 @@ public:
   pair< Pose, double > selectNewPose(EvaluationRecords* evaluationRecords);
 
   /**
-   * Convert a pose into a string
-   * 
-   * @param p: the pose to encode
-   * @param value:  0 (encode everything), 1 (x,y,orientation - first), 2 (x,y,orientation - multiple time)
-   * @return the encoding
+   * Tell if the last call of evaluateFrontiers evaluated every candidate.
+   * It is false when timeBudget expired before the expensive criteria were
+   * computed for all of them, or when pruneCandidates dropped some: the
+   * records then contain only the evaluated candidates (always at least the
+   * most promising one), normalized among themselves.
+   *
+   * @return true if the last evaluation is the same as without a time budget
+   * and without pruning
+   */
+  bool isLastEvaluationExact() const;
+
+  /**
+   * Get the fraction of the candidates of the last call of evaluateFrontiers
+   * removed by pruneCandidates before computing their expensive criteria.
+   *
+   * @return the number of pruned candidates over the number of candidates
    */
-  string getEncodedKey(Pose& p, int value);
+  double getLastPruneRate() const;
+
+  // threads evaluating the criteria of the candidates in evaluateFrontiers
+  int evaluationThreads = std::thread::hardware_concurrency();
+  // seconds available to evaluateFrontiers, <= 0 to evaluate every candidate
+  double timeBudget = 0.0;
+  // skip the expensive criteria of the candidates without information gain
+  // or dominated by an already evaluated candidate (see evaluateStaged)
+  bool pruneCandidates = false;
 
 protected:
 
@@ -100,10 +121,35 @@ protected:
    * @return an object Criterion
    */
   Criterion * createCriterion(string name, double weight);
+
+  /**
+   * Fill the raw values of the score matrix in stages: the cheap criteria
+   * are computed for every candidate, then the expensive ones for the
+   * candidates in decreasing order of the weighted cheap criteria, until
+   * timeBudget expires (if set).
+   * With pruneCandidates, the candidates without information gain are
+   * dropped first and, before each batch of PRUNE_BATCH_SIZE candidates, a
+   * candidate is dropped if an evaluated one is at least as good on every
+   * criterion, comparing with the bounds (Criterion::computeBounds) of its
+   * expensive criteria. The normalization then runs on the kept candidates.
+   * The candidates left without the expensive criteria are removed from the
+   * list and from the score matrix.
+   *
+   * @param candidates: the candidates, reduced to the evaluated ones
+   * @param map: the reference to the map
+   * @param rfid_tools: various RFID utilities
+   * @param batteryTime: the remaining battery time
+   * @return true if every candidate was evaluated, none pruned or skipped
+   */
+  bool evaluateStaged(vector<Pose> &candidates, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime);
+
   unordered_map<string, Criterion* > criteria;
   vector<Criterion* > activeCriteria;
+  ScoreMatrix scores;
   WeightMatrix * matrix ;
   bool use_mcdm;
+  bool lastEvaluationExact = true;
+  double lastPruneRate = 0.0;
   //mutex myMutex;
 
 };
@@ -0,0 +1,120 @@
+#ifndef NAVIGATIONGRAPH_H
+#define NAVIGATIONGRAPH_H
+
+#include "checkpoint.h"
+#include "pose.h"
+#include "posekey.h"
+#include <list>
+#include <string>
+#include <vector>
+
+
+using namespace std;
+/**
+    * Backtracking structure of the exploration: a stack of the poses taken by
+    * the robot, each with the candidate positions that were still reachable
+    * from there. Nodes are addressed by their index (0 is the bottom). The
+    * candidates of all the nodes are kept as pose keys in one contiguous
+    * arena, node after node, so pushing a node appends to the arena and
+    * popping it only truncates the arena.
+    * A key doesn't keep the scan angles of a pose, so the candidates come
+    * back without them. This is safe: the scan angles are always recomputed
+    * (NewRay::getSensingTime) for a pose before they are read.
+    */
+class NavigationGraph
+{
+public:
+
+  /**
+   * Constructor
+   */
+  NavigationGraph();
+
+  virtual ~NavigationGraph();
+
+  /**
+   * Push a pose with the candidate positions reachable from there
+   *
+   * @param pose: the key of the pose
+   * @param candidates: the candidate positions
+   */
+  void push(PoseKey pose, const list<Pose> &candidates);
+
+  /**
+   * Push a pose with no candidate positions
+   *
+   * @param pose: the key of the pose
+   */
+  void push(PoseKey pose);
+
+  /**
+   * Remove the last pushed node, in constant time. The graph must not be
+   * empty.
+   */
+  void pop();
+
+  /**
+   * Get the number of nodes
+   *
+   * @return the number of nodes in the graph
+   */
+  int size() const;
+
+  /**
+   * Get the pose of a node
+   *
+   * @param node: the index of the node
+   * @return the key of the pose
+   */
+  PoseKey getPose(int node) const;
+
+  /**
+   * Get the number of candidate positions of a node
+   *
+   * @param node: the index of the node
+   * @return the number of candidates
+   */
+  int getNumCandidates(int node) const;
+
+  /**
+   * Copy the candidate positions of a node into a list of Pose objects
+   *
+   * @param node: the index of the node
+   * @param candidates: the list to fill (its content is replaced)
+   */
+  void getCandidates(int node, list<Pose> *candidates) const;
+
+  /**
+   * Same as getPose, getNumCandidates and getCandidates for the last pushed
+   * node. The graph must not be empty.
+   */
+  PoseKey getTopPose() const;
+  int getTopNumCandidates() const;
+  void getTopCandidates(list<Pose> *candidates) const;
+
+  /**
+   * Store the nodes and their candidates in a checkpoint
+   *
+   * @param checkpoint: the checkpoint to fill
+   * @param name: the prefix of the sections
+   */
+  void save(Checkpoint *checkpoint, const std::string &name) const;
+
+  /**
+   * Restore the nodes and their candidates, replacing the current ones from a checkpoint
+   *
+   * @param checkpoint: the checkpoint to read
+   * @param name: the prefix of the sections
+   * @return false if the sections are missing or inconsistent
+   */
+  bool restore(const Checkpoint &checkpoint, const std::string &name);
+
+private:
+  vector<PoseKey> poses;
+  // candidates of node i are arena[firstCandidate[i], firstCandidate[i+1]),
+  // the last one ending at the end of the arena
+  vector<int> firstCandidate;
+  vector<PoseKey> arena;
+};
+
+#endif // NAVIGATIONGRAPH_H
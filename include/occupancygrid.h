@@ -0,0 +1,176 @@
+#ifndef OCCUPANCYGRID_H
+#define OCCUPANCYGRID_H
+
+#include "checkpoint.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+using namespace std;
+/**
+    * Grid of cells holding one byte each, used for the navigation grid and
+    * the planning grid of the map. A cell value is made of two bit-planes:
+    * OBSTACLE (bit 0) and SCANNED (bit 1), so the values 0, 1 and 2 are an
+    * unscanned free cell, an obstacle and a scanned free cell.
+    *
+    * The cells are stored in square tiles of TILE_SIZE x TILE_SIZE. A tile
+    * whose cells all have the same value only keeps that value; its cells are
+    * allocated the first time one of them is set to something else, and
+    * releaseUniformTiles gives the memory back once a tile is uniform again.
+    * Large environments that are mostly unknown or outside space then only
+    * cost one byte per tile. The accessors are inline and do not check the
+    * bounds.
+    */
+class OccupancyGrid
+{
+public:
+  static const uint8_t FREE = 0;
+  static const uint8_t OBSTACLE = 1;
+  static const uint8_t SCANNED = 2;
+  static const int TILE_BITS = 6;
+  static const int TILE_SIZE = 1 << TILE_BITS;
+
+  /**
+   * Constructor: an empty grid
+   */
+  OccupancyGrid();
+
+  /**
+   * Constructor
+   *
+   * @param numRows: the number of rows
+   * @param numCols: the number of columns
+   * @param value: the initial value of all the cells
+   */
+  OccupancyGrid(long numRows, long numCols, uint8_t value = FREE);
+
+  virtual ~OccupancyGrid();
+
+  /**
+   * Change the size of the grid and set all the cells to the same value,
+   * releasing all the tiles
+   *
+   * @param numRows: the number of rows
+   * @param numCols: the number of columns
+   * @param value: the new value of all the cells
+   */
+  void assign(long numRows, long numCols, uint8_t value = FREE);
+
+  /**
+   * Get the value of a cell
+   *
+   * @param row: the row of the cell
+   * @param col: the column of the cell
+   * @return 0 -> unscanned free cell, 1 -> obstacle cell, 2 -> scanned free cell
+   */
+  inline uint8_t get(long row, long col) const
+  {
+    long tile = getTile(row, col);
+    const vector<uint8_t> &cells = tiles[tile];
+    return cells.empty() ? uniform[tile] : cells[getOffset(row, col)];
+  }
+
+  /**
+   * Same as above, with the row-major index of the cell
+   */
+  inline uint8_t get(long i) const { return get(i / numCols, i % numCols); }
+
+  /**
+   * Set the value of a cell, allocating its tile if needed
+   *
+   * @param row: the row of the cell
+   * @param col: the column of the cell
+   * @param value: 0 -> unscanned free cell, 1 -> obstacle cell, 2 -> scanned free cell
+   */
+  inline void set(long row, long col, uint8_t value)
+  {
+    long tile = getTile(row, col);
+    vector<uint8_t> &cells = tiles[tile];
+    if (cells.empty()) {
+      if (uniform[tile] == value) return;
+      cells.assign(TILE_SIZE * TILE_SIZE, uniform[tile]);
+    }
+    cells[getOffset(row, col)] = value;
+  }
+
+  /**
+   * Same as above, with the row-major index of the cell
+   */
+  inline void set(long i, uint8_t value) { set(i / numCols, i % numCols, value); }
+
+  /**
+   * Test the bit-planes of a cell
+   */
+  inline bool isObstacle(long row, long col) const { return get(row, col) & OBSTACLE; }
+  inline bool isScanned(long row, long col) const { return get(row, col) & SCANNED; }
+
+  /**
+   * Free the cells of the tiles whose cells all have the same value
+   *
+   * @return the number of tiles released
+   */
+  long releaseUniformTiles();
+
+  /**
+   * Get the number of tiles whose cells are allocated
+   *
+   * @return the number of allocated tiles
+   */
+  long getNumAllocatedTiles() const;
+
+  /**
+   * Count the cells having a given value
+   *
+   * @param value: the value to look for
+   * @return the number of cells
+   */
+  long count(uint8_t value) const;
+
+  long getNumRows() const;
+  long getNumCols() const;
+
+  /**
+   * Get the number of cells
+   *
+   * @return numRows * numCols
+   */
+  long size() const;
+
+  /**
+   * Store the cells in a checkpoint
+   *
+   * @param checkpoint: the checkpoint to fill
+   * @param name: the prefix of the sections
+   */
+  void save(Checkpoint *checkpoint, const std::string &name) const;
+
+  /**
+   * Restore the cells from a checkpoint, releasing the uniform tiles
+   *
+   * @param checkpoint: the checkpoint to read
+   * @param name: the prefix of the sections
+   * @return false if the sections are missing or inconsistent
+   */
+  bool restore(const Checkpoint &checkpoint, const std::string &name);
+
+private:
+  inline long getTile(long row, long col) const
+  {
+    return (row >> TILE_BITS) * numTileCols + (col >> TILE_BITS);
+  }
+
+  inline long getOffset(long row, long col) const
+  {
+    return ((row & (TILE_SIZE - 1)) << TILE_BITS) | (col & (TILE_SIZE - 1));
+  }
+
+  // cells of each tile, row-major, empty if the tile is uniform
+  vector<vector<uint8_t> > tiles;
+  // value of the cells of each unallocated tile
+  vector<uint8_t> uniform;
+  long numRows, numCols;
+  long numTileCols;
+};
+
+#endif // OCCUPANCYGRID_H
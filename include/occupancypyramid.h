@@ -0,0 +1,119 @@
+#ifndef OCCUPANCYPYRAMID_H
+#define OCCUPANCYPYRAMID_H
+
+#include "occupancygrid.h"
+#include <stdint.h>
+#include <vector>
+
+
+using namespace std;
+/**
+    * Summaries of an OccupancyGrid at every power-of-two level: at level k
+    * (k >= 1) each block covers 2^k x 2^k cells of the grid and stores how
+    * many of them are obstacles and how many are scanned. Level 0 is the
+    * grid itself, which is passed to the queries that need it. The top level
+    * is a single block covering the whole grid.
+    *
+    * The counters must follow the grid: call update every time a cell
+    * changes value. Queries answer "does this block contain an obstacle",
+    * "is it all free" or "is anything left to scan in it" in constant time,
+    * so the callers can skip whole blocks and look at the coarse levels first.
+    */
+class OccupancyPyramid
+{
+public:
+
+  /**
+   * Constructor: an empty pyramid
+   */
+  OccupancyPyramid();
+
+  virtual ~OccupancyPyramid();
+
+  /**
+   * Build all the levels from a grid
+   *
+   * @param grid: the grid to summarize
+   */
+  void build(const OccupancyGrid &grid);
+
+  /**
+   * Update the blocks containing a cell whose value changed
+   *
+   * @param previous: the old value of the cell
+   * @param value: the new value of the cell
+   * @param row: the row of the cell
+   * @param col: the column of the cell
+   */
+  void update(int previous, int value, long row, long col);
+
+  /**
+   * Get the number of levels, the grid (level 0) included
+   *
+   * @return the number of levels
+   */
+  int getNumLevels() const;
+
+  /**
+   * Get the number of rows and columns of blocks at a level (level >= 1)
+   */
+  long getNumRows(int level) const;
+  long getNumCols(int level) const;
+
+  /**
+   * Get the number of obstacle, scanned and unscanned free cells of the grid
+   * inside a block, unchecked (level >= 1)
+   *
+   * @param level: the level of the block
+   * @param row: the row of the block at that level
+   * @param col: the column of the block at that level
+   * @return the number of cells
+   */
+  inline long getObstacles(int level, long row, long col) const
+  {
+    return levels[level].obstacles[row * levels[level].numCols + col];
+  }
+
+  inline long getScanned(int level, long row, long col) const
+  {
+    return levels[level].scanned[row * levels[level].numCols + col];
+  }
+
+  long getUnscanned(int level, long row, long col) const;
+
+  /**
+   * Tell if a block contains at least one obstacle, or none (level >= 1)
+   */
+  inline bool hasObstacle(int level, long row, long col) const { return getObstacles(level, row, col) > 0; }
+  inline bool isAllFree(int level, long row, long col) const { return getObstacles(level, row, col) == 0; }
+
+  /**
+   * Count the unscanned free cells (value 0) of the grid inside a rectangle,
+   * descending the pyramid only along the border of the rectangle
+   *
+   * @param grid: the grid the pyramid was built from
+   * @param minRow: the first row of the rectangle
+   * @param minCol: the first column of the rectangle
+   * @param maxRow: the last row of the rectangle (included)
+   * @param maxCol: the last column of the rectangle (included)
+   * @return the number of unscanned free cells
+   */
+  long countUnscanned(const OccupancyGrid &grid, long minRow, long minCol, long maxRow, long maxCol) const;
+
+private:
+  struct Level
+  {
+    long numRows, numCols;
+    vector<uint32_t> obstacles;
+    vector<uint32_t> scanned;
+  };
+
+  long countUnscanned(const OccupancyGrid &grid, int level, long row, long col,
+                      long minRow, long minCol, long maxRow, long maxCol) const;
+
+  // levels[0] is left empty, the grid stands for it
+  vector<Level> levels;
+  long numRows, numCols;
+};
+
+#endif // OCCUPANCYPYRAMID_H
@@ -0,0 +1,96 @@
+#ifndef PGMIMAGE_H
+#define PGMIMAGE_H
+
+#include <stdint.h>
+#include <istream>
+#include <memory>
+#include <string>
+
+
+/**
+    * Grey-level image read from a PGM file (binary P5 or ASCII P2) or from
+    * the GRID text format. Binary files are memory-mapped and their pixels
+    * are used in place; the ASCII formats are decoded once into a byte buffer.
+    * Copies share the same pixels.
+    */
+class PGMImage
+{
+public:
+
+  /**
+   * Constructor: an empty image
+   */
+  PGMImage();
+
+  /**
+   * Constructor: load an image from disk (see load). The image is empty if
+   * the file can't be read.
+   *
+   * @param fileURI: the path of the image
+   */
+  explicit PGMImage(const std::string &fileURI);
+
+  virtual ~PGMImage();
+
+  /**
+   * Load an image from disk. A binary PGM with at most 255 grey levels is
+   * mapped in memory and not copied.
+   *
+   * @param fileURI: the path of the image
+   * @return false if the file can't be read or is not a valid image
+   */
+  bool load(const std::string &fileURI);
+
+  /**
+   * Load an image from a stream, reading it whole into memory.
+   *
+   * @param in: the stream positioned at the start of the image
+   * @return false if the content is not a valid image
+   */
+  bool load(std::istream &in);
+
+  /**
+   * Get the number of rows of the image
+   *
+   * @return the number of rows
+   */
+  long getNumRows() const;
+
+  /**
+   * Get the number of columns of the image
+   *
+   * @return the number of columns
+   */
+  long getNumCols() const;
+
+  /**
+   * Get the grey level of a pixel, unchecked
+   *
+   * @param i: the index of the pixel (row * numCols + col)
+   * @return the grey level
+   */
+  inline uint8_t getValue(long i) const { return pixels.get()[i]; }
+
+  /**
+   * Get the row-major array of the pixels
+   *
+   * @return a pointer to the first pixel, valid as long as the image (or a copy)
+   */
+  const uint8_t *getPixels() const;
+
+private:
+  /**
+   * Parse the file content and set the pixels, keeping owner alive with them.
+   * On failure the image is left empty.
+   */
+  bool parse(const char *begin, const char *end, std::shared_ptr<const char> owner);
+  bool parseHeader(const char *begin, const char *end, std::shared_ptr<const char> owner);
+  bool parseBinary(const char *begin, const char *end, long maxValue, std::shared_ptr<const char> owner);
+  bool parseAscii(const char *begin, const char *end, long maxValue);
+  bool parseGrid(const char *begin, const char *end);
+
+  std::shared_ptr<const uint8_t> pixels;
+  long numRows, numCols;
+};
+
+#endif // PGMIMAGE_H
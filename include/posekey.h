@@ -0,0 +1,111 @@
+#ifndef POSEKEY_H
+#define POSEKEY_H
+
+#include "pose.h"
+#include <stdint.h>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+
+/**
+    * Identity of a robot configuration packed in 64 bits: x and y (18 bits
+    * each), orientation in degrees (9 bits), sensor range (10 bits) and the
+    * sensor FOV rounded to the degree (9 bits). It replaces the string
+    * encodings for hashing and comparing poses; toString() is for logging only.
+    */
+class PoseKey
+{
+public:
+
+  /**
+   * Default constructor: the key of the pose (0,0,0,0,0)
+   */
+  PoseKey() : bits(0) {}
+
+  /**
+   * Create the key of a robot configuration.
+   *
+   * @param x: the x-coord of the cell
+   * @param y: the y-coord of the cell
+   * @param orientation: the orientation of the robot in degrees
+   * @param range: the sensor range
+   * @param FOV: the sensor FOV in radians
+   */
+  PoseKey(long x, long y, int orientation = 0, int range = 0, double FOV = 0.0);
+
+  /**
+   * Create the key of a Pose object.
+   *
+   * @param p: the robot configuration
+   */
+  explicit PoseKey(Pose &p);
+
+  /**
+   * Build the Pose object with the configuration stored in the key.
+   * The FOV is recomputed from its value in degrees, so it is exact for the
+   * FOVs set from an integer number of degrees.
+   *
+   * @return the Pose object (the scan angles are not part of the key)
+   */
+  Pose toPose() const;
+
+  long getX() const { return (long)(bits >> 46); }
+  long getY() const { return (long)((bits >> 28) & Y_MASK); }
+  int getOrientation() const { return (int)((bits >> 19) & ORIENTATION_MASK); }
+  int getRange() const { return (int)((bits >> 9) & RANGE_MASK); }
+  int getFOVDegrees() const { return (int)(bits & FOV_MASK); }
+  double getFOV() const;
+
+  /**
+   * Get the packed value
+   *
+   * @return the 64 bits identifying the configuration
+   */
+  uint64_t getBits() const { return bits; }
+
+  /**
+   * Get the key with the given packed value
+   *
+   * @param bits: a value returned by getBits()
+   * @return the key
+   */
+  static PoseKey fromBits(uint64_t bits) { PoseKey k; k.bits = bits; return k; }
+
+  /**
+   * Human readable encoding "x/y/orientation/range/FOV", for logging.
+   */
+  std::string toString() const;
+
+  bool operator==(const PoseKey &k) const { return bits == k.bits; }
+  bool operator!=(const PoseKey &k) const { return bits != k.bits; }
+  bool operator<(const PoseKey &k) const { return bits < k.bits; }
+
+  static const uint64_t X_MASK = (1u << 18) - 1;
+  static const uint64_t Y_MASK = (1u << 18) - 1;
+  static const uint64_t ORIENTATION_MASK = (1u << 9) - 1;
+  static const uint64_t RANGE_MASK = (1u << 10) - 1;
+  static const uint64_t FOV_MASK = (1u << 9) - 1;
+
+private:
+  uint64_t bits;
+};
+
+namespace std {
+  /**
+   * Hash of a PoseKey: the bits are mixed (splitmix64 finalizer) so that
+   * neighbouring cells spread over the buckets.
+   */
+  template<> struct hash<PoseKey>
+  {
+    size_t operator()(const PoseKey &k) const
+    {
+      uint64_t z = k.getBits();
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return (size_t)(z ^ (z >> 31));
+    }
+  };
+}
+
+#endif // POSEKEY_H
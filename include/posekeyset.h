@@ -0,0 +1,98 @@
+#ifndef POSEKEYSET_H
+#define POSEKEYSET_H
+
+#include "checkpoint.h"
+#include "posekey.h"
+#include <string>
+#include <vector>
+
+
+using namespace std;
+/**
+    * Set of pose keys with open addressing (linear probing over a
+    * power-of-two table kept at most half full), for the membership tests of
+    * the tabu list and of the visited cells. The keys are also kept in
+    * insertion order, which is the order of the path followed by the robot.
+    */
+class PoseKeySet
+{
+public:
+
+  /**
+   * Constructor
+   */
+  PoseKeySet();
+
+  virtual ~PoseKeySet();
+
+  /**
+   * Add a key to the set.
+   *
+   * @param key: the key to add
+   * @return true if the key was not in the set
+   */
+  bool insert(PoseKey key);
+
+  /**
+   * Tell if a key is in the set, in constant expected time
+   *
+   * @param key: the key to look for
+   * @return true if the key is in the set
+   */
+  bool contains(PoseKey key) const;
+
+  /**
+   * Get the keys in insertion order
+   *
+   * @return the keys in the order they were inserted
+   */
+  const vector<PoseKey>& getKeys() const;
+
+  /**
+   * Get the number of keys in the set
+   *
+   * @return the number of keys
+   */
+  int size() const;
+
+  /**
+   * Remove all the keys
+   */
+  void clear();
+
+  /**
+   * Store the keys, in insertion order, in a checkpoint
+   *
+   * @param checkpoint: the checkpoint to fill
+   * @param name: the prefix of the sections
+   */
+  void save(Checkpoint *checkpoint, const std::string &name) const;
+
+  /**
+   * Restore the keys, replacing the current ones from a checkpoint
+   *
+   * @param checkpoint: the checkpoint to read
+   * @param name: the prefix of the sections
+   * @return false if the sections are missing or inconsistent
+   */
+  bool restore(const Checkpoint &checkpoint, const std::string &name);
+
+private:
+  /**
+   * Position of a key in the table, or of the empty slot where it belongs
+   */
+  size_t findSlot(uint64_t bits) const;
+
+  /**
+   * Double the table and insert the keys again
+   */
+  void grow();
+
+  // no configuration packs to all ones (orientations are below 360)
+  static const uint64_t EMPTY = ~0ULL;
+
+  vector<uint64_t> slots;
+  vector<PoseKey> keys;
+};
+
+#endif // POSEKEYSET_H
@@ -0,0 +1,95 @@
+#ifndef SCOREMATRIX_H
+#define SCOREMATRIX_H
+
+#include <vector>
+
+
+using namespace std;
+/**
+    * Dense candidate x criterion table of evaluations. Each candidate is
+    * addressed by its index in the evaluated list and each criterion by its
+    * position among the active ones. Values are stored criterion-major, so the
+    * column of one criterion over all the candidates is contiguous.
+    */
+class ScoreMatrix
+{
+public:
+
+    /**
+	 * Constructor
+	 */
+    ScoreMatrix();
+
+    virtual ~ScoreMatrix();
+
+    /**
+	 * Resize the table for a new evaluation and set every value to 0.
+	 * The storage is kept between calls when it is already large enough.
+	 *
+	 * @param numCandidates: the number of candidate poses
+	 * @param numCriteria: the number of active criteria
+	 */
+    void reset(int numCandidates, int numCriteria);
+
+    /**
+	 * Store the raw value of a criterion for a candidate
+	 *
+	 * @param criterion: the index of the criterion
+	 * @param candidate: the index of the candidate
+	 * @param value: the raw evaluation
+	 */
+    void setRaw(int criterion, int candidate, double value);
+
+    /**
+	 * Get the raw value of a criterion for a candidate
+	 */
+    double getRaw(int criterion, int candidate) const;
+
+    /**
+	 * Get the normalized value of a criterion for a candidate
+	 */
+    double getNormalized(int criterion, int candidate) const;
+
+    /**
+	 * Drop every candidate not listed, keeping the raw values of the others.
+	 * Candidate indices[k] becomes candidate k.
+	 *
+	 * @param indices: the candidates to keep, in increasing order
+	 */
+    void keepCandidates(const vector<int> &indices);
+
+    /**
+	 * Copy the raw values into the normalized table, ready to be normalized
+	 * in place column by column.
+	 */
+    void copyRawToNormalized();
+
+    /**
+	 * Get the raw values of a criterion for all the candidates
+	 *
+	 * @param criterion: the index of the criterion
+	 * @return a pointer to getNumCandidates() contiguous values
+	 */
+    double* getRawColumn(int criterion);
+
+    /**
+	 * Get the normalized values of a criterion for all the candidates
+	 *
+	 * @param criterion: the index of the criterion
+	 * @return a pointer to getNumCandidates() contiguous values
+	 */
+    double* getNormalizedColumn(int criterion);
+
+    int getNumCandidates() const;
+    int getNumCriteria() const;
+
+protected:
+    int numCandidates = 0;
+    int numCriteria = 0;
+    vector<double> raw;
+    vector<double> normalized;
+
+};
+
+
+#endif // SCOREMATRIX_H
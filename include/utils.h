@@ -4,10 +4,14 @@
 #include "pose.h"
 #include "mcdmfunction.h"
 #include "evaluationrecords.h"
+#include "posekey.h"
+#include "posekeyset.h"
+#include "navigationgraph.h"
 #include "PathFinding/astar.h"
 #include "newray.h"
 #include <boost/filesystem.hpp>
 #include <fstream>
+#include <thread>
 #include "constants.h"
 
 
@@ -23,12 +27,12 @@ public:
   ~Utilities();
   
   /**
-   * Check if a Pose object is already present within a list
+   * Check if a pose is already present within a set
    * 
-   * @param list: the list of Pose objects
-   * @param p: the Pose object to look for
+   * @param list: the set of pose keys
+   * @param p: the key of the pose to look for
    */
-  bool contains ( std::list< Pose >& list, Pose& p );
+  bool contains ( PoseKeySet& list, PoseKey p );
  
   /**
    * Remove a Pose object from a list of Pose objects
@@ -37,6 +41,14 @@ public:
    * @param p: the object to removeS
    */
   void cleanPossibleDestination2(std::list<Pose> *possibleDestinations, Pose &p);
+
+  /**
+   * Remove from a list of Pose objects those already visited
+   *
+   * @param possibleDestinations: list of Pose objects
+   * @param tabuList: the keys of the poses which cannot be assumed again
+   */
+  void cleanPossibleDestinations(std::list<Pose> *possibleDestinations, PoseKeySet *tabuList);
   
   /**
    * Calculate the frontiers from the starting position and add it to the graph structure
@@ -47,14 +59,14 @@ public:
    * @param orientation: the orientation of the robot expressed in degrees
    * @param range: the range of the robot's sensor expressed in cells
    * @param threshold: the threshold value to discard unuseful frontiers
-   * @param actualPose: encoding of the current robot pose
+   * @param actualPose: key of the current robot pose
    * @param graph2: the structure where to save current pose and its candidate positions
    * @param function: the MCDM function object
    */
   void pushInitialPositions (dummy::Map *map, int x, int y, int orientation,
                              int range, int FOV, double threshold,
-                             string actualPose,
-                             vector< pair< string, list< Pose > > > *graph2,
+                             PoseKey actualPose,
+                             NavigationGraph *graph2,
                              MCDMFunction *function, RFID_tools *rfid_tools, double *batteryTime);
   /**
    * Calculate the time required for performing a scan with the TDLAS sensor
@@ -66,22 +78,22 @@ public:
   /**
    * Calculate the length of a path
    *
-   * @param list: a list of Pose lying on the path
+   * @param list: the keys of the poses lying on the path
    * @param map: a copy of the map
    * @param astar: the astar object used for parsing the map and calculating the distance
    * @return the distance travelled by the robot along the entire path
    */
-  double calculateDistance(list<Pose> list, dummy::Map* map, Astar* astar);
+  double calculateDistance(const vector<PoseKey> &list, dummy::Map* map, Astar* astar);
 
   /**
    * Calculate the length of a path
    *
-   * @param list: a list of Pose lying on the path
+   * @param list: the keys of the poses lying on the path
    * @param map: a copy of the map
    * @param astar: the astar object used for parsing the map and calculating the distance
    * @return the final battery percentage of the robot
    */
-  double calculateRemainingBatteryPercentage(list<Pose> list, dummy::Map* map, Astar* astar);
+  double calculateRemainingBatteryPercentage(const vector<PoseKey> &list, dummy::Map* map, Astar* astar);
   
   /**
    * Create a new Pose object starting from another one
@@ -101,14 +113,14 @@ public:
    * @param count: the iteration count of the MCDM algorithm
    * @param target: the next position of the robot
    * @param previous: the current position of the robot
-   * @param actualPose: the encoding of the current pose of the robot
+   * @param actualPose: the key of the current pose of the robot
    * @param nearCandidates: the list of possible destination for the robot
    * @param graph2: the structure containing positions and their nearCandidates
    * @param map: a copy of the map
    * @param function: a MCDM function object
-   * @param tabuList: the list of Pose which cannot be assumed again
-   * @param history: list of encoding of all visited cells by the robot
-   * @param encodedKeyValue: a value representing which kind of encoding we want
+   * @param tabuList: the keys of the Pose which cannot be assumed again
+   * @param history: keys of all visited cells by the robot, with how they were visited
+   * @param encodedKeyValue: 1 if the cell is visited for the first time, 2 otherwise
    * @param astar: a copy of Astar object for calculating the distance between two pose
    * @param numConfiguration: number of configuration assumed by the robot so far
    * @param totalAngle: scanning angle performed so far
@@ -117,20 +129,20 @@ public:
    * @param scanAngle: angle scanned in the current iteration
    * @param batteryTime: remaining battery for the robot
   */
-  void updatePathMetrics(int* count, Pose* target, Pose* previous, string actualPose,
-                         list<Pose>* nearCandidates, vector<pair<string,list<Pose>>>* graph2,
-                         dummy::Map* map, MCDMFunction* function, list<Pose>* tabuList,
-                         vector<string>* history, int encodedKeyValue, Astar* astar ,
+  void updatePathMetrics(int* count, Pose* target, Pose* previous, PoseKey actualPose,
+                         list<Pose>* nearCandidates, NavigationGraph* graph2,
+                         dummy::Map* map, MCDMFunction* function, PoseKeySet* tabuList,
+                         vector<pair<PoseKey,int>>* history, int encodedKeyValue, Astar* astar ,
                          long* numConfiguration, double* totalAngle,
                          double * travelledDistance, int* numOfTurning , double scanAngle,
                          double* batteryTime);
   /**
    * Get the list of Pose assumed only once along the traversed path
    *
-   * @param history: the list of Pose assumed by the robot one or more times (during bakctracking)
-   * @param record: evaluationRecords object required for converting a string to a Pose
+   * @param history: the list of Pose assumed by the robot one or more times (during bakctracking),
+   *                 each with 1 if visited for the first time or 2 otherwise
    */
-  list<Pose> cleanHistory(vector<string>* history, EvaluationRecords* record);
+  vector<PoseKey> cleanHistory(vector<pair<PoseKey,int>>* history);
   
   /**
    * Print in console a summary of the exploration task
@@ -173,14 +185,14 @@ public:
     * @param count: the iteration count of the MCDM algorithm
     * @param target: the next position of the robot
     * @param previous: the current position of the robot
-    * @param actualPose: the encoding of the current pose of the robot
+    * @param actualPose: the key of the current pose of the robot
     * @param nearCandidates: the list of possible destination for the robot
     * @param graph2: the structure containing positions and their nearCandidates
     * @param map: a copy of the map
     * @param function: a MCDM function object
-    * @param tabuList: the list of Pose which cannot be assumed again
-    * @param history: list of encoding of all visited cells by the robot
-    * @param encodedKeyValue: a value representing which kind of encoding we want
+    * @param tabuList: the keys of the Pose which cannot be assumed again
+    * @param history: keys of all visited cells by the robot, with how they were visited
+    * @param encodedKeyValue: 1 if the cell is visited for the first time, 2 otherwise
     * @param astar: a copy of Astar object for calculating the distance between two pose
     * @param numConfiguration: number of configuration assumed by the robot so far
     * @param totalAngle: scanning angle performed so far
@@ -191,8 +203,8 @@ public:
     * @param threshold: to cut frontiers
   */
   bool recordContainsCandidates(EvaluationRecords* record, 
-                              int* count, Pose* target, Pose* previous, string* actualPose, list<Pose>* nearCandidates, vector<pair<string,list<Pose>>>* graph2,
-                              dummy::Map* map, MCDMFunction* function, list<Pose>* tabuList, vector<string>* history, int* encodedKeyValue, Astar* astar , long* numConfiguration,
+                              int* count, Pose* target, Pose* previous, PoseKey* actualPose, list<Pose>* nearCandidates, NavigationGraph* graph2,
+                              dummy::Map* map, MCDMFunction* function, PoseKeySet* tabuList, vector<pair<PoseKey,int>>* history, int* encodedKeyValue, Astar* astar , long* numConfiguration,
                                 double* totalAngle, double * travelledDistance, int* numOfTurning , double* scanAngle, bool* btMode, double* threshold,
                                 RFID_tools *rfid_tools, double *batteryTime);
   
@@ -203,11 +215,11 @@ public:
     * @param record: list of candiate position
     * @param target: the next position of the robot
     * @param previous: the current position of the robot
-    * @param history: list of encoding of all visited cells by the robot
+    * @param history: keys of all visited cells by the robot, with how they were visited
     * @param function: a MCDM function object
     * @param count: the iteration count of the MCDM algorithm
   */
-  bool recordNOTContainsCandidates(vector<pair<string,list<Pose>>>* graph2, EvaluationRecords* record, Pose* target, Pose* previous, vector<string>* history,
+  bool recordNOTContainsCandidates(NavigationGraph* graph2, EvaluationRecords* record, Pose* target, Pose* previous, vector<pair<PoseKey,int>>* history,
                                     MCDMFunction* function, int* count);
   
   /**
@@ -217,14 +229,14 @@ public:
     * @param count: the iteration count of the MCDM algorithm
     * @param target: the next position of the robot
     * @param previous: the current position of the robot
-    * @param actualPose: the encoding of the current pose of the robot
+    * @param actualPose: the key of the current pose of the robot
     * @param nearCandidates: the list of possible destination for the robot
     * @param graph2: the structure containing positions and their nearCandidates
     * @param map: a copy of the map
     * @param function: a MCDM function object
-    * @param tabuList: the list of Pose which cannot be assumed again
-    * @param history: list of encoding of all visited cells by the robot
-    * @param encodedKeyValue: a value representing which kind of encoding we want
+    * @param tabuList: the keys of the Pose which cannot be assumed again
+    * @param history: keys of all visited cells by the robot, with how they were visited
+    * @param encodedKeyValue: 1 if the cell is visited for the first time, 2 otherwise
     * @param astar: a copy of Astar object for calculating the distance between two pose
     * @param numConfiguration: number of configuration assumed by the robot so far
     * @param totalAngle: scanning angle performed so far
@@ -234,8 +246,8 @@ public:
     * @param btMode: if doing forward motion or backtracking
   */
   void recordContainsCandidatesBT(EvaluationRecords* record, 
-                                int* count, Pose* target, Pose* previous, string* actualPose, list<Pose>* nearCandidates, vector<pair<string,list<Pose>>>* graph2,
-                                dummy::Map* map, MCDMFunction* function, list<Pose>* tabuList, vector<string>* history, int* encodedKeyValue, Astar* astar , long* numConfiguration,
+                                int* count, Pose* target, Pose* previous, PoseKey* actualPose, list<Pose>* nearCandidates, NavigationGraph* graph2,
+                                dummy::Map* map, MCDMFunction* function, PoseKeySet* tabuList, vector<pair<PoseKey,int>>* history, int* encodedKeyValue, Astar* astar , long* numConfiguration,
                                 double* totalAngle, double * travelledDistance, int* numOfTurning , double* scanAngle, bool* btMode, double* threshold,
                                 RFID_tools *rfid_tools, double *batteryTime);
   
@@ -246,14 +258,14 @@ public:
    * @param count: the iteration count of the MCDM algorithm
    * @param target: the next position of the robot
    * @param previous: the current position of the robot
-   * @param actualPose: the encoding of the current pose of the robot
+   * @param actualPose: the key of the current pose of the robot
    * @param nearCandidates: the list of possible destination for the robot
    * @param graph2: the structure containing positions and their nearCandidates
    * @param map: a reference to the map
    * @param function: a MCDM function object
-   * @param tabuList: the list of Pose which cannot be assumed again
-   * @param history: list of encoding of all visited cells by the robot
-   * @param encodedKeyValue: a value representing which kind of encoding we want
+   * @param tabuList: the keys of the Pose which cannot be assumed again
+   * @param history: keys of all visited cells by the robot, with how they were visited
+   * @param encodedKeyValue: 1 if the cell is visited for the first time, 2 otherwise
    * @param astar: a copy of Astar object for calculating the distance between two pose
    * @param numConfiguration: number of configuration assumed by the robot so far
    * @param totalAngle: scanning angle performed so far
@@ -267,8 +279,8 @@ public:
    * @param batteryTime: the remaining battery time for the robot
    */
   void recordNOTContainsCandidatesBT(EvaluationRecords* record, 
-                                int* count, Pose* target, Pose* previous, string* actualPose, list<Pose>* nearCandidates, vector<pair<string,list<Pose>>>* graph2,
-                                dummy::Map* map, MCDMFunction* function, list<Pose>* tabuList, vector<string>* history, int* encodedKeyValue, Astar* astar , long* numConfiguration,
+                                int* count, Pose* target, Pose* previous, PoseKey* actualPose, list<Pose>* nearCandidates, NavigationGraph* graph2,
+                                dummy::Map* map, MCDMFunction* function, PoseKeySet* tabuList, vector<pair<PoseKey,int>>* history, int* encodedKeyValue, Astar* astar , long* numConfiguration,
                                 double* totalAngle, double * travelledDistance, int* numOfTurning , double* scanAngle, bool* btMode, double* threshold, double* batteryTime);
 
   /**
@@ -292,15 +304,17 @@ public:
   void updateMaps(dummy::Map* map, Pose* target, RFID_tools *rfid_tools, bool computeKL);
 
   /**
-   * Update the navigation map and each tags belief map
-   * 
+   * Same as updateMaps, but only the navigation map and the RFID maps are
+   * updated before returning: the measurements are added to the belief maps
+   * by a separate thread. The radar model must not be used until the thread
+   * is joined, candidates can meanwhile be evaluated on a snapshot of it.
+   *
    * @param map: the object map (with all its levels)
    * @param target: the next destination of the robot
    * @param rfid_tools: various utility for RFID related operations
-   * @param tag_id: the belief map on which computing the posterior
-   * @param len_update: the size of the submap to use for computing the posterior
+   * @return the thread updating the belief maps
    */
-  void computePosteriorBeliefSingleLayer(dummy::Map* map, Pose* target, RFID_tools *rfid_tools, int tag_id, double len_update);
+  std::thread updateMapsAsync(dummy::Map* map, Pose* target, RFID_tools *rfid_tools);
 
   /**
    * Update the navigation graph structure with the current position
@@ -316,13 +330,13 @@ public:
    * @param range: the sensor range
    * @param FOV: the sensor FOV
    * @param threshold: thereshold for discarting frontiers
-   * @param actualPose: encoding of the current pose of the robot
+   * @param actualPose: key of the current pose of the robot
    * @param rfid_tools: various utility for RFID related operations
    * @param batteryTime: how much battery is left to the robot
    * @return true if the navigation is finished (graph empty), false otherwise
    */
-  bool updateNavigationGraph(int *count, MCDMFunction *function, vector<pair<string,list<Pose>>> *graph2, Pose *target , dummy::Map *map, 
-                            long *x, long *y, int *orientation, int *range, double *FOV, double *threshold, string *actualPose,
+  bool updateNavigationGraph(int *count, MCDMFunction *function, NavigationGraph *graph2, Pose *target , dummy::Map *map, 
+                            long *x, long *y, int *orientation, int *range, double *FOV, double *threshold, PoseKey *actualPose,
                             RFID_tools *rfid_tools, double *batteryTime);
 
   /**
@@ -352,7 +366,7 @@ public:
    * @param totalScanTime: total time required by scanning operation
    * @param out_log: path of the result log
    * @param numConfiguration: number of configuration assumed by the robot
-   * @param actualPose: encoding of the current pose of the robot
+   * @param actualPose: key of the current pose of the robot
    * @param encodedKeyValue: defines if the cells is new or already been visited
    * @param totalAngle: total of the scanning angle accumulated during the operation
    * @param numOfTurning: total number of turnings the robot performs while navigating
@@ -365,11 +379,11 @@ public:
    * @return true if the navigation is finished, true otherwise
    */
   bool forwardMotion(Pose *target, Pose *previous,list<Pose> *frontiers, list<Pose> *nearCandidates, vector<pair<long,long> > *candidatePosition, NewRay *ray, dummy::Map *map, 
-                      long *x, long *y, int *orientation, double *FOV, int *range, vector<pair<string,list<Pose>>> *graph2,
-                      EvaluationRecords *record, MCDMFunction *function, double *threshold, int *count, vector<string> *history, 
-                      list<Pose> *tmp_history, list<Pose> *tabuList, Astar *astar, double *imgresolution, double *travelledDistance,
+                      long *x, long *y, int *orientation, double *FOV, int *range, NavigationGraph *graph2,
+                      EvaluationRecords *record, MCDMFunction *function, double *threshold, int *count, vector<pair<PoseKey,int>> *history, 
+                      vector<PoseKey> *tmp_history, PoseKeySet *tabuList, Astar *astar, double *imgresolution, double *travelledDistance,
                       long *sensedCells, long *newSensedCells, long *totalFreeCells, double *totalScanTime, string *out_log,
-                      long *numConfiguration, string *actualPose, int* encodedKeyValue, double *totalAngle, int *numOfTurning,
+                      long *numConfiguration, PoseKey *actualPose, int* encodedKeyValue, double *totalAngle, int *numOfTurning,
                       double *scanAngle, bool *btMode, RFID_tools *rfid_tools, double *accumulated_received_power, double *precision, double *batteryTime);
 
   /**
@@ -418,6 +432,31 @@ public:
    */
   void saveRFIDMapsWithGroundTruths(vector<RFIDGridmap> *RFID_maps_list, vector<pair<double, double>> *tags_coord, string root);
 
+  /**
+   * Store in a checkpoint the exploration state shared by all the drivers:
+   * the map, the navigation graph, the history, the candidates around the
+   * robot, the current and previous pose, the RFID maps and the tag beliefs.
+   *
+   * @param checkpoint: the checkpoint to fill
+   * @param compress: store the grids and belief layers run-length encoded
+   */
+  void saveCheckpoint(Checkpoint *checkpoint, dummy::Map *map, NavigationGraph *graph2,
+                      vector<pair<PoseKey,int>> *history, list<Pose> *nearCandidates,
+                      Pose *target, Pose *previous, RFID_tools *rfid_tools, bool compress);
+
+  /**
+   * Restore the state stored by saveCheckpoint. The map, the RFID maps and the
+   * radar model must have been built with the same arguments as the run that
+   * wrote the checkpoint.
+   *
+   * @param checkpoint: the checkpoint to read
+   * @return false if a section is missing or inconsistent; the state is then
+   * partially restored and the run should not go on
+   */
+  bool restoreCheckpoint(const Checkpoint &checkpoint, dummy::Map *map, NavigationGraph *graph2,
+                         vector<pair<PoseKey,int>> *history, list<Pose> *nearCandidates,
+                         Pose *target, Pose *previous, RFID_tools *rfid_tools);
+
 protected:
 
 Pose invertedInitial, eastInitial, westInitial;
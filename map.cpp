@@ -1,4 +1,5 @@
 #include <map.h>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <random>
@@ -16,115 +17,49 @@ Map::Map(std::ifstream& infile, double resolution, double imgresolution)
   Map::createNewMap();
 }
 
+Map::Map(const std::string& fileURI, double resolution, double imgresolution)
+{
+
+  Map::createMap(fileURI);
+  Map::createGrid(resolution);
+  Map::createPathPlanningGrid(imgresolution);
+  Map::createNewMap();
+}
+
+Map::Map(const PGMImage& image, double resolution, double imgresolution)
+{
+
+  map = image;
+  numRows = map.getNumRows();
+  numCols = map.getNumCols();
+  Map::createGrid(resolution);
+  Map::createPathPlanningGrid(imgresolution);
+  Map::createNewMap();
+}
+
 Map::Map()
+  : numRows(0), numCols(0)
 {
 }
 
 void Map::createMap(std::ifstream& infile)
 {
-  long row = 0, col = 0;
-  std::stringstream ss;
-  std::string inputLine = "";
-
-  // First line : version
-  getline(infile,inputLine);
-  if(inputLine.compare("GRID") == 0)
+  if(!map.load(infile))
   {
-    int temp;
-    infile >> Map::numRows >> Map::numCols;
-    //std::cout << "numrows " << numRows << " numcols " << numCols << std::endl;
-    Map::map.reserve(numRows*numCols);
-    std::cout << map.size() << std::endl;
-    for(int i = 0; i < numRows*numCols; ++i)
-    {
-      infile >> temp;
-      if(temp == 1)
-        map.push_back(0);
-      if(temp == 0)
-        map.push_back(255);
-    }
-
+    std::cout << "Error while reading the map." << std::endl;
   }
-  else
-  {
-    if(inputLine.compare("P2") != 0)
-    {
-      long size, greylevels;
-      //Second line : comment
-      char comment_char = infile.get();
-      if(comment_char == '#')
-      {
-        getline(infile,inputLine);
-      }
-      else
-      {
-        //cout << "No comment in the header" << endl;
-        ss << comment_char;
-      }
-      // Continue with a stringstream
-      ss << infile.rdbuf();
-      // Third line : size
-      ss >> numCols >> numRows >> greylevels;
-      // cout << numCols << " columns and " << numRows << " rows" << endl;
-      getline(infile,inputLine);
-      size = numCols * numRows;
-      long* data = new long[size];
-      for(long* ptr = data; ptr < data+size; ptr++)
-      {
-        // read in binary char
-        unsigned char t_ch = ss.get();
-        // convert to integer
-        long t_data = static_cast<long>(t_ch);
-        // if passes add value to data array
-        *ptr = t_data;
-      }
-      // close the stream
-      infile.close();
-
-      Map::map.reserve(numRows*numCols);
-      // Following lines : data
-      for(long* ptr = data, i = 0; ptr < data+size; ptr++, i++)
-      {
-        map[i] = *ptr ;
-        //cout << map[i];
-      }
-      delete data;
-
-    }
-    else
-    {
-      //Second line : comment
-      char comment_char = infile.get();
-      if(comment_char == '#') {
-        getline(infile,inputLine);
-      } else {
-        //cout << "No comment in the header" << endl;
-        ss << comment_char;
-      }
-      //Following lines not useful anymore
-      //getline(infile,inputLine);
-      //cout << "Comment : " << inputLine << endl;
-      // Continue with a stringstream
-      ss << infile.rdbuf();
-      // Third line : size
-      ss >> numCols >> numRows;
-      // cout << numCols << " columns and " << numRows << " rows" << endl;
-      //max value of color
-      //getline(infile,inputLine);
-      int max;
-      ss >> max;
-      //std::vector<int> array(numRows*numCols);
-      Map::map.reserve(numRows*numCols);
-      // Following lines : data
-      for(row = 0; row < numRows; ++row)
-        for (col = 0; col < numCols; ++col)
-        {
-          ss >> Map::map[row*numCols + col];
-        }
-      //infile.close();
-    }
+  numRows = map.getNumRows();
+  numCols = map.getNumCols();
+}
 
+void Map::createMap(const std::string& fileURI)
+{
+  if(!map.load(fileURI))
+  {
+    std::cout << "Error while reading the map " << fileURI << std::endl;
   }
+  numRows = map.getNumRows();
+  numCols = map.getNumCols();
 }
 
 void Map::createGrid(double resolution)
@@ -135,10 +70,7 @@ void Map::createGrid(double resolution)
   Map::numGridCols = static_cast<long>(numCols/clusterSize);
   // cout <<" numGridRows: " << numGridRows <<", numGridCols: "<< numGridCols << endl;
 
-  for(int i = 0; i < numGridCols*numGridRows; ++i)
-  {
-    grid.push_back(0);
-  }
+  grid.assign(numGridRows, numGridCols, OccupancyGrid::FREE);
 
   //set 1 in the grid cells corrisponding to obstacles
   for(long row = 0; row < numRows; ++row)
@@ -147,14 +79,17 @@ void Map::createGrid(double resolution)
     {
 
       // If the value in the map is below 250, set it to 1 to represent a free cell
-      if(map[row*numCols + col] < 250)
+      if(map.getValue(row*numCols + col) < 250)
       {
-        grid[static_cast<long>((row/clusterSize)*numGridCols) + static_cast<long>((col/clusterSize))] = 1;
+        grid.set(static_cast<long>((row/clusterSize)*numGridCols) + static_cast<long>((col/clusterSize)), OccupancyGrid::OBSTACLE);
         //NOTE: i don't remember when it should be used
         //map[(long)(row/clusterSize)*numGridCols + (long)(col/clusterSize)] = 1;
       }
     }
   }
+  // keep only the tiles mixing free space and obstacles
+  grid.releaseUniformTiles();
+  pyramid.build(grid);
 
 
 }
@@ -200,11 +135,8 @@ void Map::createPathPlanningGrid(double resolution)
   Map::numPathPlanningGridCols = static_cast<int>(numCols/clusterSize);
   // cout <<"numPathPlanningGridRows: " << numPathPlanningGridRows <<", numPathPlanningGridCols: "<< numPathPlanningGridCols << endl;
 
-  for(int i = 0; i < numPathPlanningGridCols*numPathPlanningGridRows; ++i)
-  {
-    pathPlanningGrid.push_back(0);
-    RFIDGrid.push_back(250);
-  }
+  pathPlanningGrid.assign(numPathPlanningGridRows, numPathPlanningGridCols, OccupancyGrid::FREE);
+  RFIDGrid.assign(numPathPlanningGridCols*numPathPlanningGridRows, 250);
 
   //set 1 in the grid cells corrisponding to obstacles
   for(long row = 0; row < numRows; ++row)
@@ -212,23 +144,41 @@ void Map::createPathPlanningGrid(double resolution)
     for(long col = 0; col < numCols; ++col)
     {
 
-      if(map[row*numCols + col] < 250)
+      if(map.getValue(row*numCols + col) < 250)
       {
-        pathPlanningGrid[static_cast<long>((row/clusterSize)*numPathPlanningGridCols) + static_cast<long>(col/clusterSize)] = 1;
+        pathPlanningGrid.set(static_cast<long>((row/clusterSize)*numPathPlanningGridCols) + static_cast<long>(col/clusterSize), OccupancyGrid::OBSTACLE);
         RFIDGrid[static_cast<long>((row/clusterSize)*numPathPlanningGridCols) + static_cast<long>(col/clusterSize)] = 1;
         //NOTE: i don't remember when it should be used
         //map[(long)(row/clusterSize)*numGridCols + (long)(col/clusterSize)] = 1;
-      }else {
-        listFreeCells.push_back(std::make_pair((row/clusterSize), col/clusterSize));
       }
     }
   }
+  pathPlanningGrid.releaseUniformTiles();
   Map::gridToPathGridScale = static_cast<int>(numGridRows / numPathPlanningGridRows);
+  countSubcells();
   // cout << "Scale: " << gridToPathGridScale << endl;
 
 
 }
 
+void Map::countSubcells()
+{
+  // count the scanned and obstacle grid cells inside each planning cell
+  scannedSubcells.assign(numPathPlanningGridRows*numPathPlanningGridCols, 0);
+  obstacleSubcells.assign(numPathPlanningGridRows*numPathPlanningGridCols, 0);
+  long maxGridRow = std::min<long>(numPathPlanningGridRows*gridToPathGridScale, numGridRows);
+  long maxGridCol = std::min<long>(numPathPlanningGridCols*gridToPathGridScale, numGridCols);
+  for(long row = 0; row < maxGridRow; ++row)
+  {
+    for(long col = 0; col < maxGridCol; ++col)
+    {
+      long cell = (row/gridToPathGridScale)*numPathPlanningGridCols + col/gridToPathGridScale;
+      if(grid.get(row, col) == OccupancyGrid::SCANNED) scannedSubcells[cell]++;
+      else if(grid.get(row, col) == OccupancyGrid::OBSTACLE) obstacleSubcells[cell]++;
+    }
+  }
+}
+
 void Map::updatePathPlanningGrid(int posX, int posY, int rangeInMeters, double power)
 {
 
@@ -247,46 +197,20 @@ void Map::updatePathPlanningGrid(int posX, int posY, int rangeInMeters, double p
   {
     for(int col = minY; col <= maxY; ++col)
     {
-      int countScanned = 0;
-      int setToOne = 0;
-      for(int gridRow = row*gridToPathGridScale; gridRow < row*gridToPathGridScale + gridToPathGridScale; ++gridRow)
-      {
-        for(int gridCol = col*gridToPathGridScale; gridCol < col*gridToPathGridScale + gridToPathGridScale; ++gridCol)
-        {
-          // if the cell contains an obstacle
-          if(getGridValue(gridRow, gridCol) == 1)
-          {
-            setToOne = 1;
-          }
-
-          // if the cell is free and scanned
-          if(getGridValue(gridRow, gridCol) == 2)
-          {
-            countScanned++;
-          }
-        }
-      }
-      if(countScanned == gridToPathGridScale*gridToPathGridScale)
+      long cell = row*numPathPlanningGridCols + col;
+      // if all the cells of the grid inside are free and scanned
+      if(scannedSubcells[cell] == gridToPathGridScale*gridToPathGridScale)
       {
         setPathPlanningGridValue(2, row, col);
         setRFIDGridValue(power, row, col);
       }
-      if(setToOne == 1) setPathPlanningGridValue(1, row, col);
+      // if one of them contains an obstacle
+      if(obstacleSubcells[cell] > 0) setPathPlanningGridValue(1, row, col);
     }
   }
 
 }
 
-int Map::getPathPlanningGridValue(long i,long j) const
-{
-  return pathPlanningGrid[i*numPathPlanningGridCols + j];
-}
-
-void Map::setPathPlanningGridValue(int value, int i, int j)
-{
-  pathPlanningGrid[i*numPathPlanningGridCols + j] = value;
-}
-
 void Map::setRFIDGridValue(float power, int i, int j)
 {
   //  cout << "-----" << endl;
@@ -312,12 +236,146 @@ int Map::getGridToPathGridScale() const
 }
 
 
-void Map::setGridValue(int value, long i, long j)
+void Map::countSubcell(int previous, int value, long i, long j)
+{
+  pyramid.update(previous, value, i, j);
+  if(!freeCellPositions.empty() && isSampledCell(i, j))
+  {
+    long index = i*numGridCols + j;
+    if(previous == OccupancyGrid::FREE && freeCellPositions[index] >= 0)
+    {
+      // swap with the last one, so nothing else moves
+      int position = freeCellPositions[index];
+      long last = unscannedFreeCells.back();
+      unscannedFreeCells[position] = last;
+      freeCellPositions[last] = position;
+      unscannedFreeCells.pop_back();
+      freeCellPositions[index] = -1;
+    }
+    else if(value == OccupancyGrid::FREE)
+    {
+      freeCellPositions[index] = unscannedFreeCells.size();
+      unscannedFreeCells.push_back(index);
+    }
+  }
+  if(scannedSubcells.empty() || gridToPathGridScale == 0) return;
+  long row = i/gridToPathGridScale;
+  long col = j/gridToPathGridScale;
+  if(row >= numPathPlanningGridRows || col >= numPathPlanningGridCols) return;
+  long cell = row*numPathPlanningGridCols + col;
+  if(previous == OccupancyGrid::SCANNED) scannedSubcells[cell]--;
+  else if(previous == OccupancyGrid::OBSTACLE) obstacleSubcells[cell]--;
+  if(value == OccupancyGrid::SCANNED) scannedSubcells[cell]++;
+  else if(value == OccupancyGrid::OBSTACLE) obstacleSubcells[cell]++;
+}
+
+void Map::saveState(Checkpoint *checkpoint) const
+{
+  grid.save(checkpoint, "map.grid");
+  pathPlanningGrid.save(checkpoint, "map.pathPlanningGrid");
+  checkpoint->putVector("map.RFIDGrid", RFIDGrid, true);
+  // the order of the index matters to the sampling, as the generator does
+  if(!freeCellPositions.empty())
+    checkpoint->putVector("map.unscannedFreeCells", unscannedFreeCells);
+  std::ostringstream rngStream;
+  rngStream << rng;
+  std::string rngState = rngStream.str();
+  checkpoint->put("map.rng", rngState.data(), rngState.size());
+}
+
+bool Map::restoreState(const Checkpoint &checkpoint)
+{
+  OccupancyGrid savedGrid, savedPathPlanningGrid;
+  std::vector<int> savedRFIDGrid;
+  if(!savedGrid.restore(checkpoint, "map.grid") || !savedPathPlanningGrid.restore(checkpoint, "map.pathPlanningGrid")
+     || !checkpoint.getVector("map.RFIDGrid", &savedRFIDGrid))
+    return false;
+  // the checkpoint must come from the same map
+  if(savedGrid.getNumRows() != numGridRows || savedGrid.getNumCols() != numGridCols
+     || savedPathPlanningGrid.getNumRows() != numPathPlanningGridRows || savedPathPlanningGrid.getNumCols() != numPathPlanningGridCols
+     || savedRFIDGrid.size() != RFIDGrid.size())
+    return false;
+  // optional sections: the index of the free cells and the generator
+  std::vector<long> savedFreeCells;
+  bool hasFreeCells = checkpoint.getVector("map.unscannedFreeCells", &savedFreeCells);
+  if(hasFreeCells)
+  {
+    // the index must list every sampled free cell exactly once
+    std::vector<bool> listed(savedGrid.size(), false);
+    for(size_t k = 0; k < savedFreeCells.size(); ++k)
+    {
+      long index = savedFreeCells[k];
+      if(index < 0 || index >= savedGrid.size() || listed[index] || savedGrid.get(index) != OccupancyGrid::FREE
+         || !isSampledCell(index / numGridCols, index % numGridCols))
+        return false;
+      listed[index] = true;
+    }
+    for(long index = 0; index < savedGrid.size(); ++index)
+    {
+      if(!listed[index] && savedGrid.get(index) == OccupancyGrid::FREE && isSampledCell(index / numGridCols, index % numGridCols))
+        return false;
+    }
+  }
+  const void *rngState;
+  size_t rngStateSize;
+  if(checkpoint.get("map.rng", &rngState, &rngStateSize))
+  {
+    std::istringstream rngStream(std::string((const char *)rngState, rngStateSize));
+    rngStream >> rng;
+  }
+  grid = savedGrid;
+  pathPlanningGrid = savedPathPlanningGrid;
+  RFIDGrid = savedRFIDGrid;
+  // the counters and the pyramid are derived from the grid
+  countSubcells();
+  pyramid.build(grid);
+  unscannedFreeCells.clear();
+  freeCellPositions.clear();
+  if(hasFreeCells)
+  {
+    unscannedFreeCells = savedFreeCells;
+    freeCellPositions.assign(grid.size(), -1);
+    for(size_t k = 0; k < unscannedFreeCells.size(); ++k)
+      freeCellPositions[unscannedFreeCells[k]] = k;
+  }
+  return true;
+}
+
+void Map::buildFreeCellIndex()
+{
+  unscannedFreeCells.clear();
+  freeCellPositions.assign(grid.size(), -1);
+  for(long row = 0; row < numGridRows; ++row)
+  {
+    for(long col = 0; col < numGridCols; ++col)
+    {
+      if(grid.get(row, col) != OccupancyGrid::FREE || !isSampledCell(row, col)) continue;
+      freeCellPositions[row*numGridCols + col] = unscannedFreeCells.size();
+      unscannedFreeCells.push_back(row*numGridCols + col);
+    }
+  }
+}
+
+const OccupancyPyramid& Map::getPyramid() const
+{
+  return pyramid;
+}
+
+long Map::countUnscannedCells(long minI, long minJ, long maxI, long maxJ) const
+{
+  return pyramid.countUnscanned(grid, minI, minJ, maxI, maxJ);
+}
+
+long Map::skipScannedBlocks(long i, long j, long maxJ) const
 {
-  if(value == 0 || value == 1 || value == 2)
+  // blocks of 8x8 cells: large enough to skip, small enough to fit the sensor range
+  const int level = 3;
+  if(pyramid.getNumLevels() <= level || i < 0 || i >= numGridRows) return j;
+  while(j <= maxJ && j >= 0 && j < numGridCols && pyramid.getUnscanned(level, i >> level, j >> level) == 0)
   {
-    grid[i*numGridCols + j] = value;
+    j = (j | ((1 << level) - 1)) + 1;
   }
+  return j;
 }
 
 void Map::addEdgePoint(int x, int y)
@@ -341,11 +399,6 @@ std::vector<vector<long> > Map::getMap2D(){
 
 }
 
-int Map::getGridValue(long i,long j) const
-{
-  return grid[i*numGridCols + j];
-}
-
 
 int Map::getRFIDGridValue(long i,long j) const
 {
@@ -354,7 +407,7 @@ int Map::getRFIDGridValue(long i,long j) const
 
 long Map::getMapValue(long i, long j)
 {
-  return map[i*numCols + j];
+  return map.getValue(i*numCols + j);
 }
 
 long Map::getNumGridCols() const
@@ -378,11 +431,6 @@ long Map::getNumRows()
   return numRows;
 }
 
-long dummy::Map::getGridValue(long i) const
-{
-  return Map::grid[i];
-}
-
 Pose Map::getRobotPosition()
 {
   return currentPose;
@@ -395,15 +443,7 @@ void Map::setCurrentPose(Pose& p)
 
 long Map::getTotalFreeCells(){
 
-  totalFreeCells = numGridCols * numGridRows;
-  for(long row = 0; row < numGridRows; ++row)
-  {
-    for(long col = 0; col < numGridCols; ++col)
-    {
-      //if an obstacle is present decrement the number of free cells
-      if(getGridValue(row,col) == 1) totalFreeCells--;
-    }
-  }
+  totalFreeCells = grid.size() - grid.count(OccupancyGrid::OBSTACLE);
   //cout << "Total free cells: " << totalFreeCells << endl;
   return totalFreeCells;
 }
@@ -619,13 +659,16 @@ std::pair<int, std::pair<int, int>> Map::findTagfromGridMap(RFIDGridmap grid)
 }
 
 std::pair<long, long> Map::getRandomFreeCell(){
-  std::random_device rd;     // only used once to initialise (seed) engine
-  std::mt19937 rng(rd());    // random-number engine used (Mersenne-Twister in this case)
-  std::uniform_int_distribution<int> uni(0, totalFreeCells-1); // guaranteed unbiased
+  if(freeCellPositions.empty()) buildFreeCellIndex();
+  if(unscannedFreeCells.empty()) return std::make_pair(currentPose.getX(), currentPose.getY());
+  std::uniform_int_distribution<long> uni(0, unscannedFreeCells.size()-1);
+  long index = unscannedFreeCells[uni(rng)];
+  // the targets are cells of the planning grid, as the robot position
+  return std::make_pair(index / numGridCols / gridToPathGridScale, index % numGridCols / gridToPathGridScale);
+}
 
-  auto random_integer = uni(rng);
-  std::pair<long, long> random_cell = listFreeCells.at(random_integer);
-  return random_cell;
+void Map::setRandomSeed(unsigned long seed){
+  rng.seed(seed);
 }
 
 }
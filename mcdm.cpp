@@ -17,6 +17,8 @@
 // #include "RFIDGridmap.h"
 #include "yaml-cpp/yaml.h"
 #include "RadarModel.hpp"
+#include "epochsnapshots.h"
+#include <thread>
 #include <vector>
 
 
@@ -69,17 +71,28 @@ int main ( int argc, char **argv )
     std::cout << "- ellipse X_min: " << argv[22] << endl;
     std::cout << "- accuracy_log: " << argv[23] << endl;
     std::cout << "- use_mcdm: " << argv[24] << endl;
+    if (argc > 25)
+      std::cout << "- decision time budget: " << argv[25] << " s" << endl;
+    if (argc > 26)
+      std::cout << "- prune candidates: " << argv[26] << endl;
+    if (argc > 27)
+      std::cout << "- checkpoint file: " << argv[27] << endl;
+    if (argc > 28)
+      std::cout << "- checkpoint every: " << argv[28] << " steps" << endl;
+    if (argc > 29)
+      std::cout << "- resume from: " << argv[29] << endl;
+    if (argc > 30)
+      std::cout << "- pipeline belief updates: " << argv[30] << endl;
   }
 
 
 
 
 
-  ifstream infile;
-  infile.open ( argv[1] );  // the path to the map
   double resolution = atof ( argv[2] );  // the resolution of the map
   double imgresolution = atof ( argv[10] );  // the resolution to use for the planningGrid and RFIDGrid
-  dummy::Map map = dummy::Map ( infile,resolution, imgresolution );
+  PGMImage refImage ( argv[1] );  // the path to the map, read once and shared by all the grids
+  dummy::Map map = dummy::Map ( refImage, resolution, imgresolution );
   
   // std::cout << "Map dimension: " << map.getNumGridCols() << " : "<<  map.getNumGridRows() << endl;
   int gridToPathGridScale = map.getGridToPathGridScale();
@@ -137,27 +150,9 @@ int main ( int argc, char **argv )
   tags_coord.push_back(std::make_pair(absTag9_X, absTag9_Y));
   tags_coord.push_back(std::make_pair(absTag10_X, absTag10_Y));
 
-  RFIDGridmap myGrid1(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid2(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid3(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid4(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid5(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid6(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid7(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid8(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid9(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid10(argv[1], resolution, imgresolution, false);
-  std::vector<RFIDGridmap> RFID_maps_list;
-  RFID_maps_list.push_back(myGrid1);
-  RFID_maps_list.push_back(myGrid2);
-  RFID_maps_list.push_back(myGrid3);
-  RFID_maps_list.push_back(myGrid4);
-  RFID_maps_list.push_back(myGrid5);
-  RFID_maps_list.push_back(myGrid6);
-  RFID_maps_list.push_back(myGrid7);
-  RFID_maps_list.push_back(myGrid8);
-  RFID_maps_list.push_back(myGrid9);
-  RFID_maps_list.push_back(myGrid10);
+  // one grid per tag, all starting from the same map
+  RFIDGridmap rfidGrid(refImage, resolution, imgresolution, false);
+  std::vector<RFIDGridmap> RFID_maps_list(10, rfidGrid);
 
   double freq = std::stod(argv[12]); // Hertzs
   double txtPower = std::stod(argv[13]); // dBs
@@ -183,6 +178,12 @@ int main ( int argc, char **argv )
   norm_w_battery_status = w_battery_status / sum_w;
   Utilities utils(norm_w_info_gain, norm_w_travel_distance, norm_w_sensing_time, norm_w_rfid_gain, norm_w_battery_status);
   MCDMFunction function(norm_w_info_gain, norm_w_travel_distance, norm_w_sensing_time, norm_w_rfid_gain, norm_w_battery_status ,use_mcdm);
+  // optional: seconds available to take every decision (anytime evaluation)
+  if (argc > 25)
+    function.timeBudget = atof(argv[25]);
+  // optional: skip the expensive criteria of candidates that can't be selected
+  if (argc > 26)
+    function.pruneCandidates = bool(atoi(argv[26]));
   Pose initialPose = Pose ( initX,initY,initOrientation,initRange,initFov );
 
   Pose invertedInitial = utils.createFromInitialPose ( initX,initY,initOrientation,180,initRange,initFov );
@@ -191,7 +192,7 @@ int main ( int argc, char **argv )
   Pose target = initialPose;
   Pose previous = initialPose;
   long numConfiguration = 1;
-  vector<pair<string,list<Pose>>> graph2;
+  NavigationGraph graph2;
   NewRay ray;
   ray.setGridToPathGridScale ( gridToPathGridScale );
   long sensedCells = 0;
@@ -200,14 +201,14 @@ int main ( int argc, char **argv )
   int count = 0;
   double travelledDistance = 0;
   int numOfTurning = 0;
-  unordered_map<string,int> visitedCell;
-  vector<string>history;
-  history.push_back ( function.getEncodedKey ( target,1 ) );
+  PoseKeySet visitedCell;
+  vector<pair<PoseKey,int>>history;
+  history.push_back ( make_pair ( PoseKey ( target ), 1 ) );
   EvaluationRecords record;
   //amount of time the robot should do nothing for scanning the environment ( final value expressed in second)
   unsigned int microseconds = 5 * 1000 * 1000 ;
-  list<Pose> tabuList;
-  tabuList.push_back(target);
+  PoseKeySet tabuList;
+  tabuList.insert(PoseKey(target));
   list<Pose> nearCandidates;
   bool btMode = false;
   double totalAngle = 0;
@@ -231,16 +232,17 @@ int main ( int argc, char **argv )
   // std::vector<double> freqs{ MIN_FREQ_NA,MIN_FREQ_NA+STEP_FREQ_NA,MIN_FREQ_NA+2.0*STEP_FREQ_NA }; 
 
   std::cout <<"Building radar model." << endl;
-  RadarModel rm(rs, sigma_power, sigma_phase, txtPower, freqs, tags_coord, argv[1] );
+  RadarModel rm(rs, sigma_power, sigma_phase, txtPower, freqs, tags_coord, refImage );
   std::cout << "Radar model built." << endl;
   rm.PrintRefMapWithTags("/tmp/scenario.png");  
 
   long x, y = 0;
   int orientation, range;
   double FOV, major_axis, minor_axis, scanAngle, rxPower, phase;
-  string encoding, actualPose;
+  PoseKey actualPose;
 
-  list<Pose> frontiers, tmp_history;
+  list<Pose> frontiers;
+  vector<PoseKey> tmp_history;
   bool break_loop;
   double accumulated_received_power = 0.0;
   double batteryTime = MAX_BATTERY;
@@ -257,6 +259,59 @@ int main ( int argc, char **argv )
   rfid_tools.txtPower = txtPower;
   rfid_tools.sensitivity = SENSITIVITY;
   rfid_tools.RFID_maps_list = &RFID_maps_list;
+
+  // optional: write the exploration state to a checkpoint every few steps
+  std::string checkpoint_file = argc > 27 ? argv[27] : "";
+  long checkpointSteps = argc > 28 ? atol(argv[28]) : 0;
+  long step = 0;
+  Checkpoint checkpoint;
+  // optional: resume the exploration from a checkpoint written by a previous run
+  if (argc > 29 and string(argv[29]) != "")
+  {
+    bool restored = checkpoint.load(argv[29])
+                    && utils.restoreCheckpoint(checkpoint, &map, &graph2, &history, &nearCandidates,
+                                               &target, &previous, &rfid_tools)
+                    && tabuList.restore(checkpoint, "tabuList")
+                    && visitedCell.restore(checkpoint, "visitedCell")
+                    && checkpoint.getValue("step", &step)
+                    && checkpoint.getValue("count", &count)
+                    && checkpoint.getValue("numConfiguration", &numConfiguration)
+                    && checkpoint.getValue("sensedCells", &sensedCells)
+                    && checkpoint.getValue("newSensedCells", &newSensedCells)
+                    && checkpoint.getValue("travelledDistance", &travelledDistance)
+                    && checkpoint.getValue("numOfTurning", &numOfTurning)
+                    && checkpoint.getValue("totalAngle", &totalAngle)
+                    && checkpoint.getValue("totalScanTime", &totalScanTime)
+                    && checkpoint.getValue("accumulated_received_power", &accumulated_received_power)
+                    && checkpoint.getValue("batteryTime", &batteryTime)
+                    && checkpoint.getValue("btMode", &btMode)
+                    && checkpoint.getValue("encodedKeyValue", &encodedKeyValue)
+                    && checkpoint.getValue("threshold", &threshold);
+    if (!restored)
+    {
+      std::cout << "Can't resume from the checkpoint " << argv[29] << endl;
+      return 1;
+    }
+    std::cout << "Resumed from the checkpoint " << argv[29] << " at step " << step << endl;
+  }
+  // optional: evaluate the candidates on the beliefs published at the end of
+  // the previous step, while the measurements of the current one are added.
+  // The map has no snapshots: its update (the scan and the planning grid)
+  // takes a fraction of the belief update and stays on this thread, because
+  // the information gain of the next candidates depends on the cells just
+  // scanned. Only the beliefs are read while being written.
+  bool pipelineUpdates = argc > 30 ? bool(atoi(argv[30])) : false;
+  EpochSnapshots<RadarModel> beliefs;
+  RFID_tools snapshot_tools = rfid_tools;
+  std::thread beliefUpdate;
+  if (pipelineUpdates)
+    beliefs.publish(rm.snapshot());
+  // wait for the belief update of the current step and publish its result
+  auto finishBeliefUpdate = [&]() {
+    if (!beliefUpdate.joinable()) return;
+    beliefUpdate.join();
+    beliefs.publish(rm.snapshot());
+  };
   do
   {
     if (graph2.size() == 1 and count > 1) break;
@@ -265,7 +320,7 @@ int main ( int argc, char **argv )
     {
       // std::cout << "Area sensed: " << newSensedCells << " / " << totalFreeCells << " ["<< 100*(float)newSensedCells/(float)totalFreeCells << "%] - Battery: " << to_string(100*batteryTime/MAX_BATTERY) << endl;
       // std::cout <<"   Graph: " << graph2.size() << endl;
-      travelledDistance = utils.calculateDistance(tabuList, &map, &astar );
+      travelledDistance = utils.calculateDistance(tabuList.getKeys(), &map, &astar );
       content = to_string(w_info_gain) 
                 + "," + to_string(w_travel_distance)
                 + "," + to_string(w_sensing_time) 
@@ -285,7 +340,7 @@ int main ( int argc, char **argv )
       orientation = target.getOrientation();
       range = target.getRange();
       FOV = target.getFOV();
-      actualPose = function.getEncodedKey ( target,0 );
+      actualPose = PoseKey ( target );
       map.setCurrentPose ( target );
 
       //NOTE; calculate path and turnings between actual position and goal
@@ -302,8 +357,7 @@ int main ( int argc, char **argv )
       // // Update the overall number of turnings
       // numOfTurning = numOfTurning + astar.getNumberOfTurning ( path );
 
-      encoding = to_string ( target.getX() ) + to_string ( target.getY() );
-      visitedCell.emplace ( encoding,0 );
+      visitedCell.insert ( PoseKey ( target.getX(), target.getY() ) );
       // Get the sensing time required for scanning
       target.setScanAngles ( ray.getSensingTime ( &map,x,y,orientation,FOV,range ) );
       // Perform a scanning operation
@@ -319,7 +373,17 @@ int main ( int argc, char **argv )
       // Update the overall scanning time
       totalScanTime += utils.calculateScanTime ( scanAngle*180/PI );
       // Update bot the PP and the RFID maps
-      utils.updateMaps(&map, &target, &rfid_tools, false);
+      RFID_tools *evaluation_tools = &rfid_tools;
+      std::shared_ptr<RadarModel> published;
+      if (pipelineUpdates)
+      {
+        published = beliefs.acquire();
+        snapshot_tools.rm = published.get();
+        evaluation_tools = &snapshot_tools;
+        beliefUpdate = utils.updateMapsAsync(&map, &target, &rfid_tools);
+      }
+      else
+        utils.updateMaps(&map, &target, &rfid_tools, false);
         // rfid_tools.rm->saveProbMapDebug("/tmp/test/",0,count,x,y,-orientation*M_PI/180);
       // Search for new candidate position
       ray.findCandidatePositions ( &map,x,y,orientation,FOV,range );
@@ -327,15 +391,20 @@ int main ( int argc, char **argv )
       ray.emptyCandidatePositions();
       // Push position into the navigation graph
       break_loop = utils.updateNavigationGraph(&count, &function, &graph2, &target, &map, &x, &y,
-                                              &orientation, &range, &FOV, &threshold, &actualPose, &rfid_tools, &batteryTime);
-      if (break_loop == true) break;
+                                              &orientation, &range, &FOV, &threshold, &actualPose, evaluation_tools, &batteryTime);
+      if (break_loop == true)
+      {
+        finishBeliefUpdate();
+        break;
+      }
       break_loop = utils.forwardMotion(&target, &previous, &frontiers, &nearCandidates, &candidatePosition, &ray, &map,
                                             &x, &y, &orientation, &FOV, &range, &graph2,
                                             &record, &function, &threshold, &count, &history,
                                             &tmp_history, &tabuList, &astar, &imgresolution, &travelledDistance,
                                             &sensedCells, &newSensedCells, &totalFreeCells, &totalScanTime, &out_log, 
                                             &numConfiguration, &actualPose, &encodedKeyValue, &totalAngle, &numOfTurning,
-                                            &scanAngle, &btMode, &rfid_tools, &accumulated_received_power, &precision, &batteryTime);
+                                            &scanAngle, &btMode, evaluation_tools, &accumulated_received_power, &precision, &batteryTime);
+      finishBeliefUpdate();
       // cout << "break_loop: " << break_loop << endl;                                      
       // calculate the accumulate received power
       for (int tag_id = 0; tag_id < tags_coord.size(); tag_id++){
@@ -362,7 +431,7 @@ int main ( int argc, char **argv )
       orientation = target.getOrientation();
       range = target.getRange();
       FOV = target.getFOV();
-      actualPose = function.getEncodedKey ( target,0 );
+      actualPose = PoseKey ( target );
       map.setCurrentPose ( target );
       //NOTE; calculate path and turnings between actual position and goal
       // Calculate the distance between the previous robot pose and the next one (target)
@@ -377,8 +446,7 @@ int main ( int argc, char **argv )
       // batteryTime = batteryTime - (translTime + rotTime);  
       // Update the overall number of turnings
       // numOfTurning = numOfTurning + astar.getNumberOfTurning ( path );
-      encoding = to_string ( target.getX() ) + to_string ( target.getY() );
-      visitedCell.emplace ( encoding,0 );
+      visitedCell.insert ( PoseKey ( target.getX(), target.getY() ) );
       // Set the previous cell to be the same of the current one
       previous = target;
       // Calculate how much time it takes to scan the current area
@@ -398,6 +466,8 @@ int main ( int argc, char **argv )
       // Get the list of the candidate cells with their evaluation
       // TODO: nearCandidates seems to be empty
       EvaluationRecords *record = function.evaluateFrontiers ( nearCandidates, &map, threshold, &rfid_tools, &batteryTime );
+      if ( function.pruneCandidates )
+        std::cout << "   pruned candidates: " << function.getLastPruneRate() * 100 << "%" << endl;
       // std::cout << "   record: " << record->size() << endl;
       // If there are candidate cells
       if ( record->size() != 0 )
@@ -421,7 +491,32 @@ int main ( int argc, char **argv )
       }
       delete record;
     }
-    batteryPercentage = utils.calculateRemainingBatteryPercentage(tabuList, &map, &astar);
+    batteryPercentage = utils.calculateRemainingBatteryPercentage(tabuList.getKeys(), &map, &astar);
+    step++;
+    if (checkpointSteps > 0 and step % checkpointSteps == 0)
+    {
+      checkpoint.clear();
+      utils.saveCheckpoint(&checkpoint, &map, &graph2, &history, &nearCandidates,
+                           &target, &previous, &rfid_tools, true);
+      tabuList.save(&checkpoint, "tabuList");
+      visitedCell.save(&checkpoint, "visitedCell");
+      checkpoint.putValue("step", step);
+      checkpoint.putValue("count", count);
+      checkpoint.putValue("numConfiguration", numConfiguration);
+      checkpoint.putValue("sensedCells", sensedCells);
+      checkpoint.putValue("newSensedCells", newSensedCells);
+      checkpoint.putValue("travelledDistance", travelledDistance);
+      checkpoint.putValue("numOfTurning", numOfTurning);
+      checkpoint.putValue("totalAngle", totalAngle);
+      checkpoint.putValue("totalScanTime", totalScanTime);
+      checkpoint.putValue("accumulated_received_power", accumulated_received_power);
+      checkpoint.putValue("batteryTime", batteryTime);
+      checkpoint.putValue("btMode", btMode);
+      checkpoint.putValue("encodedKeyValue", encodedKeyValue);
+      checkpoint.putValue("threshold", threshold);
+      if (!checkpoint.save(checkpoint_file))
+        std::cout << "Can't write the checkpoint " << checkpoint_file << endl;
+    }
   }
   // Perform exploration until a certain coverage is achieved
   while ( sensedCells < precision * totalFreeCells and batteryPercentage > 0.0);
@@ -436,7 +531,7 @@ int main ( int argc, char **argv )
   // std::cout << "------------------ HISTORY -----------------" << endl;
   // Calculate which cells have been visited only once
   // FIXME: history doesn't contain last visited cell
-  tmp_history = utils.cleanHistory(&history, &record);
+  tmp_history = utils.cleanHistory(&history);
   // cout << "1" << endl;
   travelledDistance = utils.calculateDistance(tmp_history, &map, &astar );
   // cout << "2" << endl;
@@ -445,8 +540,8 @@ int main ( int argc, char **argv )
   // NOTE: tabuList is the most reliable source of information regarding the cells actually visited
   // because it's is filled only when the cells are visited for the first time and not during virtual
   // backtracking. So we use tabuList for calculating the final "real" traversedDistance and remainingBatteryTime
-  travelledDistance =  utils.calculateDistance(tabuList, &map, &astar );
-  batteryPercentage = utils.calculateRemainingBatteryPercentage(tabuList, &map, &astar);
+  travelledDistance =  utils.calculateDistance(tabuList.getKeys(), &map, &astar );
+  batteryPercentage = utils.calculateRemainingBatteryPercentage(tabuList.getKeys(), &map, &astar);
   // cout << "3" << endl;
 
   double belief_accuracy = utils.findTags(&RFID_maps_list, &tags_coord, &map,
@@ -8,17 +8,140 @@
 #include "Criteria/sensingtimecriterion.h"
 #include "Criteria/batterystatuscriterion.h"
 #include "Criteria/mcdmweightreader.h"
-#include "Criteria/criterioncomparator.h"
 #include <string>
 #include <iostream>
 #include <stdlib.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <numeric>
 #include "newray.h"
 
 
 using namespace std;
 using namespace dummy;
 
+// Calls fn(i) for every candidate i in [0, numCandidates) on up to maxThreads
+// threads. Each thread grabs the next unevaluated candidate from a shared
+// counter, so a thread stuck on a long A* search doesn't hold back the rest.
+// fn must only write the results of its own candidate.
+template <typename F>
+static void forEachCandidate(int numCandidates, int maxThreads, F fn) {
+  int threads = std::min(maxThreads, numCandidates);
+  if (threads <= 1) {
+    for (int i = 0; i < numCandidates; i++)
+      fn(i);
+    return;
+  }
+  std::atomic<int> next(0);
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; t++) {
+    pool.emplace_back([&]() {
+      for (int i = next++; i < numCandidates; i = next++)
+        fn(i);
+    });
+  }
+  for (std::thread &th : pool)
+    th.join();
+}
+
+// Order the normalized values of one candidate, carrying along the bit of
+// each criterion in the WeightMatrix capacity table
+static inline void compareSwap(double *values, unsigned int *bits, int i, int j) {
+  if (values[j] < values[i]) {
+    swap(values[i], values[j]);
+    swap(bits[i], bits[j]);
+  }
+}
+
+static inline void sortCriteria(double *values, unsigned int *bits, int n) {
+  for (int j = 1; j < n; j++) {
+    for (int k = j; k > 0 and values[k] < values[k - 1]; k--) {
+      swap(values[k], values[k - 1]);
+      swap(bits[k], bits[k - 1]);
+    }
+  }
+}
+
+template <int N>
+static inline void sortCriteria(double *values, unsigned int *bits) {
+  sortCriteria(values, bits, N);
+}
+
+// Sorting networks for the criteria sets in use
+template <>
+inline void sortCriteria<3>(double *values, unsigned int *bits) {
+  compareSwap(values, bits, 0, 1);
+  compareSwap(values, bits, 1, 2);
+  compareSwap(values, bits, 0, 1);
+}
+
+template <>
+inline void sortCriteria<4>(double *values, unsigned int *bits) {
+  compareSwap(values, bits, 0, 1);
+  compareSwap(values, bits, 2, 3);
+  compareSwap(values, bits, 0, 2);
+  compareSwap(values, bits, 1, 3);
+  compareSwap(values, bits, 1, 2);
+}
+
+template <>
+inline void sortCriteria<5>(double *values, unsigned int *bits) {
+  compareSwap(values, bits, 0, 1);
+  compareSwap(values, bits, 3, 4);
+  compareSwap(values, bits, 2, 4);
+  compareSwap(values, bits, 2, 3);
+  compareSwap(values, bits, 1, 4);
+  compareSwap(values, bits, 0, 3);
+  compareSwap(values, bits, 0, 2);
+  compareSwap(values, bits, 1, 3);
+  compareSwap(values, bits, 1, 2);
+}
+
+// Choquet integral over values sorted in ascending order: every step weighs
+// the increment by the capacity of the criteria whose value is >= the current one
+static inline double choquetSum(const double *values, const unsigned int *bits, int n, unsigned int mask,
+                                const WeightMatrix *matrix) {
+  double finalValue = 0.0;
+  double lastValue = 0.0;
+  for (int k = 0; k < n; k++) {
+    finalValue += (values[k] - lastValue) * matrix->getCapacity(mask);
+    lastValue = values[k];
+    mask &= ~bits[k];
+  }
+  return finalValue;
+}
+
+template <int N>
+static double choquetIntegral(const ScoreMatrix &scores, int candidate, const unsigned int *criteriaBits,
+                              const WeightMatrix *matrix) {
+  double values[N];
+  unsigned int bits[N];
+  unsigned int mask = 0;
+  for (int j = 0; j < N; j++) {
+    values[j] = scores.getNormalized(j, candidate);
+    bits[j] = criteriaBits[j];
+    mask |= bits[j];
+  }
+  sortCriteria<N>(values, bits);
+  return choquetSum(values, bits, N, mask, matrix);
+}
+
+// Any other number of criteria (the capacity table has 2^N entries, so N is small)
+static double choquetIntegral(const ScoreMatrix &scores, int candidate, const unsigned int *criteriaBits, int n,
+                              const WeightMatrix *matrix) {
+  double values[32];
+  unsigned int bits[32];
+  unsigned int mask = 0;
+  for (int j = 0; j < n; j++) {
+    values[j] = scores.getNormalized(j, candidate);
+    bits[j] = criteriaBits[j];
+    mask |= bits[j];
+  }
+  sortCriteria(values, bits, n);
+  return choquetSum(values, bits, n, mask, matrix);
+}
+
 
 MCDMFunction::MCDMFunction(float w_criterion_1, float w_criterion_2, float w_criterion_3, bool use_mcdm)
 {
@@ -128,7 +251,6 @@ void MCDMFunction::evaluateFrontier(Pose &p, dummy::Map *map, RFID_tools *rfid_t
 EvaluationRecords *
 MCDMFunction::evaluateFrontiers(const std::list<Pose> &frontiers, dummy::Map *map, double threshold, RFID_tools *rfid_tools, double *batteryTime) {
 
-  Pose f;
   //Clean the last evaluation
   //NOTE: probably working
   unordered_map<string, Criterion *>::iterator it;
@@ -146,111 +268,252 @@ MCDMFunction::evaluateFrontiers(const std::list<Pose> &frontiers, dummy::Map *ma
     // cout << "   " << criteria[*it] << endl;
   }
 
-  //Evaluate the frontiers
-  list<Pose>::const_iterator it2;
-  for (it2 = frontiers.begin(); it2 != frontiers.end(); it2++) {
-    f = *it2;
-    evaluateFrontier(f, map, rfid_tools, batteryTime);
+  // Give every frontier a dense index: the raw and normalized values of the
+  // criteria are stored per (criterion, index) in the score matrix
+  vector<Pose> candidates(frontiers.begin(), frontiers.end());
+  int numCandidates = candidates.size();
+  int numCriteria = activeCriteria.size();
+  scores.reset(numCandidates, numCriteria);
+  int infoGainIndex = -1;
+  vector<unsigned int> criteriaBits(numCriteria);
+  for (int j = 0; j < numCriteria; j++) {
+    criteriaBits[j] = matrix->getCriterionMask(activeCriteria[j]->getName());
+    if (activeCriteria[j]->getName().compare("informationGain") == 0) {
+      infoGainIndex = j;
+    }
+  }
+
+  //Evaluate the frontiers: every candidate fills its own cells of the score
+  //matrix, so the values don't depend on the number of threads
+  if (timeBudget > 0 or pruneCandidates) {
+    lastEvaluationExact = evaluateStaged(candidates, map, rfid_tools, batteryTime);
+    numCandidates = candidates.size();
+  } else {
+    forEachCandidate(numCandidates, evaluationThreads, [&](int i) {
+      Pose candidate = candidates[i];
+      for (int j = 0; j < numCriteria; j++) {
+        scores.setRaw(j, i, activeCriteria[j]->computeEvaluation(candidate, map, rfid_tools, batteryTime));
+      }
+    });
+    lastEvaluationExact = true;
+    lastPruneRate = 0.0;
   }
 
   //Normalize the values
-  for (vector<Criterion *>::iterator it = activeCriteria.begin(); it != activeCriteria.end(); ++it) {
-    (*it)->normalize();
+  scores.copyRawToNormalized();
+  for (int j = 0; j < numCriteria; j++) {
+    activeCriteria[j]->normalize(scores.getNormalizedColumn(j), numCandidates);
   }
 
   //Create the EvaluationRecords
   EvaluationRecords *toRet = new EvaluationRecords();
-  
 
+  // analyze every single frontier, and add in the evaluationRecords <frontier, evaluation>
+  for (int i = 0; i < numCandidates; i++) {
 
-  // analyze every single frontier f, and add in the evaluationRecords <frontier, evaluation>
-  for (list<Pose>::const_iterator i = frontiers.begin(); i != frontiers.end(); i++) {
-
-    // cout <<"---------------------NEW FRONTIER -------------------"<<endl;
-    f = *i;
-
-    // order criteria depending on the considered frontier
-    sort(activeCriteria.begin(), activeCriteria.end(), CriterionComparator(f));
-
-    //apply the choquet integral
-    Criterion *lastCrit = NULL;
     double finalValue = 0.0;
-    // cout << "\n==== New frontier ====" << endl;
-    bool no_info_gain = false;
-    
+    bool no_info_gain = infoGainIndex >= 0 and scores.getNormalized(infoGainIndex, i) == 0;
+
     // WEIGHTED AVG
     if (this->use_mcdm == false){
-      for (vector<Criterion *>::iterator k = activeCriteria.begin(); k != activeCriteria.end(); k++) {
-        Criterion *c = NULL;
-        double weight = 0.0;
-        list<string> names;
-        names.push_back((*k)->getName());
-        // Get the weight of the single criterion
-        weight = matrix->getWeight(names);
-        finalValue += (*k)->getWeight() * (*k)->getEvaluation(f);
-        if ((*k)->getName().compare("informationGain") == 0){
-          if ((*k)->getEvaluation(f) == 0){
-            no_info_gain = true;
-          }
-        }
+      for (int j = 0; j < numCriteria; j++) {
+        finalValue += activeCriteria[j]->getWeight() * scores.getNormalized(j, i);
       }
     }else{
-      //MCDM
-      for (vector<Criterion *>::iterator k = activeCriteria.begin(); k != activeCriteria.end(); k++) {
-        Criterion *c = NULL;
-        double weight = 0.0;
-        list<string> names;
-        for (vector<Criterion *>::iterator j = k; j != activeCriteria.end(); j++) {
-          Criterion *next = (*j);
-          names.push_back(next->getName()); // The list of criteria whose evaluation is >= than the one's considered
-        }
-        weight = matrix->getWeight(names);
-        if (k == activeCriteria.begin()) {
-          c = (*k);
-          finalValue += c->getEvaluation(f) * weight;
-        } else {
-          c = (*k);
-          double tmpValue = c->getEvaluation(f) - lastCrit->getEvaluation(f);
-          finalValue += tmpValue * weight;
-        }
-        lastCrit = c;
-
-        if (c->getName().compare("informationGain") == 0){
-          if (c->getEvaluation(f) == 0){
-            no_info_gain = true;
-          }
-        }
+      //MCDM: apply the choquet integral
+      switch (numCriteria) {
+        case 3:
+          finalValue = choquetIntegral<3>(scores, i, criteriaBits.data(), matrix);
+          break;
+        case 4:
+          finalValue = choquetIntegral<4>(scores, i, criteriaBits.data(), matrix);
+          break;
+        case 5:
+          finalValue = choquetIntegral<5>(scores, i, criteriaBits.data(), matrix);
+          break;
+        default:
+          finalValue = choquetIntegral(scores, i, criteriaBits.data(), numCriteria, matrix);
       }
+    }
+
+    if (finalValue > threshold and no_info_gain == false) {
+      toRet->putEvaluation(candidates[i], finalValue);
+    }
+  }
+
+  activeCriteria.clear();
+  return toRet;
+}
 
+bool MCDMFunction::evaluateStaged(vector<Pose> &candidates, dummy::Map *map, RFID_tools *rfid_tools,
+                                  double *batteryTime) {
+  bool budgeted = timeBudget > 0;
+  chrono::steady_clock::time_point deadline =
+      chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeBudget));
+  int numCandidates = candidates.size();
+  int numCriteria = activeCriteria.size();
+  int infoGainIndex = -1;
+  vector<int> cheap, expensive;
+  for (int j = 0; j < numCriteria; j++) {
+    if (activeCriteria[j]->getName().compare("informationGain") == 0)
+      infoGainIndex = j;
+    if (activeCriteria[j]->isExpensive())
+      expensive.push_back(j);
+    else
+      cheap.push_back(j);
+  }
+  lastPruneRate = 0.0;
 
+  // 1) cheap criteria for every candidate, whatever the budget
+  forEachCandidate(numCandidates, evaluationThreads, [&](int i) {
+    Pose candidate = candidates[i];
+    for (int j : cheap) {
+      scores.setRaw(j, i, activeCriteria[j]->computeEvaluation(candidate, map, rfid_tools, batteryTime));
     }
+  });
+  if (expensive.empty() or numCandidates == 0)
+    return true;
+
+  // 2) drop the candidates without information gain (they would be discarded
+  // after the aggregation anyway) and bound the expensive criteria of the others
+  vector<char> alive(numCandidates, 1);
+  vector<double> lower, upper;
+  int pruned = 0;
+  if (pruneCandidates) {
+    lower.assign(numCriteria * numCandidates, -INFINITY);
+    upper.assign(numCriteria * numCandidates, INFINITY);
+    for (int i = 0; i < numCandidates; i++) {
+      if (infoGainIndex >= 0 and scores.getRaw(infoGainIndex, i) <= 0) {
+        alive[i] = 0;
+        pruned++;
+        continue;
+      }
+      Pose candidate = candidates[i];
+      for (int j : expensive) {
+        activeCriteria[j]->computeBounds(candidate, map, rfid_tools, batteryTime, lower[j * numCandidates + i],
+                                         upper[j * numCandidates + i]);
+      }
+    }
+  }
 
-    if (finalValue > threshold and no_info_gain == false) {
-        toRet->putEvaluation(f, finalValue);
+  // 3) promise of a candidate: the weighted cheap criteria, each scaled to
+  // [0,1] over this set of candidates
+  vector<double> promise(numCandidates, 0.0);
+  for (int j : cheap) {
+    const double *values = scores.getRawColumn(j);
+    double minValue = *min_element(values, values + numCandidates);
+    double maxValue = *max_element(values, values + numCandidates);
+    if (maxValue <= minValue)
+      continue;
+    for (int i = 0; i < numCandidates; i++) {
+      double scaled = (values[i] - minValue) / (maxValue - minValue);
+      if (!activeCriteria[j]->isHighGood())
+        scaled = 1 - scaled;
+      promise[i] += activeCriteria[j]->getWeight() * scaled;
+    }
+  }
+  vector<int> order(numCandidates);
+  iota(order.begin(), order.end(), 0);
+  stable_sort(order.begin(), order.end(), [&](int a, int b) { return promise[a] > promise[b]; });
+
+  // b is dominated by a if a is at least as good on the cheap criteria and on
+  // the expensive ones even when b reaches its best bound: b can't win then
+  auto dominates = [&](int a, int b) {
+    for (int j : cheap) {
+      double va = scores.getRaw(j, a), vb = scores.getRaw(j, b);
+      if (activeCriteria[j]->isHighGood() ? !(va >= vb) : !(va <= vb))
+        return false;
+    }
+    for (int j : expensive) {
+      double va = scores.getRaw(j, a);
+      if (activeCriteria[j]->isHighGood() ? !(va >= upper[j * numCandidates + b])
+                                          : !(va <= lower[j * numCandidates + b]))
+        return false;
+    }
+    return true;
+  };
+
+  // 4) expensive criteria in order of promise, in batches, until the deadline.
+  // Before each batch the candidates dominated by an evaluated one are pruned;
+  // the batch size doesn't depend on the threads, so neither does the pruning.
+  // The most promising candidate is always evaluated so that there is an answer.
+  vector<char> evaluated(numCandidates, 0);
+  vector<int> dominators;
+  int batchSize = pruneCandidates ? PRUNE_BATCH_SIZE : numCandidates;
+  bool anyEvaluated = false;
+  bool expired = false;
+  int cursor = 0;
+  vector<int> batch;
+  while (cursor < numCandidates and !expired) {
+    batch.clear();
+    while (cursor < numCandidates and batch.size() < batchSize) {
+      int i = order[cursor++];
+      if (!alive[i])
+        continue;
+      bool dominated = false;
+      for (int k = 0; k < dominators.size() and !dominated; k++) {
+        dominated = dominates(dominators[k], i);
+      }
+      if (dominated) {
+        alive[i] = 0;
+        pruned++;
+        continue;
       }
-  
+      batch.push_back(i);
     }
-    
+    forEachCandidate(batch.size(), evaluationThreads, [&](int k) {
+      if (budgeted and (k > 0 or anyEvaluated) and chrono::steady_clock::now() >= deadline)
+        return;
+      int i = batch[k];
+      Pose candidate = candidates[i];
+      for (int j : expensive) {
+        scores.setRaw(j, i, activeCriteria[j]->computeEvaluation(candidate, map, rfid_tools, batteryTime));
+      }
+      evaluated[i] = 1;
+    });
+    for (int i : batch) {
+      if (!evaluated[i])
+        continue;
+      anyEvaluated = true;
+      // a candidate without information gain is discarded, it can't prune others
+      if (pruneCandidates and (infoGainIndex < 0 or scores.getRaw(infoGainIndex, i) > 0))
+        dominators.push_back(i);
+    }
+    expired = budgeted and chrono::steady_clock::now() >= deadline;
+  }
+  lastPruneRate = (double)pruned / numCandidates;
+
+  vector<int> kept;
+  for (int i = 0; i < numCandidates; i++) {
+    if (evaluated[i])
+      kept.push_back(i);
+  }
+  // cout << "[mcdmfunction.cpp@evaluateStaged] evaluated " << kept.size() << "/" << numCandidates << ", pruned " << pruned << endl;
+  // pruned candidates change the normalization of the others as well
+  bool exact = kept.size() == numCandidates;
+  if (kept.size() < numCandidates) {
+    vector<Pose> evaluatedCandidates;
+    for (int i : kept) {
+      evaluatedCandidates.push_back(candidates[i]);
+    }
+    candidates.swap(evaluatedCandidates);
+    scores.keepCandidates(kept);
+  }
+  return exact;
+}
 
-    
+bool MCDMFunction::isLastEvaluationExact() const {
+  return lastEvaluationExact;
+}
 
-  activeCriteria.clear();
-  return toRet;
+double MCDMFunction::getLastPruneRate() const {
+  return lastPruneRate;
 }
 
 pair<Pose, double> MCDMFunction::selectNewPose(EvaluationRecords *evaluationRecords) {
-  Pose newTarget;
-  double value = 0;
-  unordered_map<string, double> evaluation = evaluationRecords->getEvaluations();
-  for (unordered_map<string, double>::iterator it = evaluation.begin(); it != evaluation.end(); it++) {
-    string tmp = (*it).first;
-    Pose p = evaluationRecords->getPoseFromEncoding(tmp);
-    if (value <= (*it).second) {
-      newTarget = p;
-      value = (*it).second;
-    }//else continue;
-  }
-  pair<Pose, double> result = make_pair(newTarget, value);
+  pair<Pose, double> result = evaluationRecords->getBest();
+  // as before, frontiers with a negative utility are never selected
+  if (result.second < 0) result = make_pair(Pose(), 0.0);
 
   // i switch x and y to allow debugging graphically looking the image
 //     cout << "New target : " << "x = "<<newTarget.getY() <<", y = "<< newTarget.getX() << ", orientation = "
@@ -258,22 +521,3 @@ pair<Pose, double> MCDMFunction::selectNewPose(EvaluationRecords *evaluationReco
   return result;
 }
 
-string MCDMFunction::getEncodedKey(Pose &p, int value) {
-  string key;
-  //value = 0 : encode everything
-  //value = 1 : encode x,y,orientation, take first
-  //value = 2 : encode x,y,orientation, take multiple time
-  if (value == 0) {
-    key = to_string(p.getX()) + "/" + to_string(p.getY()) + "/" + to_string(p.getOrientation()) + "/" +
-          to_string(p.getRange())
-          + "/" + to_string(p.getFOV()) + to_string(p.getScanAngles().first) + "/" +
-          to_string(p.getScanAngles().second);
-  } else if (value == 1) {
-    key = to_string(p.getX()) + "/" + to_string(p.getY()) + "/" + to_string(p.getOrientation()) + "/" + "1";
-  } else if (value == 2) {
-    key = to_string(p.getX()) + "/" + to_string(p.getY()) + "/" + to_string(p.getOrientation()) + "/" + "2";
-  }
-  return key;
-}
-
-
@@ -0,0 +1,110 @@
+#include "navigationgraph.h"
+#include <cassert>
+
+
+NavigationGraph::NavigationGraph()
+{
+}
+
+NavigationGraph::~NavigationGraph()
+{
+}
+
+void NavigationGraph::push(PoseKey pose, const list<Pose> &candidates)
+{
+  poses.push_back(pose);
+  firstCandidate.push_back(arena.size());
+  for (list<Pose>::const_iterator it = candidates.begin(); it != candidates.end(); it++) {
+    // Pose getters are not const
+    Pose p = *it;
+    arena.push_back(PoseKey(p));
+  }
+}
+
+void NavigationGraph::push(PoseKey pose)
+{
+  poses.push_back(pose);
+  firstCandidate.push_back(arena.size());
+}
+
+void NavigationGraph::pop()
+{
+  assert(!poses.empty());
+  arena.resize(firstCandidate.back());
+  firstCandidate.pop_back();
+  poses.pop_back();
+}
+
+int NavigationGraph::size() const
+{
+  return poses.size();
+}
+
+PoseKey NavigationGraph::getPose(int node) const
+{
+  return poses[node];
+}
+
+int NavigationGraph::getNumCandidates(int node) const
+{
+  int end = node + 1 < (int)poses.size() ? firstCandidate[node + 1] : arena.size();
+  return end - firstCandidate[node];
+}
+
+void NavigationGraph::getCandidates(int node, list<Pose> *candidates) const
+{
+  candidates->clear();
+  int begin = firstCandidate[node];
+  int end = begin + getNumCandidates(node);
+  for (int i = begin; i < end; i++)
+    candidates->push_back(arena[i].toPose());
+}
+
+PoseKey NavigationGraph::getTopPose() const
+{
+  assert(!poses.empty());
+  return poses.back();
+}
+
+int NavigationGraph::getTopNumCandidates() const
+{
+  assert(!poses.empty());
+  return arena.size() - firstCandidate.back();
+}
+
+void NavigationGraph::getTopCandidates(list<Pose> *candidates) const
+{
+  assert(!poses.empty());
+  getCandidates(poses.size() - 1, candidates);
+}
+
+void NavigationGraph::save(Checkpoint *checkpoint, const std::string &name) const
+{
+  vector<uint64_t> poseBits, arenaBits;
+  for (vector<PoseKey>::const_iterator it = poses.begin(); it != poses.end(); it++)
+    poseBits.push_back(it->getBits());
+  for (vector<PoseKey>::const_iterator it = arena.begin(); it != arena.end(); it++)
+    arenaBits.push_back(it->getBits());
+  checkpoint->putVector(name + ".poses", poseBits);
+  checkpoint->putVector(name + ".firstCandidate", firstCandidate);
+  checkpoint->putVector(name + ".arena", arenaBits);
+}
+
+bool NavigationGraph::restore(const Checkpoint &checkpoint, const std::string &name)
+{
+  vector<uint64_t> poseBits, arenaBits;
+  vector<int> offsets;
+  if (!checkpoint.getVector(name + ".poses", &poseBits) || !checkpoint.getVector(name + ".firstCandidate", &offsets)
+      || !checkpoint.getVector(name + ".arena", &arenaBits) || offsets.size() != poseBits.size())
+    return false;
+  for (size_t i = 0; i < offsets.size(); i++)
+    if (offsets[i] < (i > 0 ? offsets[i - 1] : 0) || offsets[i] > (int)arenaBits.size()) return false;
+  poses.clear();
+  arena.clear();
+  for (vector<uint64_t>::iterator it = poseBits.begin(); it != poseBits.end(); it++)
+    poses.push_back(PoseKey::fromBits(*it));
+  for (vector<uint64_t>::iterator it = arenaBits.begin(); it != arenaBits.end(); it++)
+    arena.push_back(PoseKey::fromBits(*it));
+  firstCandidate = offsets;
+  return true;
+}
@@ -47,21 +47,16 @@ int NewRay::isCandidate2(const dummy::Map *map, long i, long j)
   long minR = r - 1, maxR = r + 1, minS = s -1, maxS = s + 1;
   if(minR < 0) minR = 0;
   if(minS < 0) minS = 0;
-  if(maxR > map->getPathPlanningNumRows()) maxR = map->getPathPlanningNumRows();
-  if(maxS > map->getPathPlanningNumCols()) maxS = map->getPathPlanningNumCols();
+  if(maxR > map->getPathPlanningNumRows() - 1) maxR = map->getPathPlanningNumRows() - 1;
+  if(maxS > map->getPathPlanningNumCols() - 1) maxS = map->getPathPlanningNumCols() - 1;
 
 
   for(r = minR; r <= maxR; ++r)
   {
     for(s = minS; s <= maxS; ++s)
     {
-      for(int rg = r*gridToPathGridScale; rg < r*gridToPathGridScale + gridToPathGridScale; ++rg)
-      {
-        for(int sg = s*gridToPathGridScale; sg < s*gridToPathGridScale + gridToPathGridScale; ++sg)
-        {
-          if (map->getGridValue(rg, sg) == 0) candidate = 1;
-        }
-      }
+      // one of the cells of the grid inside is still free and unscanned
+      if (map->getUnscannedSubcells(r, s) > 0) candidate = 1;
     }
   }
   return candidate;
@@ -327,8 +322,8 @@ std::pair<double,double> NewRay::getSensingTime(const dummy::Map *map, long posX
 
   if(minI < 0) minI = 0;
   if(minJ < 0) minJ = 0;
-  if(maxI > map->getNumGridRows()) maxI = map->getNumGridRows();
-  if(maxJ > map->getNumGridCols()) maxJ = map->getNumGridCols();
+  if(maxI > map->getNumGridRows() - 1) maxI = map->getNumGridRows() - 1;
+  if(maxJ > map->getNumGridCols() - 1) maxJ = map->getNumGridCols() - 1;
 
   //scan the cells in the selected portion of the map
   for(long i = minI; i <= maxI; ++i)
@@ -533,10 +528,10 @@ int NewRay::performSensingOperationEllipse(dummy::Map *map, long posX,
     minI = 0;
   if (minJ < 0)
     minJ = 0;
-  if (maxI > map->getNumGridRows())
-    maxI = map->getNumGridRows();
-  if (maxJ > map->getNumGridCols())
-    maxJ = map->getNumGridCols();
+  if (maxI > map->getNumGridRows() - 1)
+    maxI = map->getNumGridRows() - 1;
+  if (maxJ > map->getNumGridCols() - 1)
+    maxJ = map->getNumGridCols() - 1;
   if (debug) {
     printf("Update bounding box in nav cell scale: \n");
     printf("\t - minI,minJ  %lu, %lu (nCell) \n", minI, minJ);
@@ -676,14 +671,21 @@ int NewRay::performSensingOperation(dummy::Map *map, long posX, long posY, int o
 
   if(minI < 0) minI = 0;
   if(minJ < 0) minJ = 0;
-  if(maxI > map->getNumGridRows()) maxI = map->getNumGridRows();
-  if(maxJ > map->getNumGridCols()) maxJ = map->getNumGridCols();
+  if(maxI > map->getNumGridRows() - 1) maxI = map->getNumGridRows() - 1;
+  if(maxJ > map->getNumGridCols() - 1) maxJ = map->getNumGridCols() - 1;
+
+  //nothing left to scan in the selected portion of the map
+  if(map->countUnscannedCells(minI, minJ, maxI, maxJ) == 0) return 0;
 
   //scan the cells in the selected portion of the map
   for(long i = minI; i <= maxI; ++i)
   {
     for(long j = minJ; j <=maxJ; ++j)
     {
+      //jump over the blocks where every cell is already scanned or an obstacle
+      j = map->skipScannedBlocks(i, j, maxJ);
+      if(j > maxJ) break;
+
 
       double distance = sqrt((i - posX*gridToPathGridScale)*(i - posX*gridToPathGridScale) + (j - posY*gridToPathGridScale)*(j - posY*gridToPathGridScale));
 
@@ -788,14 +790,21 @@ int NewRay::getInformationGain(const dummy::Map *map, long posX, long posY, int
 
   if(minI < 0) minI = 0;
   if(minJ < 0) minJ = 0;
-  if(maxI > map->getNumGridRows()) maxI = map->getNumGridRows();
-  if(maxJ > map->getNumGridCols()) maxJ = map->getNumGridCols();
+  if(maxI > map->getNumGridRows() - 1) maxI = map->getNumGridRows() - 1;
+  if(maxJ > map->getNumGridCols() - 1) maxJ = map->getNumGridCols() - 1;
+
+  //nothing left to scan in the selected portion of the map
+  if(map->countUnscannedCells(minI, minJ, maxI, maxJ) == 0) return 0;
 
   //scan the cells in the selected portion of the map
   for(long i = minI; i <= maxI; ++i)
   {
     for(long j = minJ; j <=maxJ; ++j)
     {
+      //jump over the blocks where every cell is already scanned or an obstacle
+      j = map->skipScannedBlocks(i, j, maxJ);
+      if(j > maxJ) break;
+
       double distance = sqrt((i - posX*gridToPathGridScale)*(i - posX*gridToPathGridScale) + (j - posY*gridToPathGridScale)*(j - posY*gridToPathGridScale));
 
       //if a cell is free and within range of the robot, generate the ray connecting the robot cell and the free cell
@@ -893,8 +902,8 @@ int NewRay::getRFIDGain(const dummy::Map *map, long posX, long posY, int orienta
 
   if(minI < 0) minI = 0;
   if(minJ < 0) minJ = 0;
-  if(maxI > map->getNumGridRows()) maxI = map->getNumGridRows();
-  if(maxJ > map->getNumGridCols()) maxJ = map->getNumGridCols();
+  if(maxI > map->getNumGridRows() - 1) maxI = map->getNumGridRows() - 1;
+  if(maxJ > map->getNumGridCols() - 1) maxJ = map->getNumGridCols() - 1;
 
   //scan the cells in the selected portion of the map
   for(long i = minI; i <= maxI; ++i)
@@ -970,6 +979,7 @@ int NewRay::getRFIDGain(const dummy::Map *map, long posX, long posY, int orienta
 int NewRay::setGridToPathGridScale(int value)
 {
   gridToPathGridScale = value;
+  return gridToPathGridScale;
 }
 
 
@@ -1004,8 +1014,8 @@ void NewRay::performRFIDSensingOperation(dummy::Map *map, long posX, long posY,
 
   if(minI < 0) minI = 0;
   if(minJ < 0) minJ = 0;
-  if(maxI > map->getNumGridRows()) maxI = map->getNumGridRows();
-  if(maxJ > map->getNumGridCols()) maxJ = map->getNumGridCols();
+  if(maxI > map->getNumGridRows() - 1) maxI = map->getNumGridRows() - 1;
+  if(maxJ > map->getNumGridCols() - 1) maxJ = map->getNumGridCols() - 1;
 
   //scan the cells in the selected portion of the map
   for(long i = minI; i <= maxI; ++i)
@@ -0,0 +1,121 @@
+#include "occupancygrid.h"
+#include <algorithm>
+
+const uint8_t OccupancyGrid::FREE;
+const uint8_t OccupancyGrid::OBSTACLE;
+const uint8_t OccupancyGrid::SCANNED;
+const int OccupancyGrid::TILE_BITS;
+const int OccupancyGrid::TILE_SIZE;
+
+OccupancyGrid::OccupancyGrid()
+  : numRows(0), numCols(0), numTileCols(0)
+{
+}
+
+OccupancyGrid::OccupancyGrid(long numRows, long numCols, uint8_t value)
+{
+  assign(numRows, numCols, value);
+}
+
+OccupancyGrid::~OccupancyGrid()
+{
+}
+
+void OccupancyGrid::assign(long numRows, long numCols, uint8_t value)
+{
+  this->numRows = numRows;
+  this->numCols = numCols;
+  numTileCols = (numCols + TILE_SIZE - 1) >> TILE_BITS;
+  long numTileRows = (numRows + TILE_SIZE - 1) >> TILE_BITS;
+  tiles.clear();
+  tiles.resize(numTileRows * numTileCols);
+  uniform.assign(numTileRows * numTileCols, value);
+}
+
+long OccupancyGrid::releaseUniformTiles()
+{
+  long released = 0;
+  for (size_t tile = 0; tile < tiles.size(); tile++) {
+    vector<uint8_t> &cells = tiles[tile];
+    if (cells.empty()) continue;
+    // cells past the border keep the value the tile had when allocated
+    if (std::count(cells.begin(), cells.end(), cells[0]) == (long)cells.size()) {
+      uniform[tile] = cells[0];
+      vector<uint8_t>().swap(cells);
+      released++;
+    }
+  }
+  return released;
+}
+
+long OccupancyGrid::getNumAllocatedTiles() const
+{
+  long allocated = 0;
+  for (size_t tile = 0; tile < tiles.size(); tile++)
+    if (!tiles[tile].empty()) allocated++;
+  return allocated;
+}
+
+long OccupancyGrid::count(uint8_t value) const
+{
+  long total = 0;
+  for (size_t tile = 0; tile < tiles.size(); tile++) {
+    long firstRow = (tile / numTileCols) << TILE_BITS;
+    long firstCol = (tile % numTileCols) << TILE_BITS;
+    long rows = std::min<long>(TILE_SIZE, numRows - firstRow);
+    long cols = std::min<long>(TILE_SIZE, numCols - firstCol);
+    const vector<uint8_t> &cells = tiles[tile];
+    if (cells.empty()) {
+      if (uniform[tile] == value) total += rows * cols;
+      continue;
+    }
+    for (long row = 0; row < rows; row++) {
+      const uint8_t *line = &cells[row << TILE_BITS];
+      total += std::count(line, line + cols, value);
+    }
+  }
+  return total;
+}
+
+long OccupancyGrid::getNumRows() const
+{
+  return numRows;
+}
+
+long OccupancyGrid::getNumCols() const
+{
+  return numCols;
+}
+
+long OccupancyGrid::size() const
+{
+  return numRows * numCols;
+}
+
+void OccupancyGrid::save(Checkpoint *checkpoint, const std::string &name) const
+{
+  vector<long> dimensions;
+  dimensions.push_back(numRows);
+  dimensions.push_back(numCols);
+  vector<uint8_t> values(numRows * numCols);
+  for (long row = 0; row < numRows; row++)
+    for (long col = 0; col < numCols; col++)
+      values[row * numCols + col] = get(row, col);
+  checkpoint->putVector(name + ".size", dimensions);
+  checkpoint->putVector(name + ".cells", values, true);
+}
+
+bool OccupancyGrid::restore(const Checkpoint &checkpoint, const std::string &name)
+{
+  vector<long> dimensions;
+  vector<uint8_t> values;
+  if (!checkpoint.getVector(name + ".size", &dimensions) || dimensions.size() != 2
+      || !checkpoint.getVector(name + ".cells", &values) || (long)values.size() != dimensions[0] * dimensions[1])
+    return false;
+  assign(dimensions[0], dimensions[1], FREE);
+  for (long row = 0; row < numRows; row++)
+    for (long col = 0; col < numCols; col++)
+      set(row, col, values[row * numCols + col]);
+  releaseUniformTiles();
+  return true;
+}
@@ -0,0 +1,110 @@
+#include "occupancypyramid.h"
+#include <algorithm>
+
+
+OccupancyPyramid::OccupancyPyramid()
+  : numRows(0), numCols(0)
+{
+}
+
+OccupancyPyramid::~OccupancyPyramid()
+{
+}
+
+void OccupancyPyramid::build(const OccupancyGrid &grid)
+{
+  numRows = grid.getNumRows();
+  numCols = grid.getNumCols();
+  levels.assign(1, Level());
+  levels[0].numRows = numRows;
+  levels[0].numCols = numCols;
+  // halve the size until a single block covers the grid
+  while (levels.back().numRows > 1 || levels.back().numCols > 1) {
+    const Level &finer = levels.back();
+    Level coarser;
+    coarser.numRows = (finer.numRows + 1) / 2;
+    coarser.numCols = (finer.numCols + 1) / 2;
+    coarser.obstacles.assign(coarser.numRows * coarser.numCols, 0);
+    coarser.scanned.assign(coarser.numRows * coarser.numCols, 0);
+    for (long row = 0; row < finer.numRows; row++) {
+      for (long col = 0; col < finer.numCols; col++) {
+        long block = (row / 2) * coarser.numCols + col / 2;
+        if (levels.size() == 1) {
+          uint8_t value = grid.get(row, col);
+          if (value == OccupancyGrid::OBSTACLE) coarser.obstacles[block]++;
+          else if (value == OccupancyGrid::SCANNED) coarser.scanned[block]++;
+        } else {
+          coarser.obstacles[block] += finer.obstacles[row * finer.numCols + col];
+          coarser.scanned[block] += finer.scanned[row * finer.numCols + col];
+        }
+      }
+    }
+    levels.push_back(coarser);
+  }
+}
+
+void OccupancyPyramid::update(int previous, int value, long row, long col)
+{
+  for (size_t level = 1; level < levels.size(); level++) {
+    Level &l = levels[level];
+    long block = (row >> level) * l.numCols + (col >> level);
+    if (previous == OccupancyGrid::OBSTACLE) l.obstacles[block]--;
+    else if (previous == OccupancyGrid::SCANNED) l.scanned[block]--;
+    if (value == OccupancyGrid::OBSTACLE) l.obstacles[block]++;
+    else if (value == OccupancyGrid::SCANNED) l.scanned[block]++;
+  }
+}
+
+int OccupancyPyramid::getNumLevels() const
+{
+  return levels.size();
+}
+
+long OccupancyPyramid::getNumRows(int level) const
+{
+  return levels[level].numRows;
+}
+
+long OccupancyPyramid::getNumCols(int level) const
+{
+  return levels[level].numCols;
+}
+
+long OccupancyPyramid::getUnscanned(int level, long row, long col) const
+{
+  // blocks on the last row or column may be cut by the border of the grid
+  long rows = std::min(numRows, (row + 1) << level) - (row << level);
+  long cols = std::min(numCols, (col + 1) << level) - (col << level);
+  return rows * cols - getObstacles(level, row, col) - getScanned(level, row, col);
+}
+
+long OccupancyPyramid::countUnscanned(const OccupancyGrid &grid, long minRow, long minCol,
+                                      long maxRow, long maxCol) const
+{
+  minRow = std::max(minRow, 0L);
+  minCol = std::max(minCol, 0L);
+  maxRow = std::min(maxRow, numRows - 1);
+  maxCol = std::min(maxCol, numCols - 1);
+  if (levels.empty() || minRow > maxRow || minCol > maxCol) return 0;
+  return countUnscanned(grid, levels.size() - 1, 0, 0, minRow, minCol, maxRow, maxCol);
+}
+
+long OccupancyPyramid::countUnscanned(const OccupancyGrid &grid, int level, long row, long col,
+                                      long minRow, long minCol, long maxRow, long maxCol) const
+{
+  long firstRow = row << level, lastRow = std::min(numRows, (row + 1) << level) - 1;
+  long firstCol = col << level, lastCol = std::min(numCols, (col + 1) << level) - 1;
+  if (lastRow < minRow || firstRow > maxRow || lastCol < minCol || firstCol > maxCol)
+    return 0;
+  if (level == 0)
+    return grid.get(row, col) == OccupancyGrid::FREE ? 1 : 0;
+  if (firstRow >= minRow && lastRow <= maxRow && firstCol >= minCol && lastCol <= maxCol)
+    return getUnscanned(level, row, col);
+  long unscanned = getUnscanned(level, row, col);
+  if (unscanned == 0) return 0;
+  long total = 0;
+  for (long r = 2 * row; r <= 2 * row + 1; r++)
+    for (long c = 2 * col; c <= 2 * col + 1; c++)
+      total += countUnscanned(grid, level - 1, r, c, minRow, minCol, maxRow, maxCol);
+  return total;
+}
@@ -0,0 +1,192 @@
+#include "pgmimage.h"
+#include <climits>
+#include <cstring>
+#include <iterator>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+// Skip blanks and '#' comments
+static void skipSpaces(const char *&p, const char *end)
+{
+  while (p < end) {
+    if (*p == '#') {
+      while (p < end && *p != '\n') p++;
+    } else if (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t' || *p == '\v' || *p == '\f') {
+      p++;
+    } else {
+      break;
+    }
+  }
+}
+
+// Read an unsigned decimal number after the blanks
+static bool readNumber(const char *&p, const char *end, long &value)
+{
+  skipSpaces(p, end);
+  if (p == end || *p < '0' || *p > '9') return false;
+  value = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    if (value > (LONG_MAX - 9) / 10) return false;
+    value = value * 10 + (*p - '0');
+    p++;
+  }
+  return true;
+}
+
+// Tell if an image of rows x cols pixels can be addressed
+static bool validSize(long rows, long cols)
+{
+  return cols == 0 || rows <= LONG_MAX / 2 / cols;
+}
+
+// Grey level on 8 bits of a value between 0 and maxValue
+static inline uint8_t toByte(long value, long maxValue)
+{
+  if (maxValue > 255) value = value * 255 / maxValue;
+  return value > 255 ? 255 : (uint8_t)value;
+}
+
+PGMImage::PGMImage()
+  : numRows(0), numCols(0)
+{
+}
+
+PGMImage::PGMImage(const std::string &fileURI)
+  : numRows(0), numCols(0)
+{
+  load(fileURI);
+}
+
+PGMImage::~PGMImage()
+{
+}
+
+bool PGMImage::load(const std::string &fileURI)
+{
+  int fd = open(fileURI.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  size_t size = st.st_size;
+  void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) return false;
+  madvise(data, size, MADV_SEQUENTIAL);
+  std::shared_ptr<const char> mapping((const char *)data, [size](const char *p) { munmap((void *)p, size); });
+  return parse(mapping.get(), mapping.get() + size, mapping);
+}
+
+bool PGMImage::load(std::istream &in)
+{
+  std::shared_ptr<std::vector<char> > buffer(new std::vector<char>(
+      (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>()));
+  if (buffer->empty()) return false;
+  std::shared_ptr<const char> owner(buffer, buffer->data());
+  return parse(buffer->data(), buffer->data() + buffer->size(), owner);
+}
+
+long PGMImage::getNumRows() const
+{
+  return numRows;
+}
+
+long PGMImage::getNumCols() const
+{
+  return numCols;
+}
+
+const uint8_t *PGMImage::getPixels() const
+{
+  return pixels.get();
+}
+
+bool PGMImage::parse(const char *begin, const char *end, std::shared_ptr<const char> owner)
+{
+  if (parseHeader(begin, end, owner))
+    return true;
+  pixels.reset();
+  numRows = numCols = 0;
+  return false;
+}
+
+bool PGMImage::parseHeader(const char *begin, const char *end, std::shared_ptr<const char> owner)
+{
+  const char *p = begin;
+  long maxValue;
+  if (end - p >= 4 && std::strncmp(p, "GRID", 4) == 0)
+    return parseGrid(p + 4, end);
+  if (end - p < 2 || p[0] != 'P' || (p[1] != '5' && p[1] != '2'))
+    return false;
+  bool binary = p[1] == '5';
+  p += 2;
+  // width, height and maximum grey level
+  if (!readNumber(p, end, numCols) || !readNumber(p, end, numRows) || !readNumber(p, end, maxValue)
+      || maxValue <= 0 || maxValue > 65535 || !validSize(numRows, numCols))
+    return false;
+  if (binary) {
+    // a single blank separates the header from the pixels
+    if (p == end) return false;
+    return parseBinary(p + 1, end, maxValue, owner);
+  }
+  return parseAscii(p, end, maxValue);
+}
+
+bool PGMImage::parseBinary(const char *begin, const char *end, long maxValue, std::shared_ptr<const char> owner)
+{
+  long size = numRows * numCols;
+  if (maxValue < 256) {
+    if (end - begin < size) return false;
+    // view the pixels in place, keeping the file content alive
+    pixels = std::shared_ptr<const uint8_t>(owner, (const uint8_t *)begin);
+    return true;
+  }
+  // two bytes per pixel, most significant first
+  if (end - begin < 2 * size) return false;
+  std::shared_ptr<std::vector<uint8_t> > decoded(new std::vector<uint8_t>(size));
+  const uint8_t *in = (const uint8_t *)begin;
+  for (long i = 0; i < size; i++, in += 2)
+    (*decoded)[i] = toByte((in[0] << 8) | in[1], maxValue);
+  pixels = std::shared_ptr<const uint8_t>(decoded, decoded->data());
+  return true;
+}
+
+bool PGMImage::parseAscii(const char *begin, const char *end, long maxValue)
+{
+  long size = numRows * numCols;
+  // every value takes at least a digit and a blank
+  if (size > (end - begin + 1) / 2) return false;
+  std::shared_ptr<std::vector<uint8_t> > decoded(new std::vector<uint8_t>(size));
+  const char *p = begin;
+  long value;
+  for (long i = 0; i < size; i++) {
+    if (!readNumber(p, end, value)) return false;
+    (*decoded)[i] = toByte(value, maxValue);
+  }
+  pixels = std::shared_ptr<const uint8_t>(decoded, decoded->data());
+  return true;
+}
+
+bool PGMImage::parseGrid(const char *begin, const char *end)
+{
+  // rows and columns, then one value per cell: 1 for an obstacle (black), 0 for free space (white)
+  const char *p = begin;
+  if (!readNumber(p, end, numRows) || !readNumber(p, end, numCols) || !validSize(numRows, numCols))
+    return false;
+  long size = numRows * numCols;
+  if (size > (end - p + 1) / 2) return false;
+  std::shared_ptr<std::vector<uint8_t> > decoded(new std::vector<uint8_t>(size));
+  long value;
+  for (long i = 0; i < size; i++) {
+    if (!readNumber(p, end, value)) return false;
+    (*decoded)[i] = value == 0 ? 255 : 0;
+  }
+  pixels = std::shared_ptr<const uint8_t>(decoded, decoded->data());
+  return true;
+}
@@ -0,0 +1,39 @@
+#include "posekey.h"
+#include <cmath>
+# define PI           3.14159265358979323846  /* pi */
+
+
+PoseKey::PoseKey(long x, long y, int orientation, int range, double FOV)
+{
+  // orientations are kept in [0, 360)
+  orientation = ((orientation % 360) + 360) % 360;
+  uint64_t fovDegrees = (uint64_t)std::lround(FOV * 180 / PI);
+  bits = (((uint64_t)x & X_MASK) << 46)
+       | (((uint64_t)y & Y_MASK) << 28)
+       | (((uint64_t)orientation & ORIENTATION_MASK) << 19)
+       | (((uint64_t)range & RANGE_MASK) << 9)
+       | (fovDegrees & FOV_MASK);
+}
+
+PoseKey::PoseKey(Pose &p)
+  : PoseKey(p.getX(), p.getY(), p.getOrientation(), p.getRange(), p.getFOV())
+{
+}
+
+double PoseKey::getFOV() const
+{
+  // same expression used to convert the FOV given in degrees
+  double FOV = getFOVDegrees();
+  return FOV * PI / 180;
+}
+
+Pose PoseKey::toPose() const
+{
+  return Pose(getX(), getY(), getOrientation(), getRange(), getFOV());
+}
+
+std::string PoseKey::toString() const
+{
+  return std::to_string(getX()) + "/" + std::to_string(getY()) + "/" + std::to_string(getOrientation())
+         + "/" + std::to_string(getRange()) + "/" + std::to_string(getFOVDegrees());
+}
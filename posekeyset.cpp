@@ -0,0 +1,81 @@
+#include "posekeyset.h"
+
+const uint64_t PoseKeySet::EMPTY;
+
+PoseKeySet::PoseKeySet()
+  : slots(16, EMPTY)
+{
+}
+
+PoseKeySet::~PoseKeySet()
+{
+}
+
+size_t PoseKeySet::findSlot(uint64_t bits) const
+{
+  size_t mask = slots.size() - 1;
+  size_t i = std::hash<PoseKey>()(PoseKey::fromBits(bits)) & mask;
+  while (slots[i] != EMPTY && slots[i] != bits)
+    i = (i + 1) & mask;
+  return i;
+}
+
+bool PoseKeySet::insert(PoseKey key)
+{
+  uint64_t bits = key.getBits();
+  size_t i = findSlot(bits);
+  if (slots[i] == bits)
+    return false;
+  slots[i] = bits;
+  keys.push_back(key);
+  if (2 * keys.size() > slots.size())
+    grow();
+  return true;
+}
+
+bool PoseKeySet::contains(PoseKey key) const
+{
+  uint64_t bits = key.getBits();
+  return slots[findSlot(bits)] == bits;
+}
+
+const vector<PoseKey>& PoseKeySet::getKeys() const
+{
+  return keys;
+}
+
+int PoseKeySet::size() const
+{
+  return keys.size();
+}
+
+void PoseKeySet::clear()
+{
+  slots.assign(16, EMPTY);
+  keys.clear();
+}
+
+void PoseKeySet::save(Checkpoint *checkpoint, const std::string &name) const
+{
+  vector<uint64_t> bits;
+  for (vector<PoseKey>::const_iterator it = keys.begin(); it != keys.end(); it++)
+    bits.push_back(it->getBits());
+  checkpoint->putVector(name + ".keys", bits);
+}
+
+bool PoseKeySet::restore(const Checkpoint &checkpoint, const std::string &name)
+{
+  vector<uint64_t> bits;
+  if (!checkpoint.getVector(name + ".keys", &bits)) return false;
+  clear();
+  for (vector<uint64_t>::iterator it = bits.begin(); it != bits.end(); it++)
+    insert(PoseKey::fromBits(*it));
+  return true;
+}
+
+void PoseKeySet::grow()
+{
+  slots.assign(2 * slots.size(), EMPTY);
+  for (vector<PoseKey>::iterator it = keys.begin(); it != keys.end(); it++)
+    slots[findSlot(it->getBits())] = it->getBits();
+}
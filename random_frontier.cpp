@@ -29,11 +29,10 @@ Pose getRandomFrontier(list<Pose> nearCandidates);
 int main ( int argc, char **argv )
 {
   auto startMCDM = chrono::high_resolution_clock::now();
-  ifstream infile;
-  infile.open ( argv[1] );  // the path to the map
   double resolution = atof ( argv[2] );  // the resolution of the map
   double imgresolution = atof ( argv[10] );  // the resolution to use for the planningGrid and RFIDGrid
-  dummy::Map map = dummy::Map ( infile,resolution, imgresolution );
+  PGMImage refImage ( argv[1] );  // the path to the map, read once and shared by all the grids
+  dummy::Map map = dummy::Map ( refImage, resolution, imgresolution );
   cout << "Map dimension: " << map.getNumGridCols() << " : "<<  map.getNumGridRows() << endl;
   int gridToPathGridScale = map.getGridToPathGridScale();
   // i switched x and y because the map's orientation inside and outside programs are different
@@ -99,27 +98,9 @@ int main ( int argc, char **argv )
   tags_coord.push_back(std::make_pair(absTag9_X, absTag9_Y));
   tags_coord.push_back(std::make_pair(absTag10_X, absTag10_Y));
 
-  RFIDGridmap myGrid1(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid2(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid3(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid4(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid5(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid6(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid7(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid8(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid9(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid10(argv[1], resolution, imgresolution, false);
-  std::vector<RFIDGridmap> RFID_maps_list;
-  RFID_maps_list.push_back(myGrid1);
-  RFID_maps_list.push_back(myGrid2);
-  RFID_maps_list.push_back(myGrid3);
-  RFID_maps_list.push_back(myGrid4);
-  RFID_maps_list.push_back(myGrid5);
-  RFID_maps_list.push_back(myGrid6);
-  RFID_maps_list.push_back(myGrid7);
-  RFID_maps_list.push_back(myGrid8);
-  RFID_maps_list.push_back(myGrid9);
-  RFID_maps_list.push_back(myGrid10);
+  // one grid per tag, all starting from the same map
+  RFIDGridmap rfidGrid(refImage, resolution, imgresolution, false);
+  std::vector<RFIDGridmap> RFID_maps_list(10, rfidGrid);
 
   double freq = std::stod(argv[12]); // Hertzs
   double txtPower = std::stod(argv[13]); // dBs
@@ -153,7 +134,7 @@ int main ( int argc, char **argv )
   Pose target = initialPose;
   Pose previous = initialPose;
   long numConfiguration = 1;
-  vector<pair<string,list<Pose>>> graph2;
+  NavigationGraph graph2;
   NewRay ray;
   ray.setGridToPathGridScale ( gridToPathGridScale );
   long sensedCells = 0;
@@ -162,15 +143,15 @@ int main ( int argc, char **argv )
   int count = 0;
   double travelledDistance = 0;
   int numOfTurning = 0;
-  unordered_map<string,int> visitedCell;
-  vector<string>history;
-  history.push_back ( function.getEncodedKey ( target,1 ) );
+  PoseKeySet visitedCell;
+  vector<pair<PoseKey,int>>history;
+  history.push_back ( make_pair ( PoseKey ( target ), 1 ) );
   EvaluationRecords record;
   //amount of time the robot should do nothing for scanning the environment ( final value expressed in second)
   unsigned int microseconds = 5 * 1000 * 1000 ;
   list<Pose> unexploredFrontiers;
-  list<Pose> tabuList;
-  tabuList.push_back(target);
+  PoseKeySet tabuList;
+  tabuList.insert(PoseKey(target));
   list<Pose> nearCandidates;
   bool btMode = false;
   double totalAngle = 0;
@@ -195,7 +176,7 @@ int main ( int argc, char **argv )
   // std::vector<double> freqs{ MIN_FREQ_NA,MIN_FREQ_NA+STEP_FREQ_NA,MIN_FREQ_NA+2.0*STEP_FREQ_NA }; 
 
   cout <<"Building radar model." << endl;
-  RadarModel rm(rs, sigma_power, sigma_phase, txtPower, freqs, tags_coord, argv[1] );
+  RadarModel rm(rs, sigma_power, sigma_phase, txtPower, freqs, tags_coord, refImage );
   //RadarModel rm(nx, ny, rs, sigma_power, sigma_phase, txtPower, freqs, tags_coord, argv[1] );
   cout << "Radar model built." << endl;
   rm.PrintRefMapWithTags("/tmp/scenario.png");  
@@ -203,9 +184,10 @@ int main ( int argc, char **argv )
   long x, y = 0;
   int orientation, range;
   double FOV, major_axis, minor_axis, scanAngle, rxPower, phase;
-  string encoding, actualPose;
+  PoseKey actualPose;
 
-  list<Pose> frontiers, tmp_history;
+  list<Pose> frontiers;
+  vector<PoseKey> tmp_history;
   bool break_loop;
   double accumulated_received_power = 0.0;
   double batteryTime = MAX_BATTERY;
@@ -223,12 +205,46 @@ int main ( int argc, char **argv )
   rfid_tools.sensitivity = SENSITIVITY;
   rfid_tools.RFID_maps_list = &RFID_maps_list;
 
+  // optional: write the exploration state to a checkpoint every few steps,
+  // and resume the exploration from a checkpoint written by a previous run
+  std::string checkpoint_file = argc > 25 ? argv[25] : "";
+  long checkpointSteps = argc > 26 ? atol(argv[26]) : 0;
+  long step = 0;
+  Checkpoint checkpoint;
+  if (argc > 27 and string(argv[27]) != "")
+  {
+    bool restored = checkpoint.load(argv[27])
+                    && utils.restoreCheckpoint(checkpoint, &map, &graph2, &history, &nearCandidates,
+                                               &target, &previous, &rfid_tools)
+                    && tabuList.restore(checkpoint, "tabuList")
+                    && visitedCell.restore(checkpoint, "visitedCell")
+                    && checkpoint.getValue("step", &step)
+                    && checkpoint.getValue("count", &count)
+                    && checkpoint.getValue("numConfiguration", &numConfiguration)
+                    && checkpoint.getValue("sensedCells", &sensedCells)
+                    && checkpoint.getValue("newSensedCells", &newSensedCells)
+                    && checkpoint.getValue("travelledDistance", &travelledDistance)
+                    && checkpoint.getValue("numOfTurning", &numOfTurning)
+                    && checkpoint.getValue("totalAngle", &totalAngle)
+                    && checkpoint.getValue("totalScanTime", &totalScanTime)
+                    && checkpoint.getValue("accumulated_received_power", &accumulated_received_power)
+                    && checkpoint.getValue("batteryTime", &batteryTime)
+                    && checkpoint.getValue("btMode", &btMode)
+                    && checkpoint.getValue("encodedKeyValue", &encodedKeyValue);
+    if (!restored)
+    {
+      cout << "Can't resume from the checkpoint " << argv[27] << endl;
+      return 1;
+    }
+    cout << "Resumed from the checkpoint " << argv[27] << " at step " << step << endl;
+  }
+
   do
   {
     // If we are doing "forward" navigation towards cells never visited before
     if ( btMode == false )
     {
-      travelledDistance = utils.calculateDistance(tabuList, &map, &astar );
+      travelledDistance = utils.calculateDistance(tabuList.getKeys(), &map, &astar );
       content = to_string(w_info_gain) 
                 + "," + to_string(w_travel_distance)
                 + "," + to_string(w_sensing_time) 
@@ -248,10 +264,9 @@ int main ( int argc, char **argv )
       orientation = target.getOrientation();
       range = target.getRange();
       FOV = target.getFOV();
-      actualPose = function.getEncodedKey ( target,0 );
+      actualPose = PoseKey ( target );
       map.setCurrentPose ( target );
-      encoding = to_string ( target.getX() ) + to_string ( target.getY() );
-      visitedCell.emplace ( encoding,0 );
+      visitedCell.insert ( PoseKey ( target.getX(), target.getY() ) );
       // Get the sensing time required for scanning
       target.setScanAngles ( ray.getSensingTime ( &map,x,y,orientation,FOV,range ) );
       // Perform a scanning operation
@@ -283,17 +298,13 @@ int main ( int argc, char **argv )
       if ( count == 0 )
       {
         // Calculate other three pose given the strating one
-        string invertedPose = function.getEncodedKey ( invertedInitial,0 );
-        string eastPose = function.getEncodedKey ( eastInitial,0 );
-        string westPose = function.getEncodedKey ( westInitial,0 );
-        list<Pose> empty ;
-        std::pair<string,list<Pose>> pair1 = make_pair ( invertedPose,empty );
-        std::pair<string,list<Pose>> pair2 = make_pair ( eastPose,empty );
-        std::pair<string,list<Pose>> pair3 = make_pair ( westPose,empty );
+        PoseKey invertedPose ( invertedInitial );
+        PoseKey eastPose ( eastInitial );
+        PoseKey westPose ( westInitial );
         // And add them (with empty candidates) to the graph structure
-        graph2.push_back ( pair1 );
-        graph2.push_back ( pair2 );
-        graph2.push_back ( pair3 );
+        graph2.push ( invertedPose );
+        graph2.push ( eastPose );
+        graph2.push ( westPose );
       }
 
       // If it's not the first step but we are in one of the initial position (we come back here with backtracking)
@@ -301,8 +312,8 @@ int main ( int argc, char **argv )
       {
         // If there are no more destination in the graph, terminates the navigation
         if ( graph2.size() == 0 ) break;
-        graph2.pop_back();
-        actualPose = function.getEncodedKey ( target,0 );
+        graph2.pop();
+        actualPose = PoseKey ( target );
         // Add to the graph the initial positions and the candidates from there (calculated inside the function)
         utils.pushInitialPositions ( &map, x, y,orientation, range,FOV, threshold, actualPose, &graph2, &function, &rfid_tools, &batteryTime );
       }
@@ -322,12 +333,12 @@ int main ( int argc, char **argv )
         if ( graph2.size() > 1 )
         {
           // Get the last position in the graph and then remove it
-          string targetString = graph2.at ( graph2.size()-1 ).first;
-          graph2.pop_back();
+          PoseKey targetKey = graph2.getTopPose();
+          graph2.pop();
 //          EvaluationRecords record;
-          target = record.getPoseFromEncoding ( targetString );
+          target = targetKey.toPose();
           // Add it to the history as cell visited more than once
-          history.push_back ( function.getEncodedKey ( target,2 ) );
+          history.push_back ( make_pair ( PoseKey ( target ), 2 ) );
           // cout << "[BT]No significative position reachable. Come back to previous position" << endl;
           count = count + 1;
         }
@@ -339,13 +350,13 @@ int main ( int argc, char **argv )
           // cout << "Travelled distance calculated during the algorithm: " << travelledDistance << endl;
           // cout << "------------------ HISTORY -----------------" << endl;
           // // Retrieve the cell visited only the first time
-          // list<Pose> tmp_history = utils.cleanHistory(&history, &record);
+          // list<Pose> tmp_history = utils.cleanHistory(&history);
           // utils.calculateDistance(tmp_history, &map, &astar );
 
           // cout << "------------------ TABULIST -----------------" << endl;
           // Calculate the path connecting the cells in the tabulist, namely the cells that are visited one time and couldn't be visite again
-          // utils.calculateDistance(tabuList, &map, &astar );
-          travelledDistance = utils.calculateDistance(tabuList, &map, &astar );
+          // utils.calculateDistance(tabuList.getKeys(), &map, &astar );
+          travelledDistance = utils.calculateDistance(tabuList.getKeys(), &map, &astar );
 
           // Normalise the travel distance in meter
           // NOTE: assuming that the robot is moving at 0.5m/s and the resolution of the map is 0.5m per cell)
@@ -409,7 +420,7 @@ int main ( int argc, char **argv )
           // std::pair<Pose,double> result = function.selectNewPose ( record );
           // target = result.first;
           // If the selected destination does not appear among the cells already visited
-          if ( ! utils.contains ( tabuList,target ))
+          if ( ! utils.contains ( tabuList,PoseKey ( target ) ))
           {
             act = true;
             // Add it to the list of visited cells as first-view
@@ -423,7 +434,7 @@ int main ( int argc, char **argv )
             // If the graph is empty, stop the navigation
             if ( graph2.size() == 0 ) break;
             // If there still are more candidates to explore from the last pose in the graph
-            if ( graph2.at ( graph2.size()-1 ).second.size() != 0 )
+            if ( graph2.getTopNumCandidates() != 0 )
             {
               // cout << "[BT1 - Tabulist]There are visible cells but the selected one is already explored!Come back to second best position from the previous position"<< endl;
               // Remove the current position from possible candidates
@@ -449,21 +460,21 @@ int main ( int argc, char **argv )
                 // if the graph is now empty, stop the navigation
                 if ( graph2.size() == 0 ) break;
                 // Otherwise, select as new position the last cell in the graph and then remove it from there
-                string targetString = graph2.at ( graph2.size()-1 ).first;
-                graph2.pop_back();
-                target = record->getPoseFromEncoding ( targetString );
+                PoseKey targetKey = graph2.getTopPose();
+                graph2.pop();
+                target = targetKey.toPose();
               }
             }
             // ... if the graph still does not present anymore candidate positions for its last pose
             else
             {
               // Remove the last element (cell and associated candidate from there) from the graph
-              graph2.pop_back();
+              graph2.pop();
               // Select as new target, the new last element of the graph
-              string targetString = graph2.at ( graph2.size()-1 ).first;
-              target = record->getPoseFromEncoding ( targetString );
+              PoseKey targetKey = graph2.getTopPose();
+              target = targetKey.toPose();
               // Save it history as cell visited more than once
-              history.push_back ( function.getEncodedKey ( target,2 ) );
+              history.push_back ( make_pair ( PoseKey ( target ), 2 ) );
               // cout << "[BT2 - Tabulist]There are visible cells but the selected one is already explored!Come back to two position ago"<< endl;
               count = count + 1;
             }
@@ -476,10 +487,10 @@ int main ( int argc, char **argv )
           // If the graph is empty, stop the navigation
           if ( graph2.size() == 0 ) break;
           // Select as new target the last one in the graph structure
-          string targetString = graph2.at ( graph2.size()-1 ).first;
+          PoseKey targetKey = graph2.getTopPose();
           // Remove it from the graph
-          graph2.pop_back();
-          target = record->getPoseFromEncoding ( targetString );
+          graph2.pop();
+          target = targetKey.toPose();
           // Check if the selected cell in the graph is the previous robot position
           if ( !target.isEqual ( previous ) )
           {
@@ -487,7 +498,7 @@ int main ( int argc, char **argv )
             previous = target;  //TODO: WHY?
             // cout << "[BT3]There are no visible cells so come back to previous position in the graph structure" << endl;
             // Save the new target in the history as cell visited more than once
-            history.push_back ( function.getEncodedKey ( target,2 ) );
+            history.push_back ( make_pair ( PoseKey ( target ), 2 ) );
             count = count + 1;
           }
           // If the selected cell is the old robot position
@@ -500,16 +511,16 @@ int main ( int argc, char **argv )
               break;
             }
             // Select the last position in the graph
-            string targetString = graph2.at ( graph2.size()-1 ).first;
+            PoseKey targetKey = graph2.getTopPose();
             // and remove it from the graph
-            graph2.pop_back();
-            target = record->getPoseFromEncoding ( targetString );
+            graph2.pop();
+            target = targetKey.toPose();
             // Set the previous pose as the current one
             previous = target;
             // cout << "[BT5]There are no visible cells so come back to previous position" << endl;
             // cout << "[BT5]Cell already explored!Come back to previous position"<< endl;
             // Add it in history as cell visited more than once
-            history.push_back ( function.getEncodedKey ( target,2 ) );
+            history.push_back ( make_pair ( PoseKey ( target ), 2 ) );
             count = count + 1;
           }
 
@@ -534,10 +545,10 @@ int main ( int argc, char **argv )
       int orientation = target.getOrientation();
       int range = target.getRange();
       double FOV = target.getFOV();
-      string actualPose = function.getEncodedKey ( target,0 );
+      PoseKey actualPose ( target );
       map.setCurrentPose ( target );
       //NOTE; calculate path and turnings between actual position and goal
-      // cout<< function.getEncodedKey ( target,1 ) << endl;
+      // cout<< PoseKey ( target ).toString() << endl;
       // Calculate the distance between the previous robot pose and the next one (target)
       string path = astar.pathFind ( target.getX(), target.getY(), previous.getX(), previous.getY(), &map );
       // Update the overall covered distance
@@ -549,8 +560,7 @@ int main ( int argc, char **argv )
       batteryTime = batteryTime - (translTime + rotTime);
       // Update the overall number of turnings
       numOfTurning = numOfTurning + astar.getNumberOfTurning ( path );
-      string encoding = to_string ( target.getX() ) + to_string ( target.getY() );
-      visitedCell.emplace ( encoding,0 );
+      visitedCell.insert ( PoseKey ( target.getX(), target.getY() ) );
       // Set the previous cell to be the same of the current one
       previous = target;
 
@@ -577,7 +587,7 @@ int main ( int argc, char **argv )
         // target = result.first;
         target = getRandomFrontier(nearCandidates);
         // If this cells has not been visited before
-        if ( ! utils.contains ( tabuList,target ) )
+        if ( ! utils.contains ( tabuList,PoseKey ( target ) ) )
         {
           // Add it to the list of visited cells as first-view
           encodedKeyValue = 1;
@@ -615,10 +625,10 @@ int main ( int argc, char **argv )
           {
             // cout << "[BT-MODE2] Go back to previous positions in the graph" << endl;
             // Select as target the last element in the graph
-            string targetString = graph2.at ( graph2.size()-1 ).first;
+            PoseKey targetKey = graph2.getTopPose();
             // And remove from the graph
-            graph2.pop_back();
-            target = record->getPoseFromEncoding ( targetString );
+            graph2.pop();
+            target = targetKey.toPose();
             // Add it to the history of cell as already more than once
             encodedKeyValue = 2;
             utils.updatePathMetrics(&count, &target, &previous, actualPose, &nearCandidates, &graph2, &map, &function,
@@ -634,10 +644,10 @@ int main ( int argc, char **argv )
       else
       {
         // Select as new pose, the last cell in the graph
-        string targetString = graph2.at ( graph2.size()-1 ).first;
+        PoseKey targetKey = graph2.getTopPose();
         // and the remove it form the graph
-        graph2.pop_back();
-        target = record->getPoseFromEncoding ( targetString );
+        graph2.pop();
+        target = targetKey.toPose();
 
         // Add it in history as cell visited more than once
         encodedKeyValue = 2;
@@ -649,7 +659,31 @@ int main ( int argc, char **argv )
       }
       delete record;
     }
-    double batteryPercentage = utils.calculateRemainingBatteryPercentage(tabuList, &map, &astar);
+    double batteryPercentage = utils.calculateRemainingBatteryPercentage(tabuList.getKeys(), &map, &astar);
+    step++;
+    if (checkpointSteps > 0 and step % checkpointSteps == 0)
+    {
+      checkpoint.clear();
+      utils.saveCheckpoint(&checkpoint, &map, &graph2, &history, &nearCandidates,
+                           &target, &previous, &rfid_tools, true);
+      tabuList.save(&checkpoint, "tabuList");
+      visitedCell.save(&checkpoint, "visitedCell");
+      checkpoint.putValue("step", step);
+      checkpoint.putValue("count", count);
+      checkpoint.putValue("numConfiguration", numConfiguration);
+      checkpoint.putValue("sensedCells", sensedCells);
+      checkpoint.putValue("newSensedCells", newSensedCells);
+      checkpoint.putValue("travelledDistance", travelledDistance);
+      checkpoint.putValue("numOfTurning", numOfTurning);
+      checkpoint.putValue("totalAngle", totalAngle);
+      checkpoint.putValue("totalScanTime", totalScanTime);
+      checkpoint.putValue("accumulated_received_power", accumulated_received_power);
+      checkpoint.putValue("batteryTime", batteryTime);
+      checkpoint.putValue("btMode", btMode);
+      checkpoint.putValue("encodedKeyValue", encodedKeyValue);
+      if (!checkpoint.save(checkpoint_file))
+        cout << "Can't write the checkpoint " << checkpoint_file << endl;
+    }
   }
   // Perform exploration until a certain coverage is achieved
   while ( sensedCells < precision * totalFreeCells and batteryPercentage > 0.0);
@@ -663,12 +697,12 @@ int main ( int argc, char **argv )
   // cout << "Num configuration: " << numConfiguration << endl;
   // cout << "Travelled distance calculated during the algorithm: " << travelledDistance << endl;
  
-  // tmp_history = utils.cleanHistory(&history, &record);
+  // tmp_history = utils.cleanHistory(&history);
   // utils.calculateDistance(tmp_history, &map, &astar );
 
   // cout << "------------------ TABULIST -----------------" << endl;
-  travelledDistance =  utils.calculateDistance(tabuList, &map, &astar );
-  batteryPercentage = utils.calculateRemainingBatteryPercentage(tabuList, &map, &astar);
+  travelledDistance =  utils.calculateDistance(tabuList.getKeys(), &map, &astar );
+  batteryPercentage = utils.calculateRemainingBatteryPercentage(tabuList.getKeys(), &map, &astar);
 
   double belief_accuracy = utils.findTags(&RFID_maps_list, &tags_coord, &map,
                   detection_log, accuracy_log, 
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <iterator>
 #include <random>
+#include <sstream>
 #include "map.h"
 #include "newray.h"
 #include "mcdmfunction.h"
@@ -27,11 +28,10 @@ using namespace YAML;
 int main ( int argc, char **argv )
 {
   auto startMCDM = chrono::high_resolution_clock::now();
-  ifstream infile;
-  infile.open ( argv[1] );  // the path to the map
   double resolution = atof ( argv[2] );  // the resolution of the map
   double imgresolution = atof ( argv[10] );  // the resolution to use for the planningGrid and RFIDGrid
-  dummy::Map map = dummy::Map ( infile,resolution, imgresolution );
+  PGMImage refImage ( argv[1] );  // the path to the map, read once and shared by all the grids
+  dummy::Map map = dummy::Map ( refImage, resolution, imgresolution );
   // cout << "Map dimension: " << map.getNumGridCols() << " : "<<  map.getNumGridRows() << endl;
   int gridToPathGridScale = map.getGridToPathGridScale();
   // i switched x and y because the map's orientation inside and outside programs are different
@@ -89,27 +89,9 @@ int main ( int argc, char **argv )
   tags_coord.push_back(std::make_pair(absTag9_X, absTag9_Y));
   tags_coord.push_back(std::make_pair(absTag10_X, absTag10_Y));
 
-  RFIDGridmap myGrid1(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid2(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid3(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid4(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid5(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid6(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid7(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid8(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid9(argv[1], resolution, imgresolution, false);
-  RFIDGridmap myGrid10(argv[1], resolution, imgresolution, false);
-  std::vector<RFIDGridmap> RFID_maps_list;
-  RFID_maps_list.push_back(myGrid1);
-  RFID_maps_list.push_back(myGrid2);
-  RFID_maps_list.push_back(myGrid3);
-  RFID_maps_list.push_back(myGrid4);
-  RFID_maps_list.push_back(myGrid5);
-  RFID_maps_list.push_back(myGrid6);
-  RFID_maps_list.push_back(myGrid7);
-  RFID_maps_list.push_back(myGrid8);
-  RFID_maps_list.push_back(myGrid9);
-  RFID_maps_list.push_back(myGrid10);
+  // one grid per tag, all starting from the same map
+  RFIDGridmap rfidGrid(refImage, resolution, imgresolution, false);
+  std::vector<RFIDGridmap> RFID_maps_list(10, rfidGrid);
 
   double freq = std::stod(argv[12]); // Hertzs
   double txtPower = std::stod(argv[13]); // dBs
@@ -145,7 +127,7 @@ int main ( int argc, char **argv )
   Pose target = initialPose;
   Pose previous = initialPose;
   long numConfiguration = 1;
-  vector<pair<string,list<Pose>>> graph2;
+  NavigationGraph graph2;
   NewRay ray;
   ray.setGridToPathGridScale ( gridToPathGridScale );
   // MCDMFunction function(w_info_gain, w_travel_distance, w_sensing_time);
@@ -158,15 +140,15 @@ int main ( int argc, char **argv )
   int count = 0;
   double travelledDistance = 0;
   int numOfTurning = 0;
-  unordered_map<string,int> visitedCell;
-  vector<string>history;
-  history.push_back ( function.getEncodedKey ( target,1 ) );
+  PoseKeySet visitedCell;
+  vector<pair<PoseKey,int>>history;
+  history.push_back ( make_pair ( PoseKey ( target ), 1 ) );
   EvaluationRecords record;
   //amount of time the robot should do nothing for scanning the environment ( final value expressed in second)
   unsigned int microseconds = 5 * 1000 * 1000 ;
   list<Pose> unexploredFrontiers;
-  list<Pose> tabuList;
-  tabuList.push_back(target);
+  vector<PoseKey> tabuList;
+  tabuList.push_back(PoseKey(target));
   list<Pose> nearCandidates;
   bool btMode = false;
   double totalAngle = 0;
@@ -176,8 +158,11 @@ int main ( int argc, char **argv )
   int encodedKeyValue = 0;
   string content;
   std::pair<long, long> nextRandomPosition;
-  std::random_device rd; // obtain a random number from hardware
-  std::mt19937 eng(rd()); // seed the generator
+  // optional: seed of the random choices, so that runs can be repeated
+  unsigned long seed = argc > 28 ? strtoul(argv[28], NULL, 10) : std::random_device()();
+  cout << "Random seed: " << seed << endl;
+  std::mt19937 eng(seed); // seed the generator
+  map.setRandomSeed(seed + 1);
   std::uniform_int_distribution<> distr(0, 359); // define the range
    // Radar model: 
   double nx = 240*resolution; // radar model active area x-range m.
@@ -190,7 +175,7 @@ int main ( int argc, char **argv )
   // std::vector<double> freqs{ MIN_FREQ_NA,MIN_FREQ_NA+STEP_FREQ_NA,MIN_FREQ_NA+2.0*STEP_FREQ_NA }; 
 
   cout <<"Building radar model." << endl;
-  RadarModel rm(rs, sigma_power, sigma_phase, txtPower, freqs, tags_coord, argv[1] );
+  RadarModel rm(rs, sigma_power, sigma_phase, txtPower, freqs, tags_coord, refImage );
   //RadarModel rm(nx, ny, rs, sigma_power, sigma_phase, txtPower, freqs, tags_coord, argv[1] );
   cout << "Radar model built." << endl;
   rm.PrintRefMapWithTags("/tmp/scenario.png"); 
@@ -198,7 +183,7 @@ int main ( int argc, char **argv )
   long x, y = 0;
   int orientation, range;
   double FOV, major_axis, minor_axis, scanAngle, rxPower, phase;
-  string encoding, actualPose;
+  PoseKey actualPose;
 
   double accumulated_received_power = 0.0;
   double batteryTime = MAX_BATTERY;
@@ -216,6 +201,47 @@ int main ( int argc, char **argv )
   rfid_tools.sensitivity = SENSITIVITY;
   rfid_tools.RFID_maps_list = &RFID_maps_list;
 
+  // optional: write the exploration state to a checkpoint every few steps,
+  // and resume the exploration from a checkpoint written by a previous run
+  std::string checkpoint_file = argc > 25 ? argv[25] : "";
+  long checkpointSteps = argc > 26 ? atol(argv[26]) : 0;
+  long step = 0;
+  Checkpoint checkpoint;
+  if (argc > 27 and string(argv[27]) != "")
+  {
+    vector<uint64_t> tabuKeys;
+    const void *engState;
+    size_t engStateSize;
+    bool restored = checkpoint.load(argv[27])
+                    && utils.restoreCheckpoint(checkpoint, &map, &graph2, &history, &nearCandidates,
+                                               &target, &previous, &rfid_tools)
+                    && checkpoint.getVector("tabuList", &tabuKeys)
+                    && visitedCell.restore(checkpoint, "visitedCell")
+                    && checkpoint.get("eng", &engState, &engStateSize)
+                    && checkpoint.getValue("step", &step)
+                    && checkpoint.getValue("numConfiguration", &numConfiguration)
+                    && checkpoint.getValue("sensedCells", &sensedCells)
+                    && checkpoint.getValue("newSensedCells", &newSensedCells)
+                    && checkpoint.getValue("travelledDistance", &travelledDistance)
+                    && checkpoint.getValue("numOfTurning", &numOfTurning)
+                    && checkpoint.getValue("totalScanTime", &totalScanTime)
+                    && checkpoint.getValue("accumulated_received_power", &accumulated_received_power)
+                    && checkpoint.getValue("batteryTime", &batteryTime)
+                    && checkpoint.getValue("batteryPercentage", &batteryPercentage);
+    if (!restored)
+    {
+      cout << "Can't resume from the checkpoint " << argv[27] << endl;
+      return 1;
+    }
+    tabuList.clear();
+    for (int i = 0; i < tabuKeys.size(); i++)
+      tabuList.push_back(PoseKey::fromBits(tabuKeys[i]));
+    // continue the same random sequence
+    std::istringstream engStream(std::string((const char *)engState, engStateSize));
+    engStream >> eng;
+    cout << "Resumed from the checkpoint " << argv[27] << " at step " << step << endl;
+  }
+
   do
   {
       content = to_string(w_info_gain) 
@@ -237,7 +263,7 @@ int main ( int argc, char **argv )
       orientation = target.getOrientation();
       range = target.getRange();
       FOV = target.getFOV();
-      actualPose = function.getEncodedKey ( target,0 );
+      actualPose = PoseKey ( target );
       map.setCurrentPose ( target );
       // Update the overall covered distance
       string path = astar.pathFind ( target.getX(), target.getY(), previous.getX(), previous.getY(), &map );
@@ -250,7 +276,7 @@ int main ( int argc, char **argv )
       batteryTime = batteryTime - (translTime + rotTime);
       // Update the overall number of turnings
       numOfTurning = numOfTurning + astar.getNumberOfTurning ( path );
-      visitedCell.emplace ( encoding,0 );
+      visitedCell.insert ( PoseKey ( x, y ) );
       // Get the sensing time required for scanning
       target.setScanAngles ( ray.getSensingTime ( &map,x,y,orientation,FOV,range ) );
       // Perform a scanning operation
@@ -276,15 +302,42 @@ int main ( int argc, char **argv )
       }
       // Find new random destination
       nextRandomPosition = map.getRandomFreeCell();
-      orientation = distr(eng);  // get a random orientation between 0 and 359
-      orientation = orientation * M_PI / 180.0;
+      orientation = distr(eng);  // get a random orientation between 0 and 359 (deg)
       target.updateFromData(nextRandomPosition, orientation, range, FOV);
       sensedCells = newSensedCells;
       numConfiguration++;
       // Add target to history and tabulist
-      history.push_back(function.getEncodedKey(target, 1));
-      tabuList.push_back(target);
+      history.push_back(make_pair(PoseKey(target), 1));
+      tabuList.push_back(PoseKey(target));
       batteryPercentage = utils.calculateRemainingBatteryPercentage(tabuList, &map, &astar);
+      step++;
+      if (checkpointSteps > 0 and step % checkpointSteps == 0)
+      {
+        vector<uint64_t> tabuKeys;
+        for (int i = 0; i < tabuList.size(); i++)
+          tabuKeys.push_back(tabuList[i].getBits());
+        std::ostringstream engStream;
+        engStream << eng;
+        std::string engState = engStream.str();
+        checkpoint.clear();
+        utils.saveCheckpoint(&checkpoint, &map, &graph2, &history, &nearCandidates,
+                             &target, &previous, &rfid_tools, true);
+        checkpoint.putVector("tabuList", tabuKeys);
+        visitedCell.save(&checkpoint, "visitedCell");
+        checkpoint.put("eng", engState.data(), engState.size());
+        checkpoint.putValue("step", step);
+        checkpoint.putValue("numConfiguration", numConfiguration);
+        checkpoint.putValue("sensedCells", sensedCells);
+        checkpoint.putValue("newSensedCells", newSensedCells);
+        checkpoint.putValue("travelledDistance", travelledDistance);
+        checkpoint.putValue("numOfTurning", numOfTurning);
+        checkpoint.putValue("totalScanTime", totalScanTime);
+        checkpoint.putValue("accumulated_received_power", accumulated_received_power);
+        checkpoint.putValue("batteryTime", batteryTime);
+        checkpoint.putValue("batteryPercentage", batteryPercentage);
+        if (!checkpoint.save(checkpoint_file))
+          cout << "Can't write the checkpoint " << checkpoint_file << endl;
+      }
 
   }
   // Perform exploration until a certain coverage is achieved
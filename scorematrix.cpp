@@ -0,0 +1,76 @@
+#include "scorematrix.h"
+#include <algorithm>
+
+
+using namespace std;
+ScoreMatrix::ScoreMatrix()
+{
+}
+
+ScoreMatrix::~ScoreMatrix()
+{
+}
+
+void ScoreMatrix::reset(int numCandidates, int numCriteria)
+{
+    this->numCandidates = numCandidates;
+    this->numCriteria = numCriteria;
+    raw.assign(numCandidates * numCriteria, 0.0);
+    normalized.assign(numCandidates * numCriteria, 0.0);
+}
+
+void ScoreMatrix::setRaw(int criterion, int candidate, double value)
+{
+    raw[criterion * numCandidates + candidate] = value;
+}
+
+double ScoreMatrix::getRaw(int criterion, int candidate) const
+{
+    return raw[criterion * numCandidates + candidate];
+}
+
+double ScoreMatrix::getNormalized(int criterion, int candidate) const
+{
+    return normalized[criterion * numCandidates + candidate];
+}
+
+void ScoreMatrix::keepCandidates(const vector<int> &indices)
+{
+    // compacting in place is safe: with increasing indices every value moves
+    // to a lower (or the same) position, after all the values it overwrites
+    // have been moved
+    int kept = indices.size();
+    for (int c = 0; c < numCriteria; c++) {
+        for (int k = 0; k < kept; k++) {
+            raw[c * kept + k] = raw[c * numCandidates + indices[k]];
+        }
+    }
+    numCandidates = kept;
+    raw.resize(numCandidates * numCriteria);
+    normalized.assign(numCandidates * numCriteria, 0.0);
+}
+
+void ScoreMatrix::copyRawToNormalized()
+{
+    std::copy(raw.begin(), raw.end(), normalized.begin());
+}
+
+double* ScoreMatrix::getRawColumn(int criterion)
+{
+    return raw.data() + criterion * numCandidates;
+}
+
+double* ScoreMatrix::getNormalizedColumn(int criterion)
+{
+    return normalized.data() + criterion * numCandidates;
+}
+
+int ScoreMatrix::getNumCandidates() const
+{
+    return numCandidates;
+}
+
+int ScoreMatrix::getNumCriteria() const
+{
+    return numCriteria;
+}
@@ -0,0 +1,111 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "checkpoint.h"
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static vector<char> readFile(const string &fileURI)
+{
+    ifstream in(fileURI.c_str(), ios::binary);
+    return vector<char>((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+}
+
+static void writeFile(const string &fileURI, const vector<char> &bytes, size_t size)
+{
+    ofstream out(fileURI.c_str(), ios::binary | ios::trunc);
+    out.write(bytes.data(), size);
+}
+
+BOOST_AUTO_TEST_CASE( test_checkpoint )
+{
+    string fileURI = "/tmp/test_checkpoint.ckpt";
+    string plainURI = "/tmp/test_checkpoint_plain.ckpt";
+
+    // a belief-like layer: large uniform areas with a few different values
+    vector<float> layer(10000, 0.5f);
+    for (int i = 3000; i < 3100; i++)
+        layer[i] = i * 0.25f;
+    layer[9999] = -1.0f;
+    // an RLE payload whose size isn't a multiple of the 32-bit words
+    vector<char> odd(1027, 'a');
+    odd[1026] = 'z';
+    vector<int> empty;
+
+    Checkpoint checkpoint;
+    checkpoint.putValue("step", (long)42);
+    checkpoint.putValue("pi", 3.25);
+    checkpoint.putVector("layer", layer, true);
+    checkpoint.putVector("odd", odd, true);
+    checkpoint.putVector("empty", empty);
+    checkpoint.putVector("replaced", vector<int>(3, 1));
+    checkpoint.putVector("replaced", vector<int>(2, 7));
+
+    cout << "1) check that the sections survive a save and a load" << endl;
+    BOOST_REQUIRE(checkpoint.save(fileURI));
+    Checkpoint loaded;
+    BOOST_REQUIRE(loaded.load(fileURI));
+    long step = 0;
+    double pi = 0;
+    vector<float> loadedLayer;
+    vector<char> loadedOdd;
+    vector<int> loadedEmpty(1, 0), replaced;
+    BOOST_CHECK(loaded.getValue("step", &step));
+    BOOST_CHECK_EQUAL(step, 42);
+    BOOST_CHECK(loaded.getValue("pi", &pi));
+    BOOST_CHECK_EQUAL(pi, 3.25);
+    BOOST_CHECK(loaded.getVector("layer", &loadedLayer));
+    BOOST_CHECK(loadedLayer == layer);
+    BOOST_CHECK(loaded.getVector("odd", &loadedOdd));
+    BOOST_CHECK(loadedOdd == odd);
+    BOOST_CHECK(loaded.getVector("empty", &loadedEmpty));
+    BOOST_CHECK(loadedEmpty.empty());
+    BOOST_CHECK(loaded.getVector("replaced", &replaced));
+    BOOST_CHECK(replaced == vector<int>(2, 7));
+
+    cout << "2) check the missing and mismatching sections" << endl;
+    int small;
+    BOOST_CHECK_EQUAL(loaded.getValue("missing", &small), false);
+    BOOST_CHECK_EQUAL(loaded.getValue("step", &small), false);
+    vector<double> doubles;
+    BOOST_CHECK_EQUAL(loaded.getVector("odd", &doubles), false);
+
+    cout << "3) check that the run-length encoding shrinks uniform layers" << endl;
+    Checkpoint plain;
+    plain.putVector("layer", layer);
+    BOOST_REQUIRE(plain.save(plainURI));
+    BOOST_CHECK(readFile(fileURI).size() < readFile(plainURI).size() / 4);
+
+    cout << "4) check that truncated or foreign files are rejected" << endl;
+    vector<char> bytes = readFile(fileURI);
+    string brokenURI = "/tmp/test_checkpoint_broken.ckpt";
+    for (size_t size = 0; size < bytes.size(); size += size + 16 < bytes.size() ? 1 + size / 8 : 1) {
+        writeFile(brokenURI, bytes, size);
+        Checkpoint broken;
+        BOOST_CHECK_MESSAGE(!broken.load(brokenURI), "truncated at " << size << " bytes");
+    }
+    vector<char> foreign = bytes;
+    foreign[0] = 'X';
+    writeFile(brokenURI, foreign, foreign.size());
+    Checkpoint broken;
+    BOOST_CHECK_EQUAL(broken.load(brokenURI), false);
+    vector<char> newer = bytes;
+    uint32_t version = Checkpoint::VERSION + 1;
+    memcpy(&newer[8], &version, sizeof(version));
+    writeFile(brokenURI, newer, newer.size());
+    BOOST_CHECK_EQUAL(broken.load(brokenURI), false);
+    BOOST_CHECK_EQUAL(broken.load("/tmp/test_checkpoint_missing.ckpt"), false);
+
+    remove(fileURI.c_str());
+    remove(plainURI.c_str());
+    remove(brokenURI.c_str());
+}
@@ -0,0 +1,197 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "pose.h"
+#include "mcdmfunction.h"
+#include "evaluationrecords.h"
+#include "Criteria/criterion.h"
+#include "Criteria/weightmatrix.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+// encoding of a combination: one letter per criterion, bit i is 'A'+i
+static string maskToEncoding(unsigned int mask)
+{
+    string encoding;
+    for (int i = 0; i < 32; i++)
+        if (mask & (1u << i))
+            encoding += (char)('A' + i);
+    return encoding;
+}
+
+// capacity of a combination with the rules of the string-keyed table: the
+// set of all the active criteria weighs 1, a missing combination weighs the
+// sum of its single criteria, and the result is capped to 1
+static double referenceCapacity(WeightMatrix &matrix, unsigned int mask)
+{
+    string encoding = maskToEncoding(mask);
+    double w = 0;
+    try {
+        w = matrix.getWeight(encoding);
+    } catch (const out_of_range &) {
+    }
+    if (w == 0) {
+        for (size_t i = 0; i < encoding.length(); i++) {
+            try {
+                w += matrix.getWeight(encoding.substr(i, 1));
+            } catch (const out_of_range &) {
+            }
+        }
+    }
+    return w > 1 ? 1 : w;
+}
+
+// criterion with a fixed pseudo-random value for every pose
+class FakeCriterion : public Criterion
+{
+public:
+    FakeCriterion(string name, double weight, int seed) : Criterion(name, weight, true), seed(seed) {}
+
+    double computeEvaluation(Pose &p, dummy::Map *map, RFID_tools *rfid_tools, double *batteryTime)
+    {
+        double v = sin(seed * 1.618 + p.getX() * 12.9898 + p.getY() * 78.233 + p.getOrientation() * 0.377) * 43758.5453;
+        return v - floor(v);
+    }
+
+private:
+    int seed;
+};
+
+// MCDM function whose criteria are replaced by fake ones, exposing the
+// normalized values to recompute the Choquet integral with a plain sort
+class ChoquetFunction : public MCDMFunction
+{
+public:
+    ChoquetFunction(float w1, float w2, float w3, float w4, float w5) : MCDMFunction(w1, w2, w3, w4, w5, true)
+    {
+        replaceCriteria();
+    }
+
+    ChoquetFunction(float w1, float w2, float w3) : MCDMFunction(w1, w2, w3, true)
+    {
+        replaceCriteria();
+    }
+
+    WeightMatrix *getMatrix() { return matrix; }
+
+    // tell if a candidate of the last evaluation is kept for its information gain
+    bool hasInformationGain(int candidate)
+    {
+        vector<string> names = matrix->getActiveCriteria();
+        for (size_t j = 0; j < names.size(); j++)
+            if (names[j] == "informationGain")
+                return scores.getNormalized(j, candidate) != 0;
+        return true;
+    }
+
+    // Choquet integral of a candidate of the last evaluation, sorting the
+    // criteria by value and reading the capacity of every suffix from its encoding
+    double sortedChoquet(int candidate)
+    {
+        vector<string> names = matrix->getActiveCriteria();
+        vector<pair<double, string> > values;
+        for (size_t j = 0; j < names.size(); j++)
+            values.push_back(make_pair(scores.getNormalized(j, candidate), names[j]));
+        sort(values.begin(), values.end());
+        double finalValue = 0.0;
+        double lastValue = 0.0;
+        for (size_t k = 0; k < values.size(); k++) {
+            unsigned int suffix = 0;
+            for (size_t j = k; j < values.size(); j++)
+                suffix |= 1u << (matrix->getNameEncoding(values[j].second)[0] - 'A');
+            finalValue += (values[k].first - lastValue) * referenceCapacity(*matrix, suffix);
+            lastValue = values[k].first;
+        }
+        return finalValue;
+    }
+
+private:
+    void replaceCriteria()
+    {
+        int seed = 0;
+        for (unordered_map<string, Criterion *>::iterator it = criteria.begin(); it != criteria.end(); it++) {
+            Criterion *fake = new FakeCriterion(it->first, it->second->getWeight(), ++seed);
+            delete it->second;
+            it->second = fake;
+        }
+    }
+};
+
+static void checkCapacities(WeightMatrix &matrix, int numCriteria)
+{
+    for (unsigned int mask = 0; mask < (1u << numCriteria); mask++) {
+        BOOST_CHECK_CLOSE(matrix.getCapacity(mask), referenceCapacity(matrix, mask), 1e-9);
+    }
+}
+
+static void checkChoquet(ChoquetFunction &function, const list<Pose> &frontiers)
+{
+    EvaluationRecords *records = function.evaluateFrontiers(frontiers, NULL, 0.0, NULL, NULL);
+    BOOST_CHECK(records->size() > 0);
+    int i = 0;
+    for (list<Pose>::const_iterator it = frontiers.begin(); it != frontiers.end(); it++, i++) {
+        Pose p = *it;
+        double expected = function.sortedChoquet(i);
+        if (expected > 0.0 and function.hasInformationGain(i)) {
+            BOOST_REQUIRE(records->contains(p));
+            BOOST_CHECK_CLOSE(records->getEvaluation(p), expected, 1e-9);
+        } else {
+            BOOST_CHECK(not records->contains(p));
+        }
+    }
+    delete records;
+}
+
+BOOST_AUTO_TEST_CASE( test_choquet )
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> uniform(0.05, 1.0);
+
+    cout << "1) check the capacity table against the encoded weights" << endl;
+    for (int n = 2; n <= 6; n++) {
+        WeightMatrix matrix(n);
+        for (int i = 0; i < n; i++)
+            matrix.insertSingleCriterion(string("criterion") + (char)('A' + i), uniform(generator) / n, true);
+        // leave some combinations out, to fall back to the sum of the singles
+        for (unsigned int mask = 1; mask < (1u << n); mask++) {
+            if (maskToEncoding(mask).length() > 1 and generator() % 3 != 0)
+                matrix.insertCombinationWeight(maskToEncoding(mask), uniform(generator));
+        }
+        checkCapacities(matrix, n);
+        matrix.changeCriteriaActivation("criterionA", false);
+        checkCapacities(matrix, n);
+    }
+
+    list<Pose> frontiers;
+    for (int x = 0; x < 20; x++)
+        for (int y = 0; y < 20; y++)
+            for (int orientation = 0; orientation < 360; orientation += 90)
+                frontiers.push_back(Pose(x, y, orientation, 15, M_PI));
+
+    cout << "2) check the sorting network Choquet with 3 criteria against a plain sort" << endl;
+    ChoquetFunction three(0.4, 0.3, 0.3);
+    checkChoquet(three, frontiers);
+
+    cout << "3) check the sorting network Choquet with 5 and 4 criteria against a plain sort" << endl;
+    ChoquetFunction five(0.3, 0.2, 0.2, 0.2, 0.1);
+    WeightMatrix *matrix = five.getMatrix();
+    for (unsigned int mask = 1; mask < 31; mask++) {
+        if (maskToEncoding(mask).length() > 1)
+            matrix->insertCombinationWeight(maskToEncoding(mask), uniform(generator));
+    }
+    checkChoquet(five, frontiers);
+    vector<string> names = matrix->getActiveCriteria();
+    matrix->changeCriteriaActivation(names[names.size() - 1], false);
+    checkChoquet(five, frontiers);
+
+    cout << "4) check the generic Choquet with 2 criteria against a plain sort" << endl;
+    names = three.getMatrix()->getActiveCriteria();
+    three.getMatrix()->changeCriteriaActivation(names[names.size() - 1], false);
+    checkChoquet(three, frontiers);
+}
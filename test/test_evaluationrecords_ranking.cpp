@@ -0,0 +1,129 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "pose.h"
+#include "evaluationrecords.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+
+using namespace std;
+
+// the frontiers of a record ranked by decreasing utility, storage order
+// among equal ones, with a plain stable sort
+static vector<pair<Pose, double> > sortedRecords(const EvaluationRecords &record)
+{
+    vector<int> order;
+    for (int i = 0; i < (int)record.getValues().size(); i++)
+        order.push_back(i);
+    const vector<double> &values = record.getValues();
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { return values[a] > values[b]; });
+    vector<pair<Pose, double> > toRet;
+    for (size_t i = 0; i < order.size(); i++)
+        toRet.push_back(make_pair(record.getPoses()[order[i]], values[order[i]]));
+    return toRet;
+}
+
+static void checkRanking(EvaluationRecords &record)
+{
+    vector<pair<Pose, double> > sorted = sortedRecords(record);
+    pair<Pose, double> best = record.getBest();
+    BOOST_CHECK(best.first.isEqual(sorted[0].first));
+    BOOST_CHECK_EQUAL(best.second, sorted[0].second);
+    int sizes[] = {1, 3, 10, record.size(), record.size() + 5};
+    for (int s = 0; s < 5; s++) {
+        vector<pair<Pose, double> > top = record.getTopK(sizes[s]);
+        BOOST_REQUIRE_EQUAL(top.size(), min(sizes[s], record.size()));
+        for (size_t i = 0; i < top.size(); i++) {
+            BOOST_CHECK(top[i].first.isEqual(sorted[i].first));
+            BOOST_CHECK_EQUAL(top[i].second, sorted[i].second);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_evaluationrecords_ranking )
+{
+    std::mt19937 generator(7);
+
+    cout << "1) check the best frontiers of an empty record" << endl;
+    EvaluationRecords record;
+    BOOST_CHECK_EQUAL(record.getBest().second, 0);
+    BOOST_CHECK_EQUAL(record.getTopK(5).size(), 0);
+    BOOST_CHECK_EQUAL(record.getFrontiers().size(), 0);
+
+    cout << "2) check getBest and getTopK against a sort, with equal utilities" << endl;
+    map<pair<int, int>, double> reference;
+    for (int x = 0; x < 20; x++) {
+        for (int y = 0; y < 10; y++) {
+            Pose p(x, y, 90, 5, M_PI);
+            double value = generator() % 10;
+            record.putEvaluation(p, value);
+            reference[make_pair(x, y)] = value;
+        }
+    }
+    BOOST_CHECK_EQUAL(record.size(), 200);
+    BOOST_CHECK_EQUAL(record.getTopK(0).size(), 0);
+    checkRanking(record);
+
+    cout << "3) check that a frontier keeps its first evaluation" << endl;
+    Pose first(0, 0, 90, 5, M_PI);
+    record.putEvaluation(first, 100);
+    BOOST_CHECK_EQUAL(record.size(), 200);
+    BOOST_CHECK_EQUAL(record.getEvaluation(first), reference[make_pair(0, 0)]);
+
+    cout << "4) check the removal of frontiers" << endl;
+    Pose missing(50, 50, 90, 5, M_PI);
+    record.removeFrontier(missing);
+    BOOST_CHECK_EQUAL(record.size(), 200);
+    for (int r = 0; r < 150; r++) {
+        map<pair<int, int>, double>::iterator it = reference.begin();
+        advance(it, generator() % reference.size());
+        Pose p(it->first.first, it->first.second, 90, 5, M_PI);
+        record.removeFrontier(p);
+        reference.erase(it);
+        BOOST_CHECK(not record.contains(p));
+        BOOST_REQUIRE_EQUAL(record.size(), reference.size());
+        if (r % 10 == 0) {
+            checkRanking(record);
+        }
+    }
+    for (map<pair<int, int>, double>::iterator it = reference.begin(); it != reference.end(); it++) {
+        Pose p(it->first.first, it->first.second, 90, 5, M_PI);
+        BOOST_CHECK(record.contains(p));
+        BOOST_CHECK_EQUAL(record.getEvaluation(p), it->second);
+    }
+    for (int i = 0; i < record.size(); i++) {
+        Pose p = record.getPoses()[i];
+        BOOST_CHECK_EQUAL(record.getEvaluation(p), record.getValues()[i]);
+    }
+
+    cout << "5) check the list of the frontiers ranked by utility" << endl;
+    vector<pair<Pose, double> > sorted = sortedRecords(record);
+    list<Pose> frontiers = record.getFrontiers();
+    BOOST_REQUIRE_EQUAL(frontiers.size(), sorted.size());
+    int i = 0;
+    for (list<Pose>::iterator it = frontiers.begin(); it != frontiers.end(); it++, i++) {
+        BOOST_CHECK(it->isEqual(sorted[i].first));
+    }
+    while (record.size() > 0) {
+        Pose p = record.getPoses()[0];
+        record.removeFrontier(p);
+    }
+    BOOST_CHECK_EQUAL(record.getTopK(3).size(), 0);
+
+    cout << "6) check the normalization" << endl;
+    EvaluationRecords normalized;
+    for (int x = 0; x < 10; x++) {
+        Pose p(x, 0, 0, 5, M_PI);
+        normalized.putEvaluation(p, 2 * x + 1);
+    }
+    normalized.normalize();
+    for (int x = 0; x < 10; x++) {
+        Pose p(x, 0, 0, 5, M_PI);
+        BOOST_CHECK_CLOSE(normalized.getEvaluation(p) + 1, x / 9.0 + 1, 1e-9);
+    }
+    BOOST_CHECK_EQUAL(normalized.getBest().second, 1);
+}
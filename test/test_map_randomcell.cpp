@@ -0,0 +1,138 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "pose.h"
+#include "map.h"
+#include "checkpoint.h"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace std;
+
+// 83x61 room with a wall, written as a plain PGM (255 free, 0 obstacle).
+// With a planning resolution of 0.25 the planning cells hold 4x4 cells of
+// the grid, and the last row and columns of the grid are outside them.
+static string writeTestMap()
+{
+    string fileURI = "/tmp/test_map_randomcell.pgm";
+    ofstream out(fileURI.c_str());
+    out << "P2\n83 61\n255\n";
+    for (int row = 0; row < 61; row++) {
+        for (int col = 0; col < 83; col++) {
+            bool wall = row == 0 || col == 0 || (col == 40 && row < 45);
+            out << (wall ? 0 : 255) << " ";
+        }
+        out << "\n";
+    }
+    return fileURI;
+}
+
+// scan random cells of the grid, as the sensor does
+static void scanCells(dummy::Map &map, std::mt19937 &generator, int count)
+{
+    for (int c = 0; c < count; c++) {
+        long i = generator() % map.getNumGridRows();
+        long j = generator() % map.getNumGridCols();
+        if (map.getGridValue(i, j) == OccupancyGrid::FREE)
+            map.setGridValue(OccupancyGrid::SCANNED, i, j);
+    }
+}
+
+static void checkSamples(dummy::Map &map, int count)
+{
+    for (int s = 0; s < count; s++) {
+        pair<long, long> cell = map.getRandomFreeCell();
+        BOOST_REQUIRE(cell.first >= 0 and cell.first < map.getPathPlanningNumRows());
+        BOOST_REQUIRE(cell.second >= 0 and cell.second < map.getPathPlanningNumCols());
+        BOOST_REQUIRE(map.getUnscannedSubcells(cell.first, cell.second) > 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_map_randomcell )
+{
+    string fileURI = writeTestMap();
+    dummy::Map map(fileURI, 1, 0.25);
+    BOOST_REQUIRE_EQUAL(map.getGridToPathGridScale(), 4);
+    const int scale = map.getGridToPathGridScale();
+    std::mt19937 generator(17);
+
+    cout << "1) check that the sampled cells are planning cells with unscanned free cells" << endl;
+    map.setRandomSeed(1);
+    checkSamples(map, 200);
+    for (int round = 0; round < 10; round++) {
+        scanCells(map, generator, 500);
+        checkSamples(map, 200);
+    }
+
+    cout << "2) check that the sampling follows the cells scanned and freed again" << endl;
+    // leave three cells unscanned, in three planning cells
+    long kept[3][2] = {{5, 5}, {30, 70}, {50, 20}};
+    for (long i = 0; i < map.getNumGridRows(); i++)
+        for (long j = 0; j < map.getNumGridCols(); j++)
+            if (map.getGridValue(i, j) == OccupancyGrid::FREE)
+                map.setGridValue(OccupancyGrid::SCANNED, i, j);
+    set<pair<long, long> > expected;
+    for (int k = 0; k < 3; k++) {
+        map.setGridValue(OccupancyGrid::FREE, kept[k][0], kept[k][1]);
+        expected.insert(make_pair(kept[k][0] / scale, kept[k][1] / scale));
+    }
+    set<pair<long, long> > sampled;
+    for (int s = 0; s < 300; s++) {
+        pair<long, long> cell = map.getRandomFreeCell();
+        BOOST_REQUIRE(expected.count(cell) > 0);
+        sampled.insert(cell);
+    }
+    BOOST_CHECK(sampled == expected);
+    for (int k = 0; k < 3; k++)
+        map.setGridValue(OccupancyGrid::SCANNED, kept[k][0], kept[k][1]);
+    Pose robot(3, 4, 0, 15, M_PI);
+    map.setCurrentPose(robot);
+    pair<long, long> fallback = map.getRandomFreeCell();
+    BOOST_CHECK_EQUAL(fallback.first, 3);
+    BOOST_CHECK_EQUAL(fallback.second, 4);
+
+    cout << "3) check that the same seed gives the same sequence" << endl;
+    dummy::Map first(fileURI, 1, 0.25), second(fileURI, 1, 0.25);
+    first.setRandomSeed(42);
+    second.setRandomSeed(42);
+    std::mt19937 scanFirst(5), scanSecond(5);
+    for (int round = 0; round < 5; round++) {
+        scanCells(first, scanFirst, 300);
+        scanCells(second, scanSecond, 300);
+        for (int s = 0; s < 50; s++)
+            BOOST_REQUIRE(first.getRandomFreeCell() == second.getRandomFreeCell());
+    }
+
+    cout << "4) check that a restored map draws the same cells" << endl;
+    Checkpoint checkpoint;
+    first.saveState(&checkpoint);
+    dummy::Map restored(fileURI, 1, 0.25);
+    BOOST_REQUIRE(restored.restoreState(checkpoint));
+    std::mt19937 scanRestored(9);
+    scanFirst.seed(9);
+    for (int round = 0; round < 5; round++) {
+        for (int s = 0; s < 50; s++)
+            BOOST_REQUIRE(first.getRandomFreeCell() == restored.getRandomFreeCell());
+        // the restored index is updated as the cells are scanned
+        scanCells(first, scanFirst, 300);
+        scanCells(restored, scanRestored, 300);
+        checkSamples(first, 100);
+        checkSamples(restored, 100);
+    }
+
+    cout << "5) check that an index missing a free cell is rejected" << endl;
+    vector<long> freeCells;
+    BOOST_REQUIRE(checkpoint.getVector("map.unscannedFreeCells", &freeCells));
+    freeCells.pop_back();
+    checkpoint.putVector("map.unscannedFreeCells", freeCells);
+    dummy::Map rejected(fileURI, 1, 0.25);
+    BOOST_CHECK(not rejected.restoreState(checkpoint));
+    freeCells.push_back(freeCells.front());
+    checkpoint.putVector("map.unscannedFreeCells", freeCells);
+    BOOST_CHECK(not rejected.restoreState(checkpoint));
+}
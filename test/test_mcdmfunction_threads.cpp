@@ -0,0 +1,93 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "pose.h"
+#include "map.h"
+#include "mcdmfunction.h"
+#include "evaluationrecords.h"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+// 80x80 room with two walls, written as a plain PGM (255 free, 0 obstacle)
+static string writeTestMap()
+{
+    string fileURI = "/tmp/test_mcdmfunction_threads.pgm";
+    ofstream out(fileURI.c_str());
+    out << "P2\n80 80\n255\n";
+    for (int row = 0; row < 80; row++) {
+        for (int col = 0; col < 80; col++) {
+            bool wall = row == 0 || col == 0 || row == 79 || col == 79
+                        || (col == 30 && row < 60) || (row == 50 && col > 40);
+            out << (wall ? 0 : 255) << " ";
+        }
+        out << "\n";
+    }
+    return fileURI;
+}
+
+BOOST_AUTO_TEST_CASE( test_mcdmfunction_threads )
+{
+    dummy::Map map(writeTestMap(), 1, 1);
+    Pose robot(10, 10, 0, 15, M_PI);
+    map.setCurrentPose(robot);
+    // scan a corner, so that the information gain differs between candidates
+    for (long i = 1; i < 20; i++)
+        for (long j = 1; j < 20; j++)
+            map.setGridValue(2, i, j);
+
+    list<Pose> frontiers;
+    for (int x = 5; x < 75; x += 7)
+        for (int y = 5; y < 75; y += 9)
+            if (map.getPathPlanningGridValue(x, y) != 1)
+                for (int orientation = 0; orientation < 360; orientation += 90)
+                    frontiers.push_back(Pose(x, y, orientation, 15, orientation < 180 ? M_PI : M_PI / 2));
+    double batteryTime = 100000;
+
+    cout << "1) check that the evaluation doesn't depend on the number of threads" << endl;
+    MCDMFunction function(0.4, 0.3, 0.3, true);
+    function.evaluationThreads = 1;
+    EvaluationRecords *serial = function.evaluateFrontiers(frontiers, &map, 0.0, NULL, &batteryTime);
+    BOOST_CHECK(serial->size() > 0);
+    for (int run = 0; run < 5; run++) {
+        function.evaluationThreads = 8;
+        EvaluationRecords *parallel = function.evaluateFrontiers(frontiers, &map, 0.0, NULL, &batteryTime);
+        BOOST_REQUIRE_EQUAL(parallel->size(), serial->size());
+        for (int i = 0; i < serial->size(); i++) {
+            Pose p = serial->getPoses()[i];
+            BOOST_CHECK(parallel->contains(p));
+            BOOST_CHECK_EQUAL(parallel->getEvaluation(p), serial->getValues()[i]);
+        }
+        delete parallel;
+    }
+
+    cout << "2) check the same with the weighted average" << endl;
+    MCDMFunction average(0.4, 0.3, 0.3, false);
+    average.evaluationThreads = 1;
+    EvaluationRecords *serialAverage = average.evaluateFrontiers(frontiers, &map, 0.0, NULL, &batteryTime);
+    average.evaluationThreads = 8;
+    EvaluationRecords *parallelAverage = average.evaluateFrontiers(frontiers, &map, 0.0, NULL, &batteryTime);
+    BOOST_REQUIRE_EQUAL(parallelAverage->size(), serialAverage->size());
+    for (int i = 0; i < serialAverage->size(); i++) {
+        Pose p = serialAverage->getPoses()[i];
+        BOOST_CHECK_EQUAL(parallelAverage->getEvaluation(p), serialAverage->getValues()[i]);
+    }
+
+    cout << "3) check that a pruned evaluation isn't reported as exact" << endl;
+    function.pruneCandidates = true;
+    EvaluationRecords *pruned = function.evaluateFrontiers(frontiers, &map, 0.0, NULL, &batteryTime);
+    BOOST_CHECK(function.getLastPruneRate() > 0);
+    BOOST_CHECK_EQUAL(function.isLastEvaluationExact(), false);
+    BOOST_CHECK(pruned->size() > 0);
+    function.pruneCandidates = false;
+    EvaluationRecords *exact = function.evaluateFrontiers(frontiers, &map, 0.0, NULL, &batteryTime);
+    BOOST_CHECK_EQUAL(function.isLastEvaluationExact(), true);
+    delete pruned;
+    delete exact;
+    delete serial;
+    delete serialAverage;
+    delete parallelAverage;
+}
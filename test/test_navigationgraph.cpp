@@ -0,0 +1,75 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "navigationgraph.h"
+#include "checkpoint.h"
+#include "pose.h"
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+static list<Pose> makeCandidates(int first, int count)
+{
+    list<Pose> candidates;
+    for (int i = 0; i < count; i++)
+        candidates.push_back(Pose(first + i, 2 * (first + i), 90 * (i % 4), 15, M_PI));
+    return candidates;
+}
+
+BOOST_AUTO_TEST_CASE( test_navigationgraph )
+{
+    NavigationGraph graph;
+    BOOST_CHECK_EQUAL(graph.size(), 0);
+
+    cout << "1) check push and the candidates of every node" << endl;
+    graph.push(PoseKey(1, 1, 0, 15, M_PI), makeCandidates(10, 3));
+    graph.push(PoseKey(2, 2, 90, 15, M_PI));
+    graph.push(PoseKey(3, 3, 180, 15, M_PI), makeCandidates(20, 5));
+    BOOST_CHECK_EQUAL(graph.size(), 3);
+    BOOST_CHECK_EQUAL(graph.getNumCandidates(0), 3);
+    BOOST_CHECK_EQUAL(graph.getNumCandidates(1), 0);
+    BOOST_CHECK_EQUAL(graph.getNumCandidates(2), 5);
+    BOOST_CHECK(graph.getPose(1) == PoseKey(2, 2, 90, 15, M_PI));
+    BOOST_CHECK(graph.getTopPose() == PoseKey(3, 3, 180, 15, M_PI));
+    BOOST_CHECK_EQUAL(graph.getTopNumCandidates(), 5);
+
+    list<Pose> candidates;
+    graph.getCandidates(0, &candidates);
+    list<Pose> expected = makeCandidates(10, 3);
+    BOOST_REQUIRE_EQUAL(candidates.size(), expected.size());
+    for (list<Pose>::iterator it = candidates.begin(), jt = expected.begin(); it != candidates.end(); it++, jt++)
+        BOOST_CHECK(it->isEqual(*jt));
+    graph.getCandidates(1, &candidates);
+    BOOST_CHECK(candidates.empty());
+
+    cout << "2) check that pop removes only the last node" << endl;
+    graph.pop();
+    BOOST_CHECK_EQUAL(graph.size(), 2);
+    BOOST_CHECK(graph.getTopPose() == PoseKey(2, 2, 90, 15, M_PI));
+    BOOST_CHECK_EQUAL(graph.getTopNumCandidates(), 0);
+    graph.push(PoseKey(4, 4, 270, 15, M_PI), makeCandidates(30, 2));
+    graph.getTopCandidates(&candidates);
+    BOOST_CHECK_EQUAL(candidates.size(), 2);
+    BOOST_CHECK_EQUAL(candidates.front().getX(), 30);
+    BOOST_CHECK_EQUAL(graph.getNumCandidates(0), 3);
+
+    cout << "3) check save and restore" << endl;
+    Checkpoint checkpoint;
+    graph.save(&checkpoint, "graph");
+    NavigationGraph restored;
+    BOOST_CHECK(restored.restore(checkpoint, "graph"));
+    BOOST_REQUIRE_EQUAL(restored.size(), graph.size());
+    for (int node = 0; node < graph.size(); node++) {
+        BOOST_CHECK(restored.getPose(node) == graph.getPose(node));
+        BOOST_CHECK_EQUAL(restored.getNumCandidates(node), graph.getNumCandidates(node));
+    }
+    BOOST_CHECK_EQUAL(restored.restore(checkpoint, "missing"), false);
+
+    cout << "4) check that popping every node empties the graph" << endl;
+    while (graph.size() > 0)
+        graph.pop();
+    graph.push(PoseKey(5, 5), makeCandidates(40, 1));
+    BOOST_CHECK_EQUAL(graph.getTopNumCandidates(), 1);
+}
@@ -0,0 +1,128 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "occupancygrid.h"
+#include "checkpoint.h"
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+static void checkCells(const OccupancyGrid &grid, const vector<uint8_t> &reference)
+{
+    long numCols = grid.getNumCols();
+    for (long i = 0; i < (long)reference.size(); i++) {
+        BOOST_REQUIRE_EQUAL(grid.get(i / numCols, i % numCols), reference[i]);
+        BOOST_REQUIRE_EQUAL(grid.get(i), reference[i]);
+    }
+    for (uint8_t value = 0; value < 3; value++)
+        BOOST_CHECK_EQUAL(grid.count(value), std::count(reference.begin(), reference.end(), value));
+}
+
+BOOST_AUTO_TEST_CASE( test_occupancygrid )
+{
+    const int T = OccupancyGrid::TILE_SIZE;
+    // not a multiple of the tile size, so the last row and column of tiles
+    // are cut by the border
+    const long numRows = 3 * T + 17, numCols = 2 * T + 5;
+    std::mt19937 generator(5);
+
+    cout << "1) check a new grid: uniform and without allocated tiles" << endl;
+    OccupancyGrid grid(numRows, numCols, OccupancyGrid::OBSTACLE);
+    BOOST_CHECK_EQUAL(grid.getNumRows(), numRows);
+    BOOST_CHECK_EQUAL(grid.getNumCols(), numCols);
+    BOOST_CHECK_EQUAL(grid.size(), numRows * numCols);
+    BOOST_CHECK_EQUAL(grid.getNumAllocatedTiles(), 0);
+    vector<uint8_t> reference(numRows * numCols, OccupancyGrid::OBSTACLE);
+    checkCells(grid, reference);
+
+    cout << "2) check the allocation of the tiles" << endl;
+    grid.set(0, 0, OccupancyGrid::OBSTACLE);
+    BOOST_CHECK_EQUAL(grid.getNumAllocatedTiles(), 0);
+    grid.set(0, 0, OccupancyGrid::FREE);
+    reference[0] = OccupancyGrid::FREE;
+    BOOST_CHECK_EQUAL(grid.getNumAllocatedTiles(), 1);
+    grid.set(T - 1, T - 1, OccupancyGrid::SCANNED);
+    reference[(T - 1) * numCols + T - 1] = OccupancyGrid::SCANNED;
+    BOOST_CHECK_EQUAL(grid.getNumAllocatedTiles(), 1);
+    grid.set(numRows - 1, numCols - 1, OccupancyGrid::FREE);
+    reference[numRows * numCols - 1] = OccupancyGrid::FREE;
+    BOOST_CHECK_EQUAL(grid.getNumAllocatedTiles(), 2);
+    grid.set(T * numCols + T, OccupancyGrid::SCANNED);
+    reference[T * numCols + T] = OccupancyGrid::SCANNED;
+    BOOST_CHECK_EQUAL(grid.getNumAllocatedTiles(), 3);
+    checkCells(grid, reference);
+    BOOST_CHECK(grid.isObstacle(1, 1));
+    BOOST_CHECK(not grid.isObstacle(0, 0));
+    BOOST_CHECK(grid.isScanned(T, T));
+    BOOST_CHECK(not grid.isScanned(0, 0));
+
+    cout << "3) check the release of the tiles uniform again" << endl;
+    BOOST_CHECK_EQUAL(grid.releaseUniformTiles(), 0);
+    grid.set(numRows - 1, numCols - 1, OccupancyGrid::OBSTACLE);
+    reference[numRows * numCols - 1] = OccupancyGrid::OBSTACLE;
+    BOOST_CHECK_EQUAL(grid.releaseUniformTiles(), 1);
+    BOOST_CHECK_EQUAL(grid.getNumAllocatedTiles(), 2);
+    checkCells(grid, reference);
+    // a tile uniform with a value different from the initial one
+    for (long row = T; row < 2 * T; row++)
+        for (long col = T; col < 2 * T; col++) {
+            grid.set(row, col, OccupancyGrid::SCANNED);
+            reference[row * numCols + col] = OccupancyGrid::SCANNED;
+        }
+    BOOST_CHECK_EQUAL(grid.releaseUniformTiles(), 1);
+    BOOST_CHECK_EQUAL(grid.getNumAllocatedTiles(), 1);
+    checkCells(grid, reference);
+    grid.set(T + 1, T + 1, OccupancyGrid::SCANNED);
+    BOOST_CHECK_EQUAL(grid.getNumAllocatedTiles(), 1);
+
+    cout << "4) check random updates against a plain array" << endl;
+    for (int round = 0; round < 20; round++) {
+        // a few clustered rectangles, so that some tiles become uniform
+        for (int r = 0; r < 5; r++) {
+            long row0 = generator() % numRows, col0 = generator() % numCols;
+            long rows = 1 + generator() % (2 * T), cols = 1 + generator() % (2 * T);
+            uint8_t value = generator() % 3;
+            for (long row = row0; row < min(numRows, row0 + rows); row++)
+                for (long col = col0; col < min(numCols, col0 + cols); col++) {
+                    grid.set(row, col, value);
+                    reference[row * numCols + col] = value;
+                }
+        }
+        for (int c = 0; c < 200; c++) {
+            long i = generator() % (numRows * numCols);
+            uint8_t value = generator() % 3;
+            grid.set(i, value);
+            reference[i] = value;
+        }
+        checkCells(grid, reference);
+        long allocated = grid.getNumAllocatedTiles();
+        long released = grid.releaseUniformTiles();
+        BOOST_CHECK_EQUAL(grid.getNumAllocatedTiles(), allocated - released);
+        checkCells(grid, reference);
+    }
+
+    cout << "5) check the save and the restore of the cells" << endl;
+    Checkpoint checkpoint;
+    grid.save(&checkpoint, "grid");
+    OccupancyGrid restored;
+    BOOST_CHECK(not restored.restore(checkpoint, "planning"));
+    BOOST_CHECK(restored.restore(checkpoint, "grid"));
+    BOOST_CHECK_EQUAL(restored.getNumRows(), numRows);
+    BOOST_CHECK_EQUAL(restored.getNumCols(), numCols);
+    checkCells(restored, reference);
+    BOOST_CHECK(restored.getNumAllocatedTiles() <= grid.getNumAllocatedTiles());
+
+    cout << "6) check that a new assignment releases all the tiles" << endl;
+    grid.assign(10, 20, OccupancyGrid::SCANNED);
+    BOOST_CHECK_EQUAL(grid.getNumAllocatedTiles(), 0);
+    BOOST_CHECK_EQUAL(grid.size(), 200);
+    BOOST_CHECK_EQUAL(grid.count(OccupancyGrid::SCANNED), 200);
+    BOOST_CHECK_EQUAL(grid.count(OccupancyGrid::FREE), 0);
+    OccupancyGrid empty;
+    BOOST_CHECK_EQUAL(empty.size(), 0);
+    BOOST_CHECK_EQUAL(empty.count(OccupancyGrid::FREE), 0);
+}
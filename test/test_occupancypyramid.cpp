@@ -0,0 +1,146 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "occupancygrid.h"
+#include "occupancypyramid.h"
+#include "map.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+// unscanned free cells of the grid in a rectangle, cell by cell
+static long bruteUnscanned(const OccupancyGrid &grid, long minRow, long minCol, long maxRow, long maxCol)
+{
+    long count = 0;
+    for (long row = minRow; row <= maxRow; row++)
+        for (long col = minCol; col <= maxCol; col++)
+            if (grid.get(row, col) == OccupancyGrid::FREE)
+                count++;
+    return count;
+}
+
+static void checkRectangles(const OccupancyPyramid &pyramid, const OccupancyGrid &grid, std::mt19937 &generator)
+{
+    long numRows = grid.getNumRows(), numCols = grid.getNumCols();
+    for (int r = 0; r < 200; r++) {
+        long row0 = generator() % numRows, row1 = generator() % numRows;
+        long col0 = generator() % numCols, col1 = generator() % numCols;
+        long minRow = min(row0, row1), maxRow = max(row0, row1);
+        long minCol = min(col0, col1), maxCol = max(col0, col1);
+        BOOST_REQUIRE_EQUAL(pyramid.countUnscanned(grid, minRow, minCol, maxRow, maxCol),
+                            bruteUnscanned(grid, minRow, minCol, maxRow, maxCol));
+    }
+    BOOST_CHECK_EQUAL(pyramid.countUnscanned(grid, 0, 0, numRows - 1, numCols - 1), grid.count(OccupancyGrid::FREE));
+    BOOST_CHECK_EQUAL(pyramid.countUnscanned(grid, 3, 5, 3, 5), grid.get(3, 5) == OccupancyGrid::FREE ? 1 : 0);
+}
+
+// random image with square rooms of obstacles, written as a plain PGM
+static string writeTestMap(long numRows, long numCols, std::mt19937 &generator)
+{
+    string fileURI = "/tmp/test_occupancypyramid.pgm";
+    ofstream out(fileURI.c_str());
+    out << "P2\n" << numCols << " " << numRows << "\n255\n";
+    for (long row = 0; row < numRows; row++) {
+        for (long col = 0; col < numCols; col++) {
+            bool wall = row % 37 == 0 || col % 29 == 0 || generator() % 20 == 0;
+            out << (wall ? 0 : 255) << " ";
+        }
+        out << "\n";
+    }
+    return fileURI;
+}
+
+BOOST_AUTO_TEST_CASE( test_occupancypyramid )
+{
+    std::mt19937 generator(13);
+
+    cout << "1) check the blocks of every level against the grid" << endl;
+    const long numRows = 157, numCols = 93;
+    OccupancyGrid grid(numRows, numCols);
+    for (long i = 0; i < numRows * numCols; i++)
+        grid.set(i, generator() % 3);
+    OccupancyPyramid pyramid;
+    pyramid.build(grid);
+    BOOST_CHECK_EQUAL(pyramid.getNumLevels(), 9);
+    BOOST_CHECK_EQUAL(pyramid.getNumRows(pyramid.getNumLevels() - 1), 1);
+    BOOST_CHECK_EQUAL(pyramid.getNumCols(pyramid.getNumLevels() - 1), 1);
+    for (int level = 1; level < pyramid.getNumLevels(); level++) {
+        for (long row = 0; row < pyramid.getNumRows(level); row++) {
+            for (long col = 0; col < pyramid.getNumCols(level); col++) {
+                long maxRow = min(numRows, (row + 1) << level) - 1;
+                long maxCol = min(numCols, (col + 1) << level) - 1;
+                BOOST_REQUIRE_EQUAL(pyramid.getUnscanned(level, row, col),
+                                    bruteUnscanned(grid, row << level, col << level, maxRow, maxCol));
+            }
+        }
+    }
+
+    cout << "2) check countUnscanned on random rectangles" << endl;
+    checkRectangles(pyramid, grid, generator);
+
+    cout << "3) check countUnscanned after random updates" << endl;
+    for (int round = 0; round < 10; round++) {
+        for (int u = 0; u < 500; u++) {
+            long row = generator() % numRows, col = generator() % numCols;
+            int value = generator() % 3;
+            pyramid.update(grid.get(row, col), value, row, col);
+            grid.set(row, col, value);
+        }
+        checkRectangles(pyramid, grid, generator);
+    }
+
+    cout << "4) check the counts of the map against the grid" << endl;
+    dummy::Map map(writeTestMap(200, 150, generator), 1, 1);
+    long mapRows = map.getNumGridRows(), mapCols = map.getNumGridCols();
+    BOOST_REQUIRE(mapRows > 0 and mapCols > 0);
+    for (int round = 0; round < 10; round++) {
+        // scan random squares of free cells, as the sensor does
+        for (int s = 0; s < 20; s++) {
+            long row0 = generator() % mapRows, col0 = generator() % mapCols;
+            long side = 1 + generator() % 24;
+            for (long row = row0; row < min(mapRows, row0 + side); row++)
+                for (long col = col0; col < min(mapCols, col0 + side); col++)
+                    if (map.getGridValue(row, col) == OccupancyGrid::FREE)
+                        map.setGridValue(OccupancyGrid::SCANNED, row, col);
+        }
+        for (int r = 0; r < 100; r++) {
+            long row0 = generator() % mapRows, row1 = generator() % mapRows;
+            long col0 = generator() % mapCols, col1 = generator() % mapCols;
+            long minRow = min(row0, row1), maxRow = max(row0, row1);
+            long minCol = min(col0, col1), maxCol = max(col0, col1);
+            long brute = 0;
+            for (long row = minRow; row <= maxRow; row++)
+                for (long col = minCol; col <= maxCol; col++)
+                    if (map.getGridValue(row, col) == OccupancyGrid::FREE)
+                        brute++;
+            BOOST_REQUIRE_EQUAL(map.countUnscannedCells(minRow, minCol, maxRow, maxCol), brute);
+        }
+
+        // skipScannedBlocks never jumps over an unscanned cell, and stops on
+        // a block with one
+        for (int r = 0; r < 200; r++) {
+            long i = generator() % mapRows;
+            long j = generator() % mapCols;
+            long maxJ = j + generator() % (mapCols - j);
+            long next = map.skipScannedBlocks(i, j, maxJ);
+            BOOST_REQUIRE(next >= j);
+            for (long col = j; col < min(next, mapCols); col++)
+                BOOST_REQUIRE(map.getGridValue(i, col) != OccupancyGrid::FREE);
+            if (next != j)
+                BOOST_REQUIRE_EQUAL(next % 8, 0);
+            if (next <= maxJ and next < mapCols) {
+                // the 8x8 block of next has an unscanned cell
+                long unscanned = 0;
+                for (long row = i & ~7L; row < min(mapRows, (i & ~7L) + 8); row++)
+                    for (long col = next & ~7L; col < min(mapCols, (next & ~7L) + 8); col++)
+                        if (map.getGridValue(row, col) == OccupancyGrid::FREE)
+                            unscanned++;
+                BOOST_REQUIRE(unscanned > 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,129 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "pgmimage.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+static string writeFile(const string &name, const string &content)
+{
+    string fileURI = "/tmp/test_pgmimage_" + name;
+    ofstream out(fileURI.c_str(), ios::binary);
+    out << content;
+    return fileURI;
+}
+
+static bool loadString(PGMImage &image, const string &content)
+{
+    istringstream in(content);
+    return image.load(in);
+}
+
+BOOST_AUTO_TEST_CASE( test_pgmimage )
+{
+    cout << "1) check the reading of an ASCII PGM with comments" << endl;
+    PGMImage ascii;
+    BOOST_CHECK(loadString(ascii, "P2\n# a comment\n3 2\n# another one\n255\n0 128 255\n  10\t20\n30\n"));
+    BOOST_CHECK_EQUAL(ascii.getNumRows(), 2);
+    BOOST_CHECK_EQUAL(ascii.getNumCols(), 3);
+    const int asciiValues[] = {0, 128, 255, 10, 20, 30};
+    for (int i = 0; i < 6; i++)
+        BOOST_CHECK_EQUAL(ascii.getValue(i), asciiValues[i]);
+
+    cout << "2) check the reading of a binary PGM, from a file and from a stream" << endl;
+    string binary = "P5\n4 3\n255\n";
+    for (int i = 0; i < 12; i++)
+        binary += (char)(i * 20);
+    string fileURI = writeFile("binary.pgm", binary);
+    PGMImage mapped(fileURI);
+    PGMImage streamed;
+    BOOST_CHECK(loadString(streamed, binary));
+    BOOST_CHECK_EQUAL(mapped.getNumRows(), 3);
+    BOOST_CHECK_EQUAL(mapped.getNumCols(), 4);
+    BOOST_CHECK_EQUAL(streamed.getNumRows(), 3);
+    BOOST_CHECK_EQUAL(streamed.getNumCols(), 4);
+    for (int i = 0; i < 12; i++) {
+        BOOST_CHECK_EQUAL(mapped.getValue(i), i * 20);
+        BOOST_CHECK_EQUAL(streamed.getValue(i), i * 20);
+    }
+
+    cout << "3) check that copies share the pixels" << endl;
+    const uint8_t *pixels;
+    {
+        PGMImage copy(fileURI);
+        mapped = copy;
+        pixels = copy.getPixels();
+    }
+    BOOST_CHECK_EQUAL(mapped.getPixels(), pixels);
+    BOOST_CHECK_EQUAL(mapped.getValue(11), 220);
+
+    cout << "4) check the scaling of the 16 bit grey levels" << endl;
+    string wide = "P5 2 2 1000\n";
+    const int wideValues[] = {0, 500, 1000, 4};
+    for (int i = 0; i < 4; i++) {
+        wide += (char)(wideValues[i] >> 8);
+        wide += (char)(wideValues[i] & 255);
+    }
+    PGMImage image16;
+    BOOST_CHECK(loadString(image16, wide));
+    BOOST_CHECK_EQUAL(image16.getValue(0), 0);
+    BOOST_CHECK_EQUAL(image16.getValue(1), 127);
+    BOOST_CHECK_EQUAL(image16.getValue(2), 255);
+    BOOST_CHECK_EQUAL(image16.getValue(3), 1);
+    PGMImage ascii16;
+    BOOST_CHECK(loadString(ascii16, "P2 2 1 65535 65535 257"));
+    BOOST_CHECK_EQUAL(ascii16.getValue(0), 255);
+    BOOST_CHECK_EQUAL(ascii16.getValue(1), 1);
+
+    cout << "5) check the reading of the GRID format" << endl;
+    PGMImage grid;
+    BOOST_CHECK(loadString(grid, "GRID\n2 3\n0 1 0\n1 1 0\n"));
+    BOOST_CHECK_EQUAL(grid.getNumRows(), 2);
+    BOOST_CHECK_EQUAL(grid.getNumCols(), 3);
+    const int gridValues[] = {255, 0, 255, 0, 0, 255};
+    for (int i = 0; i < 6; i++)
+        BOOST_CHECK_EQUAL(grid.getValue(i), gridValues[i]);
+
+    cout << "6) check that malformed images are rejected and leave the image empty" << endl;
+    const char *malformed[] = {
+        "",
+        "P",
+        "P6\n2 2\n255\n",
+        "PX 2 2 255 0 0 0 0",
+        "P2\n2\n",
+        "P2\n2 2\n",
+        "P2\n2 2\n0\n0 0 0 0",
+        "P2\n2 2\n70000\n0 0 0 0",
+        "P2\n2 2\n255\n0 0 0",
+        "P2\n2 2\n255\n0 0 x 0",
+        "P2\n-2 2\n255\n0 0 0 0",
+        "P2\n99999999999999999999999 2\n255\n0 0",
+        "P2\n4000000000 4000000000\n255\n0 0",
+        "P5\n2 2\n255",
+        "P5\n2 2\n255\nabc",
+        "P5\n2 2\n1000\nabcdef",
+        "P5\n3037000500 3037000500\n255\nabcd",
+        "GRID",
+        "GRID\n2 2\n0 1 0",
+        "GRID\n100000 100000\n0 1 0",
+    };
+    for (size_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++) {
+        PGMImage image;
+        BOOST_CHECK_MESSAGE(not loadString(image, malformed[i]), "accepted: " << malformed[i]);
+        BOOST_CHECK_EQUAL(image.getNumRows(), 0);
+        BOOST_CHECK_EQUAL(image.getNumCols(), 0);
+        BOOST_CHECK(image.getPixels() == NULL);
+    }
+    PGMImage missing("/tmp/test_pgmimage_missing.pgm");
+    BOOST_CHECK(missing.getPixels() == NULL);
+    PGMImage empty(writeFile("empty.pgm", ""));
+    BOOST_CHECK(empty.getPixels() == NULL);
+    PGMImage truncated;
+    BOOST_CHECK(not truncated.load(writeFile("truncated.pgm", binary.substr(0, binary.size() - 1))));
+    BOOST_CHECK(truncated.getPixels() == NULL);
+}
@@ -0,0 +1,78 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "pose.h"
+#include "posekey.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <set>
+
+using namespace std;
+
+BOOST_AUTO_TEST_CASE( test_posekey )
+{
+    std::mt19937 generator(3);
+
+    cout << "1) check the packing and the unpacking of random configurations" << endl;
+    for (int i = 0; i < 10000; i++) {
+        long x = generator() % (PoseKey::X_MASK + 1);
+        long y = generator() % (PoseKey::Y_MASK + 1);
+        int orientation = generator() % 360;
+        int range = generator() % (PoseKey::RANGE_MASK + 1);
+        int fov = generator() % 361;
+        PoseKey key(x, y, orientation, range, fov * M_PI / 180);
+        BOOST_REQUIRE_EQUAL(key.getX(), x);
+        BOOST_REQUIRE_EQUAL(key.getY(), y);
+        BOOST_REQUIRE_EQUAL(key.getOrientation(), orientation);
+        BOOST_REQUIRE_EQUAL(key.getRange(), range);
+        BOOST_REQUIRE_EQUAL(key.getFOVDegrees(), fov);
+        BOOST_REQUIRE(PoseKey::fromBits(key.getBits()) == key);
+    }
+
+    cout << "2) check the largest values of every field" << endl;
+    PoseKey largest(PoseKey::X_MASK, PoseKey::Y_MASK, 359, PoseKey::RANGE_MASK, 360 * M_PI / 180);
+    BOOST_CHECK_EQUAL(largest.getX(), (long)PoseKey::X_MASK);
+    BOOST_CHECK_EQUAL(largest.getY(), (long)PoseKey::Y_MASK);
+    BOOST_CHECK_EQUAL(largest.getOrientation(), 359);
+    BOOST_CHECK_EQUAL(largest.getRange(), (int)PoseKey::RANGE_MASK);
+    BOOST_CHECK_EQUAL(largest.getFOVDegrees(), 360);
+    PoseKey zero;
+    BOOST_CHECK(PoseKey(0, 0) == zero);
+    BOOST_CHECK_EQUAL(zero.getBits(), 0);
+    // a field never spills into its neighbours
+    BOOST_CHECK_EQUAL(PoseKey(PoseKey::X_MASK, 0).getY(), 0);
+    BOOST_CHECK_EQUAL(PoseKey(0, PoseKey::Y_MASK).getX(), 0);
+    BOOST_CHECK_EQUAL(PoseKey(0, PoseKey::Y_MASK).getOrientation(), 0);
+    BOOST_CHECK_EQUAL(PoseKey(0, 0, 359).getY(), 0);
+    BOOST_CHECK_EQUAL(PoseKey(0, 0, 359).getRange(), 0);
+    BOOST_CHECK_EQUAL(PoseKey(0, 0, 0, PoseKey::RANGE_MASK).getOrientation(), 0);
+    BOOST_CHECK_EQUAL(PoseKey(0, 0, 0, PoseKey::RANGE_MASK).getFOVDegrees(), 0);
+
+    cout << "3) check that the orientation is kept in [0, 360)" << endl;
+    BOOST_CHECK_EQUAL(PoseKey(1, 1, 360).getOrientation(), 0);
+    BOOST_CHECK_EQUAL(PoseKey(1, 1, 450).getOrientation(), 90);
+    BOOST_CHECK_EQUAL(PoseKey(1, 1, -90).getOrientation(), 270);
+    BOOST_CHECK(PoseKey(1, 1, -90) == PoseKey(1, 1, 270));
+
+    cout << "4) check the conversion from and to a Pose" << endl;
+    Pose p(12, 34, 180, 15, M_PI / 2);
+    PoseKey key(p);
+    Pose back = key.toPose();
+    BOOST_CHECK(p.isEqual(back));
+    BOOST_CHECK_EQUAL(back.getFOV(), p.getFOV());
+    BOOST_CHECK(PoseKey(back) == key);
+    BOOST_CHECK_EQUAL(key.toString(), "12/34/180/15/90");
+
+    cout << "5) check that different configurations have different keys" << endl;
+    set<uint64_t> bits;
+    for (int x = 0; x < 10; x++)
+        for (int y = 0; y < 10; y++)
+            for (int orientation = 0; orientation < 360; orientation += 90)
+                for (int fov = 90; fov <= 180; fov += 90)
+                    bits.insert(PoseKey(x, y, orientation, 15, fov * M_PI / 180).getBits());
+    BOOST_CHECK_EQUAL(bits.size(), 10 * 10 * 4 * 2);
+    BOOST_CHECK(PoseKey(1, 2) != PoseKey(2, 1));
+    BOOST_CHECK(PoseKey(1, 2) < PoseKey(2, 1));
+}
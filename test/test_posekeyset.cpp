@@ -0,0 +1,83 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "posekey.h"
+#include "posekeyset.h"
+#include "checkpoint.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace std;
+
+static void checkSet(const PoseKeySet &keys, const set<uint64_t> &reference, const vector<PoseKey> &order)
+{
+    BOOST_REQUIRE_EQUAL(keys.size(), reference.size());
+    BOOST_REQUIRE_EQUAL(keys.getKeys().size(), order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        BOOST_CHECK(keys.getKeys()[i] == order[i]);
+        BOOST_CHECK(keys.contains(order[i]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_posekeyset )
+{
+    std::mt19937 generator(11);
+
+    cout << "1) check the insertion of random keys, with duplicates" << endl;
+    PoseKeySet keys;
+    BOOST_CHECK_EQUAL(keys.size(), 0);
+    BOOST_CHECK(not keys.contains(PoseKey(0, 0)));
+    set<uint64_t> reference;
+    vector<PoseKey> order;
+    for (int i = 0; i < 5000; i++) {
+        PoseKey key(generator() % 100, generator() % 100, 90 * (generator() % 4), 15, M_PI);
+        bool added = reference.insert(key.getBits()).second;
+        BOOST_REQUIRE_EQUAL(keys.insert(key), added);
+        if (added)
+            order.push_back(key);
+    }
+    checkSet(keys, reference, order);
+
+    cout << "2) check the membership of keys not in the set" << endl;
+    for (int i = 0; i < 5000; i++) {
+        PoseKey key(generator() % 200, generator() % 200, 90 * (generator() % 4), 15, M_PI);
+        BOOST_CHECK_EQUAL(keys.contains(key), reference.count(key.getBits()) > 0);
+    }
+
+    cout << "3) check that the keys survive the growth of the table" << endl;
+    // neighbouring cells only, the case the hash has to spread
+    for (long x = 0; x < 300; x++) {
+        for (long y = 0; y < 300; y++) {
+            PoseKey key(x, y, 90, 15, M_PI);
+            if (reference.insert(key.getBits()).second) {
+                BOOST_REQUIRE(keys.insert(key));
+                order.push_back(key);
+            }
+        }
+    }
+    checkSet(keys, reference, order);
+
+    cout << "4) check the save and the restore of the keys" << endl;
+    Checkpoint checkpoint;
+    keys.save(&checkpoint, "tabu");
+    PoseKeySet restored;
+    restored.insert(PoseKey(1000, 1000));
+    BOOST_CHECK(not restored.restore(checkpoint, "visited"));
+    BOOST_CHECK(restored.restore(checkpoint, "tabu"));
+    checkSet(restored, reference, order);
+    BOOST_CHECK(not restored.contains(PoseKey(1000, 1000)));
+
+    cout << "5) check the removal of all the keys" << endl;
+    keys.clear();
+    BOOST_CHECK_EQUAL(keys.size(), 0);
+    BOOST_CHECK_EQUAL(keys.getKeys().size(), 0);
+    for (size_t i = 0; i < order.size(); i += 97)
+        BOOST_CHECK(not keys.contains(order[i]));
+    BOOST_CHECK(keys.insert(order[0]));
+    BOOST_CHECK(not keys.insert(order[0]));
+    BOOST_CHECK_EQUAL(keys.size(), 1);
+}
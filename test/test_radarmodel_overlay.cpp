@@ -0,0 +1,112 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "RadarModel.hpp"
+#include "checkpoint.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// 60x40 room with a wall, written as a plain PGM (255 free, 0 obstacle)
+static string writeTestMap()
+{
+    string fileURI = "/tmp/test_radarmodel_overlay.pgm";
+    ofstream out(fileURI.c_str());
+    out << "P2\n60 40\n255\n";
+    for (int row = 0; row < 40; row++) {
+        for (int col = 0; col < 60; col++) {
+            bool wall = row == 0 || col == 0 || row == 39 || col == 59 || (col == 30 && row > 12);
+            out << (wall ? 0 : 255) << " ";
+        }
+        out << "\n";
+    }
+    return fileURI;
+}
+
+// KL-divergence between the beliefs of two models, cell by cell
+static double bruteKL(RadarModel &posterior, RadarModel &prior, int tag_i)
+{
+    Eigen::MatrixXf q = posterior.getBeliefMatrix(tag_i);
+    Eigen::MatrixXf p = prior.getBeliefMatrix(tag_i);
+    double total = 0.0;
+    for (int r = 0; r < q.rows(); r++)
+        for (int c = 0; c < q.cols(); c++)
+            if (q(r, c) > 0 and p(r, c) > 0)
+                total += q(r, c) * log((double)q(r, c) / p(r, c));
+    return total;
+}
+
+BOOST_AUTO_TEST_CASE( test_radarmodel_overlay )
+{
+    const double resolution = 0.1, freq = MIN_FREQ_NA;
+    vector<double> freqs(1, freq);
+    vector<pair<double, double> > tags(1, make_pair(2.5, 4.0));
+    string fileURI = writeTestMap();
+    // robot poses (m., m., deg.) of the two measurements
+    const double poses[2][3] = {{1.0, 1.5, 45.0}, {2.0, 2.2, 90.0}};
+
+    for (int logBelief = 0; logBelief < 2; logBelief++) {
+        cout << logBelief + 1 << ") check the overlays with " << (logBelief ? "log" : "linear") << " beliefs" << endl;
+        RadarModel base(resolution, 3.92, 1, 30, freqs, tags, fileURI);
+        // the overlay computes the exact power of every cell
+        base.useFast = false;
+        base.setLogBelief(logBelief);
+        double rxPower = base.received_power_friis_with_obstacles(poses[0][0], poses[0][1], poses[0][2] * M_PI / 180.0,
+                                                                  tags[0].first, tags[0].second, 0, freq);
+        base.addMeasurement(poses[0][0], poses[0][1], poses[0][2], rxPower + 1.5, 0, freq, 0);
+        Eigen::MatrixXf before = base.getBeliefMatrix(0);
+        const int rows = before.rows(), cols = before.cols();
+        double beforeSum = base.getWindowBelief(0, 0, 0, rows - 1, cols - 1);
+        Checkpoint checkpoint;
+        base.saveBeliefs(&checkpoint, false);
+
+        // second measurement: a window over the whole map, then the smallest
+        // window holding every cell where the tag can be read
+        double x = poses[1][0], y = poses[1][1], orientation = poses[1][2];
+        rxPower = base.received_power_friis_with_obstacles(x, y, orientation * M_PI / 180.0,
+                                                           tags[0].first, tags[0].second, 0, freq) - 2.0;
+        Eigen::MatrixXf expected = base.getFriisMat(x, y, orientation, freq);
+        double readable = 0.0;
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                if (expected(r, c) == (float)SENSITIVITY)
+                    continue;
+                // cell centre, as placed by initRefMap
+                double cx = (rows - 1 - r) * resolution, cy = (cols - 1 - c) * resolution;
+                readable = max(readable, max(fabs(cx - x), fabs(cy - y)));
+            }
+        }
+        BOOST_REQUIRE(readable > 0);
+        const double lengths[2] = {2 * (rows + cols) * resolution, 2 * readable + 2 * resolution};
+
+        for (int l = 0; l < 2; l++) {
+            RadarModel::BeliefOverlay overlay;
+            base.addHypotheticalMeasurement(x, y, orientation, rxPower, freq, 0, lengths[l], &overlay);
+
+            // the same measurement applied for real to a copy of the beliefs
+            RadarModel copy(resolution, 3.92, 1, 30, freqs, tags, fileURI);
+            copy.useFast = false;
+            BOOST_REQUIRE(copy.restoreBeliefs(checkpoint));
+            copy.addMeasurement(x, y, orientation, rxPower, 0, freq, 0);
+
+            Eigen::MatrixXf posterior = copy.getBeliefMatrix(0);
+            float maxBelief = posterior.maxCoeff();
+            for (int r = 0; r < rows; r++)
+                for (int c = 0; c < cols; c++)
+                    BOOST_REQUIRE_SMALL(base.getBelief(overlay, grid_map::Index(r, c)) - posterior(r, c),
+                                        1e-4 * maxBelief);
+            double kl = bruteKL(copy, base, 0);
+            BOOST_CHECK(kl > 0);
+            BOOST_CHECK_CLOSE(base.getTotalKL(overlay), kl, 0.1);
+
+            // filling the overlay left the base layer as it was
+            BOOST_CHECK(base.getBeliefMatrix(0) == before);
+            BOOST_CHECK_EQUAL(base.getWindowBelief(0, 0, 0, rows - 1, cols - 1), beforeSum);
+        }
+    }
+}
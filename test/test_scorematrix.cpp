@@ -0,0 +1,94 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "scorematrix.h"
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+BOOST_AUTO_TEST_CASE( test_scorematrix )
+{
+    cout << "1) check the size and the values after a reset" << endl;
+    ScoreMatrix matrix;
+    BOOST_CHECK_EQUAL(matrix.getNumCandidates(), 0);
+    BOOST_CHECK_EQUAL(matrix.getNumCriteria(), 0);
+    matrix.reset(5, 3);
+    BOOST_CHECK_EQUAL(matrix.getNumCandidates(), 5);
+    BOOST_CHECK_EQUAL(matrix.getNumCriteria(), 3);
+    for (int c = 0; c < 3; c++) {
+        for (int k = 0; k < 5; k++) {
+            BOOST_CHECK_EQUAL(matrix.getRaw(c, k), 0);
+            BOOST_CHECK_EQUAL(matrix.getNormalized(c, k), 0);
+        }
+    }
+
+    cout << "2) check the insertion and the retrieving of the raw values" << endl;
+    for (int c = 0; c < 3; c++) {
+        for (int k = 0; k < 5; k++) {
+            matrix.setRaw(c, k, 10 * c + k);
+        }
+    }
+    for (int c = 0; c < 3; c++) {
+        for (int k = 0; k < 5; k++) {
+            BOOST_CHECK_EQUAL(matrix.getRaw(c, k), 10 * c + k);
+        }
+    }
+
+    cout << "3) check that the column of a criterion is contiguous" << endl;
+    for (int c = 0; c < 3; c++) {
+        double *column = matrix.getRawColumn(c);
+        for (int k = 0; k < 5; k++) {
+            BOOST_CHECK_EQUAL(column[k], 10 * c + k);
+        }
+    }
+
+    cout << "4) check the copy of the raw values into the normalized ones" << endl;
+    matrix.copyRawToNormalized();
+    double *normalized = matrix.getNormalizedColumn(1);
+    for (int k = 0; k < 5; k++) {
+        BOOST_CHECK_EQUAL(matrix.getNormalized(1, k), 10 + k);
+        normalized[k] = k / 4.0;
+    }
+    for (int k = 0; k < 5; k++) {
+        BOOST_CHECK_EQUAL(matrix.getNormalized(1, k), k / 4.0);
+        BOOST_CHECK_EQUAL(matrix.getRaw(1, k), 10 + k);
+    }
+
+    cout << "5) check the removal of the candidates" << endl;
+    vector<int> kept;
+    kept.push_back(0);
+    kept.push_back(2);
+    kept.push_back(4);
+    matrix.keepCandidates(kept);
+    BOOST_CHECK_EQUAL(matrix.getNumCandidates(), 3);
+    BOOST_CHECK_EQUAL(matrix.getNumCriteria(), 3);
+    for (int c = 0; c < 3; c++) {
+        for (int k = 0; k < 3; k++) {
+            BOOST_CHECK_EQUAL(matrix.getRaw(c, k), 10 * c + kept[k]);
+            BOOST_CHECK_EQUAL(matrix.getNormalized(c, k), 0);
+        }
+    }
+    kept.clear();
+    kept.push_back(1);
+    matrix.keepCandidates(kept);
+    BOOST_CHECK_EQUAL(matrix.getNumCandidates(), 1);
+    for (int c = 0; c < 3; c++) {
+        BOOST_CHECK_EQUAL(matrix.getRaw(c, 0), 10 * c + 2);
+    }
+    kept.clear();
+    matrix.keepCandidates(kept);
+    BOOST_CHECK_EQUAL(matrix.getNumCandidates(), 0);
+
+    cout << "6) check that a new reset clears the old values" << endl;
+    matrix.reset(2, 4);
+    BOOST_CHECK_EQUAL(matrix.getNumCandidates(), 2);
+    BOOST_CHECK_EQUAL(matrix.getNumCriteria(), 4);
+    for (int c = 0; c < 4; c++) {
+        for (int k = 0; k < 2; k++) {
+            BOOST_CHECK_EQUAL(matrix.getRaw(c, k), 0);
+            BOOST_CHECK_EQUAL(matrix.getNormalized(c, k), 0);
+        }
+    }
+}
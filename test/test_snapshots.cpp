@@ -0,0 +1,98 @@
+#define BOOST_TEST_MODULE MyTest
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "epochsnapshots.h"
+#include "RadarModel.hpp"
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// 50x30 room, written as a plain PGM (255 free, 0 obstacle)
+static string writeTestMap()
+{
+    string fileURI = "/tmp/test_snapshots.pgm";
+    ofstream out(fileURI.c_str());
+    out << "P2\n50 30\n255\n";
+    for (int row = 0; row < 30; row++) {
+        for (int col = 0; col < 50; col++) {
+            bool wall = row == 0 || col == 0 || row == 29 || col == 49;
+            out << (wall ? 0 : 255) << " ";
+        }
+        out << "\n";
+    }
+    return fileURI;
+}
+
+BOOST_AUTO_TEST_CASE( test_snapshots )
+{
+    cout << "1) check the epochs of the published copies" << endl;
+    EpochSnapshots<vector<int> > snapshots;
+    long epoch = -1;
+    BOOST_CHECK_EQUAL(snapshots.getEpoch(), 0);
+    BOOST_CHECK(not snapshots.acquire(&epoch));
+    BOOST_CHECK_EQUAL(epoch, 0);
+    BOOST_CHECK_EQUAL(snapshots.publish(make_shared<vector<int> >(3, 1)), 1);
+    shared_ptr<vector<int> > first = snapshots.acquire(&epoch);
+    BOOST_CHECK_EQUAL(epoch, 1);
+    BOOST_REQUIRE(first);
+    BOOST_CHECK(*first == vector<int>(3, 1));
+    // a reader of the first epoch keeps its copy while the next is published
+    BOOST_CHECK_EQUAL(snapshots.publish(make_shared<vector<int> >(5, 2)), 2);
+    shared_ptr<vector<int> > second = snapshots.acquire(&epoch);
+    BOOST_CHECK_EQUAL(epoch, 2);
+    BOOST_CHECK_EQUAL(snapshots.getEpoch(), 2);
+    BOOST_CHECK(*second == vector<int>(5, 2));
+    BOOST_CHECK(*first == vector<int>(3, 1));
+    BOOST_CHECK(snapshots.acquire() == second);
+    // the copy of an old epoch is released with its last reader
+    weak_ptr<vector<int> > released = first;
+    first.reset();
+    BOOST_CHECK(released.expired());
+
+    cout << "2) check that a snapshot keeps the beliefs it was taken with" << endl;
+    const double freq = MIN_FREQ_NA;
+    vector<double> freqs(1, freq);
+    vector<pair<double, double> > tags;
+    tags.push_back(make_pair(1.5, 3.0));
+    tags.push_back(make_pair(2.0, 1.0));
+    RadarModel rm(0.1, 3.92, 1, 30, freqs, tags, writeTestMap());
+    shared_ptr<RadarModel> before = rm.snapshot();
+    vector<Eigen::MatrixXf> beliefs;
+    vector<double> windows;
+    for (int i = 0; i < 2; i++) {
+        beliefs.push_back(before->getBeliefMatrix(i));
+        BOOST_CHECK(beliefs[i] == rm.getBeliefMatrix(i));
+        windows.push_back(before->getWindowBelief(i, 5, 5, 20, 30));
+        BOOST_CHECK_CLOSE(windows[i], rm.getWindowBelief(i, 5, 5, 20, 30), 1e-3);
+    }
+    for (int i = 0; i < 2; i++) {
+        double rxPower = rm.received_power_friis_with_obstacles(1.0, 2.0, 0, tags[i].first, tags[i].second, 0, freq);
+        rm.addMeasurement(1.0, 2.0, 0, rxPower, 0, freq, i);
+    }
+    for (int i = 0; i < 2; i++) {
+        // the model moved on, the snapshot and its window sums did not
+        BOOST_CHECK(rm.getBeliefMatrix(i) != beliefs[i]);
+        BOOST_CHECK(before->getBeliefMatrix(i) == beliefs[i]);
+        BOOST_CHECK_EQUAL(before->getWindowBelief(i, 5, 5, 20, 30), windows[i]);
+        Eigen::MatrixXf now = rm.getBeliefMatrix(i);
+        BOOST_CHECK_CLOSE(rm.getWindowBelief(i, 5, 5, 20, 30), (double)now.block(5, 5, 16, 26).sum(), 1e-2);
+    }
+
+    cout << "3) check the snapshots published as the model changes" << endl;
+    EpochSnapshots<RadarModel> published;
+    published.publish(before);
+    shared_ptr<RadarModel> reader = published.acquire(&epoch);
+    BOOST_CHECK_EQUAL(epoch, 1);
+    BOOST_CHECK_EQUAL(published.publish(rm.snapshot()), 2);
+    shared_ptr<RadarModel> latest = published.acquire(&epoch);
+    BOOST_CHECK_EQUAL(epoch, 2);
+    for (int i = 0; i < 2; i++) {
+        BOOST_CHECK(latest->getBeliefMatrix(i) == rm.getBeliefMatrix(i));
+        BOOST_CHECK(reader->getBeliefMatrix(i) == beliefs[i]);
+        BOOST_CHECK_EQUAL(reader->getWindowBelief(i, 5, 5, 20, 30), windows[i]);
+    }
+}
@@ -13,17 +13,9 @@ Utilities::Utilities(){};
 
 Utilities::~Utilities(){}
 
-bool Utilities::contains ( std::list<Pose>& list, Pose& p )
+bool Utilities::contains ( PoseKeySet& list, PoseKey p )
 {
-  bool result = false;
-
-  std::list<Pose>::iterator findIter = std::find ( list.begin(), list.end(), p );
-  if ( findIter != list.end() )
-  {
-    result = true;
-  }
-
-  return result;
+  return list.contains ( p );
 }
 
 void Utilities::cleanPossibleDestination2(std::list<Pose> *possibleDestinations, Pose &p) 
@@ -37,8 +29,13 @@ void Utilities::cleanPossibleDestination2(std::list<Pose> *possibleDestinations,
   
 }
 
+void Utilities::cleanPossibleDestinations(std::list<Pose> *possibleDestinations, PoseKeySet *tabuList)
+{
+  possibleDestinations->remove_if([this, tabuList](Pose &p){ return this->contains ( *tabuList, PoseKey ( p ) ); });
+}
+
 
-void Utilities::pushInitialPositions ( dummy::Map* map, int x, int y, int orientation, int range, int FOV, double threshold, string actualPose, vector< pair< string, list< Pose > > >* graph2, MCDMFunction *function, RFID_tools *rfid_tools , double *batteryTime)
+void Utilities::pushInitialPositions ( dummy::Map* map, int x, int y, int orientation, int range, int FOV, double threshold, PoseKey actualPose, NavigationGraph* graph2, MCDMFunction *function, RFID_tools *rfid_tools , double *batteryTime)
 {
   NewRay ray;
   ray.findCandidatePositions ( map,x,y,orientation ,FOV,range );
@@ -59,8 +56,7 @@ void Utilities::pushInitialPositions ( dummy::Map* map, int x, int y, int orient
   }
   EvaluationRecords *record = function->evaluateFrontiers ( frontiers, map, threshold, rfid_tools, batteryTime );
   list<Pose>nearCandidates = record->getFrontiers();
-  std::pair<string,list<Pose>> pair = make_pair ( actualPose,nearCandidates );
-  graph2->push_back ( pair );
+  graph2->push ( actualPose,nearCandidates );
 }
 
 double Utilities::calculateScanTime ( double scanAngle )
@@ -70,21 +66,20 @@ double Utilities::calculateScanTime ( double scanAngle )
 
 Pose Utilities::createFromInitialPose ( int x, int y, int orientation, int variation, int range, int FOV )
 {
-  Pose tmp = Pose ( x,y, ( orientation + variation ) %360,FOV,range );
+  Pose tmp = Pose ( x,y, ( orientation + variation ) %360,range,FOV );
   return tmp;
 }
 
 
-double Utilities::calculateDistance(list<Pose> history, dummy::Map* map, Astar* astar)
+double Utilities::calculateDistance(const vector<PoseKey> &history, dummy::Map* map, Astar* astar)
 {
-    // std::list<Pose>::iterator it = history.begin();
     double travelledDistance = 0;
     int numOfTurning = 0;
     // std::cout << "len: " << history.size() << endl;
     // Calculate the overall path connecting these cells
-    for (auto it = history.begin(); it != prev ( history.end(),1 ); it++ )
+    for (auto it = history.begin(); it != history.end() && next ( it,1 ) != history.end(); it++ )
     {
-        std::list<Pose>::iterator it2 = next ( it,1 );
+        auto it2 = next ( it,1 );
         // std::cout << it->getX() << " " << it->getY() << " : " << it2->getX() << " " << it2->getY() << endl;
         // std::cout << "1" << endl;
         string path = astar->pathFind ( ( *it2 ).getX(), ( *it2 ).getY(), ( *it ).getX(), ( *it ).getY(), map );
@@ -101,16 +96,15 @@ double Utilities::calculateDistance(list<Pose> history, dummy::Map* map, Astar*
 }
 
 
-double Utilities::calculateRemainingBatteryPercentage(list<Pose> history, dummy::Map* map, Astar* astar)
+double Utilities::calculateRemainingBatteryPercentage(const vector<PoseKey> &history, dummy::Map* map, Astar* astar)
 {
-    // std::list<Pose>::iterator it = history.begin();
     double distance, tmp_numOfTurning, translTime, rotTime = 0;
     double batteryTime = MAX_BATTERY;
     // std::cout << "len: " << history.size() << endl;
     // Calculate the overall path connecting these cells
-    for (auto it = history.begin(); it != prev ( history.end(),1 ); it++ )
+    for (auto it = history.begin(); it != history.end() && next ( it,1 ) != history.end(); it++ )
     {
-        std::list<Pose>::iterator it2 = next ( it,1 );
+        auto it2 = next ( it,1 );
         // std::cout << it->getX() << " " << it->getY() << " : " << it2->getX() << " " << it2->getY() << endl;
         // std::cout << "1" << endl;
         string path = astar->pathFind ( ( *it2 ).getX(), ( *it2 ).getY(), ( *it ).getX(), ( *it ).getY(), map );
@@ -128,26 +122,22 @@ double Utilities::calculateRemainingBatteryPercentage(list<Pose> history, dummy:
   return batteryTime;
 }
 
-void Utilities::updatePathMetrics(int* count, Pose* target, Pose* previous, string actualPose, list<Pose>* nearCandidates, vector<pair<string,list<Pose>>>* graph2,
-    dummy::Map* map, MCDMFunction* function, list<Pose>* tabuList, vector<string>* history, int encodedKeyValue, Astar* astar , long* numConfiguration,
+void Utilities::updatePathMetrics(int* count, Pose* target, Pose* previous, PoseKey actualPose, list<Pose>* nearCandidates, NavigationGraph* graph2,
+    dummy::Map* map, MCDMFunction* function, PoseKeySet* tabuList, vector<pair<PoseKey,int>>* history, int encodedKeyValue, Astar* astar , long* numConfiguration,
     double* totalAngle, double* travelledDistance, int* numOfTurning , double scanAngle, double *batteryTime)
 {
   // Add it to the list of visited cells as first-view
-  // history->push_back ( function->getEncodedKey ( *target, encodedKeyValue ) );
-  for (auto it = tabuList->begin(); it != tabuList->end(); it++){
-    this->cleanPossibleDestination2 ( nearCandidates, *it);
-  }
+  this->cleanPossibleDestinations ( nearCandidates, tabuList );
   // Remove it from the list of candidate position
   cleanPossibleDestination2 ( nearCandidates, *target );
   // Push in the graph the previous robot pose and the new list of candidate position, without the current pose of the robot
   // We don't want to visit this cell again
-  std::pair<string,list<Pose>> pair = make_pair ( actualPose, *nearCandidates );
   // NOTE: if we are in backtracking there is no reason to add a cell already present (it will only make increase the graph)
   if (encodedKeyValue != 2) {
     // Add it to the list of visited cells from which acting
-    history->push_back ( function->getEncodedKey ( *target, encodedKeyValue ) );
-    tabuList->push_back ( *target );
-    graph2->push_back ( pair );
+    history->push_back ( make_pair ( PoseKey ( *target ), encodedKeyValue ) );
+    tabuList->insert ( PoseKey ( *target ) );
+    graph2->push ( actualPose, *nearCandidates );
     // Calculate the path from the previous robot pose to the current one
     string path = astar->pathFind ( target->getX(), target->getY(), previous->getX(), previous->getY(), map );
     // // Update the distance counting
@@ -169,14 +159,14 @@ void Utilities::updatePathMetrics(int* count, Pose* target, Pose* previous, stri
   } 
 }
 
-list<Pose> Utilities::cleanHistory(vector<string>* history, EvaluationRecords* record){
-  vector<string>::iterator it_history = history->begin();
-  list<Pose> tmp_history;
+vector<PoseKey> Utilities::cleanHistory(vector<pair<PoseKey,int>>* history){
+  vector<pair<PoseKey,int>>::iterator it_history = history->begin();
+  vector<PoseKey> tmp_history;
   for ( it_history; it_history!=prev(history->end(),1); it_history++)
   {
-    if ((*it_history).back() == '1')
+    if ((*it_history).second == 1)
     {
-      tmp_history.push_back(record->getPoseFromEncoding(*it_history));
+      tmp_history.push_back((*it_history).first);
     }
   }
   return tmp_history;
@@ -272,8 +262,8 @@ void Utilities::saveCoverage(const std::string& name, const std::string& content
 
 
 bool Utilities::recordContainsCandidates( EvaluationRecords* record,
-                              int* count, Pose* target, Pose* previous, string* actualPose, list<Pose>* nearCandidates, vector<pair<string,list<Pose>>>* graph2,
-                              dummy::Map* map, MCDMFunction* function, list<Pose>* tabuList, vector<string>* history, int* encodedKeyValue, Astar* astar , long* numConfiguration,
+                              int* count, Pose* target, Pose* previous, PoseKey* actualPose, list<Pose>* nearCandidates, NavigationGraph* graph2,
+                              dummy::Map* map, MCDMFunction* function, PoseKeySet* tabuList, vector<pair<PoseKey,int>>* history, int* encodedKeyValue, Astar* astar , long* numConfiguration,
                               double* totalAngle, double* travelledDistance, int* numOfTurning , double* scanAngle, bool* btMode, double* threshold,
                               RFID_tools *rfid_tools, double *batteryTime)
 {
@@ -283,7 +273,7 @@ bool Utilities::recordContainsCandidates( EvaluationRecords* record,
   std::pair<Pose,double> result = function->selectNewPose ( record );
   *target = result.first;
   // If the selected destination does not appear among the cells already visited
-  if ( ! this->contains ( *tabuList, *target ))
+  if ( ! this->contains ( *tabuList, PoseKey ( *target ) ))
   {
     // std::cout << "F6-2" << endl;
     // act = true;
@@ -298,7 +288,7 @@ bool Utilities::recordContainsCandidates( EvaluationRecords* record,
     // If the graph is empty, stop the navigation
     if ( graph2->size() == 0 ) return true;
     // If there still are more candidates to explore from the last pose in the graph
-    if ( graph2->at ( graph2->size()-1 ).second.size() != 0 )
+    if ( graph2->getTopNumCandidates() != 0 )
     { 
       // std::cout <<"F7" << endl;
       // std::cout << "[BT1 - Tabulist]There are visible cells but the selected one is already explored!Come back to second best position from the previous position"<< endl;
@@ -326,9 +316,9 @@ bool Utilities::recordContainsCandidates( EvaluationRecords* record,
         // if the graph is now empty, stop the navigation
         if ( graph2->size() == 0 ) return true;
         // Otherwise, select as new position the last cell in the graph and then remove it from there
-        string targetString = graph2->at ( graph2->size()-1 ).first;
-        graph2->pop_back();
-        *target = record->getPoseFromEncoding ( targetString );
+        PoseKey targetKey = graph2->getTopPose();
+        graph2->pop();
+        *target = targetKey.toPose();
       }
     }
     // ... if the graph still does not present anymore candidate positions for its last pose
@@ -336,12 +326,12 @@ bool Utilities::recordContainsCandidates( EvaluationRecords* record,
     {
       // std::cout <<"F10" << endl;
       // Remove the last element (cell and associated candidate from there) from the graph
-      graph2->pop_back();
+      graph2->pop();
       // Select as new target, the new last element of the graph
-      string targetString = graph2->at ( graph2->size()-1 ).first;
-      *target = record->getPoseFromEncoding ( targetString );
+      PoseKey targetKey = graph2->getTopPose();
+      *target = targetKey.toPose();
       // Save it history as cell visited more than once
-      history->push_back ( function->getEncodedKey ( *target,2 ) );
+      history->push_back ( make_pair ( PoseKey ( *target ), 2 ) );
       // std::cout << "[BT2 - Tabulist]There are visible cells but the selected one is already explored!Come back to two position ago"<< endl;
       count++;
     }
@@ -350,15 +340,15 @@ bool Utilities::recordContainsCandidates( EvaluationRecords* record,
   return false;
 }
 
-bool Utilities::recordNOTContainsCandidates(vector<pair<string,list<Pose>>>* graph2, EvaluationRecords* record, Pose* target, Pose* previous, vector<string>* history,
+bool Utilities::recordNOTContainsCandidates(NavigationGraph* graph2, EvaluationRecords* record, Pose* target, Pose* previous, vector<pair<PoseKey,int>>* history,
                                   MCDMFunction* function, int* count){
   // If the graph is empty, stop the navigation
   if ( graph2->size() == 0 ) return true;
   // Select as new target the last one in the graph structure
-  string targetString = graph2->at ( graph2->size()-1 ).first;
+  PoseKey targetKey = graph2->getTopPose();
   // Remove it from the graph
-  graph2->pop_back();
-  *target = record->getPoseFromEncoding ( targetString );
+  graph2->pop();
+  *target = targetKey.toPose();
   int encoding = 0;
   // Check if the selected cell in the graph is the previous robot position
   if ( !target->isEqual ( *previous ) )
@@ -371,23 +361,23 @@ bool Utilities::recordNOTContainsCandidates(vector<pair<string,list<Pose>>>* gra
     // If there are no more cells in the graph, just finish the navigation
     if ( graph2->size() == 0 ) return true;
     // Select the last position in the graph
-    string targetString = graph2->at ( graph2->size()-1 ).first;
+    PoseKey targetKey = graph2->getTopPose();
     // and remove it from the graph
-    graph2->pop_back();
-    *target = record->getPoseFromEncoding ( targetString );
+    graph2->pop();
+    *target = targetKey.toPose();
   }
   // Set the previous pose as the current one
   *previous = *target;
   // Add it in history as cell visited more than once
-  history->push_back ( function->getEncodedKey ( *target,2 ) );
+  history->push_back ( make_pair ( PoseKey ( *target ), 2 ) );
   count++;
   return false;
 }
 
 
 void Utilities::recordContainsCandidatesBT(EvaluationRecords* record,
-                              int* count, Pose* target, Pose* previous, string* actualPose, list<Pose>* nearCandidates, vector<pair<string,list<Pose>>>* graph2,
-                              dummy::Map* map, MCDMFunction* function, list<Pose>* tabuList, vector<string>* history, int* encodedKeyValue, Astar* astar , long* numConfiguration,
+                              int* count, Pose* target, Pose* previous, PoseKey* actualPose, list<Pose>* nearCandidates, NavigationGraph* graph2,
+                              dummy::Map* map, MCDMFunction* function, PoseKeySet* tabuList, vector<pair<PoseKey,int>>* history, int* encodedKeyValue, Astar* astar , long* numConfiguration,
                               double* totalAngle, double * travelledDistance, int* numOfTurning , double* scanAngle, bool* btMode, double* threshold,
                               RFID_tools *rfid_tools, double *batteryTime)
 {
@@ -395,7 +385,7 @@ void Utilities::recordContainsCandidatesBT(EvaluationRecords* record,
   std::pair<Pose,double> result = function->selectNewPose ( record );
   *target = result.first;
   // If this cells has not been visited before
-  if ( ! this->contains ( *tabuList, *target ) )
+  if ( ! this->contains ( *tabuList, PoseKey ( *target ) ) )
   { 
     // std::cout << "1" << endl;
     // Add it to the list of visited cells as first-view
@@ -417,9 +407,7 @@ void Utilities::recordContainsCandidatesBT(EvaluationRecords* record,
       // std::cout << "[BT-MODE1]Already visited, but there are other candidates" << endl;
 
       // Remove the destination from the candidate list
-      for (auto it = tabuList->begin(); it != tabuList->end(); it++){
-        this->cleanPossibleDestination2 ( nearCandidates, *it);
-      }
+      this->cleanPossibleDestinations ( nearCandidates, tabuList );
       this->cleanPossibleDestination2 ( nearCandidates, *target );
       // Get the candidates with their evaluation
       EvaluationRecords *record = function->evaluateFrontiers ( *nearCandidates, map, *threshold, rfid_tools, batteryTime);
@@ -447,11 +435,11 @@ void Utilities::recordContainsCandidatesBT(EvaluationRecords* record,
       // std::cout << "3" << endl;
       // std::cout << "[BT-MODE2] Go back to previous positions in the graph" << endl;
       // Select as target the last element in the graph
-      string targetString = graph2->at ( graph2->size()-1 ).first;
-      *target = record->getPoseFromEncoding ( targetString );
-      *nearCandidates = graph2->at ( graph2->size()-1 ).second;
+      PoseKey targetKey = graph2->getTopPose();
+      *target = targetKey.toPose();
+      graph2->getTopCandidates ( nearCandidates );
       // And remove from the graph
-      graph2->pop_back();
+      graph2->pop();
       // if ( ! this->contains ( *tabuList, *target ) ) {
       //   *btMode = false;
       //   // *encodedKeyValue = 2;
@@ -475,17 +463,17 @@ void Utilities::recordContainsCandidatesBT(EvaluationRecords* record,
 }
 
 void Utilities::recordNOTContainsCandidatesBT(EvaluationRecords* record,
-                              int* count, Pose* target, Pose* previous, string* actualPose, list<Pose>* nearCandidates, vector<pair<string,list<Pose>>>* graph2,
-                              dummy::Map* map, MCDMFunction* function, list<Pose>* tabuList, vector<string>* history, int* encodedKeyValue, Astar* astar , long* numConfiguration,
+                              int* count, Pose* target, Pose* previous, PoseKey* actualPose, list<Pose>* nearCandidates, NavigationGraph* graph2,
+                              dummy::Map* map, MCDMFunction* function, PoseKeySet* tabuList, vector<pair<PoseKey,int>>* history, int* encodedKeyValue, Astar* astar , long* numConfiguration,
                               double* totalAngle, double * travelledDistance, int* numOfTurning , double* scanAngle, bool* btMode, double* threshold, double* batteryTime){
   // Select as new pose, the last cell in the graph
-  graph2->pop_back();
-  string targetString = graph2->at ( graph2->size()-1 ).first;
-  *nearCandidates = graph2->at ( graph2->size()-1 ).second;
+  graph2->pop();
+  PoseKey targetKey = graph2->getTopPose();
+  graph2->getTopCandidates ( nearCandidates );
   // and the remove it form the graph
   
 
-  *target = record->getPoseFromEncoding ( targetString );
+  *target = targetKey.toPose();
 
   // Add it in history as cell visited more than once
   *encodedKeyValue = 2;
@@ -558,21 +546,31 @@ void Utilities::updateMaps( dummy::Map* map, Pose* target,
   }
 }
 
-void Utilities::computePosteriorBeliefSingleLayer( dummy::Map* map, Pose* target,
-                            RFID_tools *rfid_tools, int tag_id, double len_update){
+std::thread Utilities::updateMapsAsync( dummy::Map* map, Pose* target, RFID_tools *rfid_tools){
   std::pair<int, int> relTagCoord;
-  // std::cout << "----" << std::endl;  
-  relTagCoord = map->getRelativeTagCoord((rfid_tools->tags_coord)[tag_id].first, (rfid_tools->tags_coord)[tag_id].second, target->getX(), target->getY());
-  // Calculate the received power and phase
-  double rxPower = rfid_tools->rm->received_power_friis_with_obstacles(target->getX(), target->getY(), target->getOrientation() * 3.141592/180.0, (rfid_tools->tags_coord)[tag_id].first, (rfid_tools->tags_coord)[tag_id].second , 0, rfid_tools->freq);
-  double phase = rfid_tools->rm->phaseDifference(relTagCoord.first, relTagCoord.second, rfid_tools->freq);    
-  //So, robot at pr (x,y,orientation) (long, long, int) receives rxPower,phase,freq from tag i . 
-  rfid_tools->rm->addTmpMeasurementRFIDCriterion(target->getX(), target->getY(), target->getOrientation() , rxPower, phase, rfid_tools->freq, tag_id, len_update);
+  vector<double> rxPowers, phases;
+  for (int i = 0; i < rfid_tools->tags_coord.size(); i++){
+    relTagCoord = map->getRelativeTagCoord((rfid_tools->tags_coord)[i].first, (rfid_tools->tags_coord)[i].second, target->getX(), target->getY());
+    // Calculate the received power and phase, as in updateMaps
+    double rxPower = rfid_tools->rm->received_power_friis_with_obstacles(target->getX(), target->getY(), target->getOrientation() * 3.141592/180.0, (rfid_tools->tags_coord)[i].first, (rfid_tools->tags_coord)[i].second , 0, rfid_tools->freq);
+    double phase = rfid_tools->rm->phaseDifference(relTagCoord.first, relTagCoord.second, rfid_tools->freq);
+    rxPowers.push_back(rxPower);
+    phases.push_back(phase);
+    // Update the path planning and RFID map
+    map->updatePathPlanningGrid ( target->getX(), target->getY(), target->getRange(), rxPower - rfid_tools->sensitivity);
+    rfid_tools->RFID_maps_list->at(i).addEllipse(rxPower < rfid_tools->sensitivity ? 0 : 1, map->getNumGridRows() - target->getX(),  target->getY(), target->getOrientation(), -1.0, target->getRange());
+  }
+  // the belief maps are updated in the same order as in updateMaps
+  RadarModel *rm = rfid_tools->rm;
+  double x = target->getX(), y = target->getY(), orientation = target->getOrientation(), freq = rfid_tools->freq;
+  return std::thread([rm, x, y, orientation, freq, rxPowers, phases]() {
+    for (int i = 0; i < rxPowers.size(); i++)
+      rm->addMeasurement(x, y, orientation, rxPowers[i], phases[i], freq, i);
+  });
 }
 
-
-bool Utilities::updateNavigationGraph(int *count, MCDMFunction *function, vector<pair<string,list<Pose>>> *graph2, Pose *target , dummy::Map *map, 
-                            long *x, long *y, int *orientation, int *range, double *FOV, double *threshold, string *actualPose,
+bool Utilities::updateNavigationGraph(int *count, MCDMFunction *function, NavigationGraph *graph2, Pose *target , dummy::Map *map, 
+                            long *x, long *y, int *orientation, int *range, double *FOV, double *threshold, PoseKey *actualPose,
                             RFID_tools *rfid_tools, double *batteryTime){
   if ( count == 0 )
     {
@@ -580,17 +578,13 @@ bool Utilities::updateNavigationGraph(int *count, MCDMFunction *function, vector
       this->eastInitial     = this->createFromInitialPose ( *x, *y, *orientation,90, *range, *FOV );
       this->westInitial     = this->createFromInitialPose ( *x, *y, *orientation,270, *range, *FOV );
       // Calculate other three pose given the starting one
-      string invertedPose = function->getEncodedKey ( invertedInitial,0 );
-      string eastPose     = function->getEncodedKey ( eastInitial,0 );
-      string westPose     = function->getEncodedKey ( westInitial,0 );
-      list<Pose> empty ;
-      std::pair<string,list<Pose>> pair1 = make_pair ( invertedPose,empty );
-      std::pair<string,list<Pose>> pair2 = make_pair ( eastPose,empty );
-      std::pair<string,list<Pose>> pair3 = make_pair ( westPose,empty );
+      PoseKey invertedPose ( invertedInitial );
+      PoseKey eastPose     ( eastInitial );
+      PoseKey westPose     ( westInitial );
       // And add them (with empty candidates) to the graph structure
-      graph2->push_back ( pair1 );
-      graph2->push_back ( pair2 );
-      graph2->push_back ( pair3 );
+      graph2->push ( invertedPose );
+      graph2->push ( eastPose );
+      graph2->push ( westPose );
     }
 
     // If it's not the first step but we are in one of the initial position (we come back here with backtracking)
@@ -598,8 +592,8 @@ bool Utilities::updateNavigationGraph(int *count, MCDMFunction *function, vector
     {
       // If there are no more destination in the graph, terminates the navigation
       if ( graph2->size() == 0 ) return true;
-      graph2->pop_back();
-      *actualPose = function->getEncodedKey ( *target,0 );
+      graph2->pop();
+      *actualPose = PoseKey ( *target );
       // Add to the graph the initial positions and the candidates from there (calculated inside the function)
       this->pushInitialPositions ( map, *x, *y, *orientation, *range, *FOV, *threshold, *actualPose, graph2, function, rfid_tools, batteryTime );
     }
@@ -608,11 +602,11 @@ bool Utilities::updateNavigationGraph(int *count, MCDMFunction *function, vector
 
 bool Utilities::forwardMotion(Pose *target, Pose *previous, list<Pose> *frontiers, list<Pose> *nearCandidates, 
                               vector<pair<long,long> > *candidatePosition, NewRay *ray, dummy::Map *map, 
-                              long *x, long *y, int *orientation, double *FOV, int *range, vector<pair<string,list<Pose>>> *graph2,
-                              EvaluationRecords *record, MCDMFunction *function, double *threshold, int *count, vector<string> *history, 
-                              list<Pose> *tmp_history, list<Pose> *tabuList, Astar *astar, double *imgresolution, double *travelledDistance,
+                              long *x, long *y, int *orientation, double *FOV, int *range, NavigationGraph *graph2,
+                              EvaluationRecords *record, MCDMFunction *function, double *threshold, int *count, vector<pair<PoseKey,int>> *history, 
+                              vector<PoseKey> *tmp_history, PoseKeySet *tabuList, Astar *astar, double *imgresolution, double *travelledDistance,
                               long *sensedCells, long *newSensedCells, long *totalFreeCells, double *totalScanTime, string *out_log, 
-                              long *numConfiguration, string *actualPose, int* encodedKeyValue, double *totalAngle, int *numOfTurning,
+                              long *numConfiguration, PoseKey *actualPose, int* encodedKeyValue, double *totalAngle, int *numOfTurning,
                               double *scanAngle, bool *btMode, RFID_tools *rfid_tools, double *accumulated_received_power, double *precision, double *batteryTime)
 {
   // If there are no new candidate positions from the current pose of the robot
@@ -631,12 +625,12 @@ bool Utilities::forwardMotion(Pose *target, Pose *previous, list<Pose> *frontier
     {
       // std::cout <<"F3" << endl;
       // Get the last position in the graph and then remove it
-      graph2->pop_back();
-      string targetString = graph2->at ( graph2->size()-1 ).first;
-      *target = record->getPoseFromEncoding ( targetString );
-      *nearCandidates = graph2->at ( graph2->size()-1 ).second;
+      graph2->pop();
+      PoseKey targetKey = graph2->getTopPose();
+      *target = targetKey.toPose();
+      graph2->getTopCandidates ( nearCandidates );
       // Add it to the history as cell visited more than once
-      history->push_back ( function->getEncodedKey ( *target,2 ) );
+      history->push_back ( make_pair ( PoseKey ( *target ), 2 ) );
       // std::cout << "[BT]No significative position reachable. Come back to previous position" << endl;
       *count++;
       *btMode = true;
@@ -650,15 +644,15 @@ bool Utilities::forwardMotion(Pose *target, Pose *previous, list<Pose> *frontier
       // std::cout << "Travelled distance calculated during the algorithm: " << travelledDistance << endl;
       // std::cout << "------------------ HISTORY -----------------" << endl;
       // Retrieve the cell visited only the first time
-      // *tmp_history = this->cleanHistory(history, record);
+      // *tmp_history = this->cleanHistory(history);
       // this->calculateDistance(*tmp_history, map, astar );
 
       // std::cout << "------------------ TABULIST -----------------" << endl;
       // Calculate the path connecting the cells in the tabulist, namely the cells that are visited one time and couldn't be visite again
 
       //NOTE Get correct values from tabuList
-      *travelledDistance = this->calculateDistance(*tabuList, map, astar );
-      *batteryTime = this->calculateRemainingBatteryPercentage(*tabuList, map, astar );
+      *travelledDistance = this->calculateDistance(tabuList->getKeys(), map, astar );
+      *batteryTime = this->calculateRemainingBatteryPercentage(tabuList->getKeys(), map, astar );
 
       // Normalise the travel distance in meter
       // NOTE: assuming that the robot is moving at 0.5m/s and the resolution of the map is 0.5m per cell)
@@ -804,4 +798,58 @@ void Utilities::getEllipseSize(int X_max, int X_min, double *major_axis, double
   double focal_length = (X_max - X_min) / 2.0; // (X_max - X_min)/2
   *major_axis = focal_length + X_min;  // (focal_length + X_min)
   *minor_axis = sqrt(pow(*major_axis, 2) - pow(focal_length, 2));
-}
\ No newline at end of file
+}
+
+void Utilities::saveCheckpoint(Checkpoint *checkpoint, dummy::Map *map, NavigationGraph *graph2,
+                               vector<pair<PoseKey,int>> *history, list<Pose> *nearCandidates,
+                               Pose *target, Pose *previous, RFID_tools *rfid_tools, bool compress)
+{
+  map->saveState(checkpoint);
+  graph2->save(checkpoint, "graph");
+  vector<uint64_t> historyKeys, candidateKeys;
+  vector<int> historyFlags;
+  for (int i = 0; i < history->size(); i++){
+    historyKeys.push_back((*history)[i].first.getBits());
+    historyFlags.push_back((*history)[i].second);
+  }
+  for (list<Pose>::iterator it = nearCandidates->begin(); it != nearCandidates->end(); it++)
+    candidateKeys.push_back(PoseKey(*it).getBits());
+  checkpoint->putVector("history.keys", historyKeys);
+  checkpoint->putVector("history.flags", historyFlags);
+  checkpoint->putVector("nearCandidates", candidateKeys);
+  checkpoint->putValue("target", PoseKey(*target).getBits());
+  checkpoint->putValue("previous", PoseKey(*previous).getBits());
+  for (int i = 0; i < rfid_tools->RFID_maps_list->size(); i++){
+    (*rfid_tools->RFID_maps_list)[i].save(checkpoint, "rfid." + to_string(i));
+  }
+  rfid_tools->rm->saveBeliefs(checkpoint, compress);
+}
+
+bool Utilities::restoreCheckpoint(const Checkpoint &checkpoint, dummy::Map *map, NavigationGraph *graph2,
+                                  vector<pair<PoseKey,int>> *history, list<Pose> *nearCandidates,
+                                  Pose *target, Pose *previous, RFID_tools *rfid_tools)
+{
+  vector<uint64_t> historyKeys, candidateKeys;
+  vector<int> historyFlags;
+  uint64_t targetKey, previousKey;
+  if (!checkpoint.getVector("history.keys", &historyKeys) || !checkpoint.getVector("history.flags", &historyFlags)
+      || historyKeys.size() != historyFlags.size() || !checkpoint.getVector("nearCandidates", &candidateKeys)
+      || !checkpoint.getValue("target", &targetKey) || !checkpoint.getValue("previous", &previousKey))
+    return false;
+  if (!map->restoreState(checkpoint) || !graph2->restore(checkpoint, "graph")) return false;
+  for (int i = 0; i < rfid_tools->RFID_maps_list->size(); i++){
+    if (!(*rfid_tools->RFID_maps_list)[i].restore(checkpoint, "rfid." + to_string(i))) return false;
+  }
+  if (!rfid_tools->rm->restoreBeliefs(checkpoint)) return false;
+  history->clear();
+  for (int i = 0; i < historyKeys.size(); i++){
+    history->push_back(make_pair(PoseKey::fromBits(historyKeys[i]), historyFlags[i]));
+  }
+  nearCandidates->clear();
+  for (int i = 0; i < candidateKeys.size(); i++){
+    nearCandidates->push_back(PoseKey::fromBits(candidateKeys[i]).toPose());
+  }
+  *target = PoseKey::fromBits(targetKey).toPose();
+  *previous = PoseKey::fromBits(previousKey).toPose();
+  return true;
+}